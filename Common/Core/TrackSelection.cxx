@@ -18,25 +18,22 @@
 #include <Framework/DataTypes.h>
 #include <Framework/Logger.h>
 
-#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <set>
 #include <string>
 #include <utility>
 
-bool TrackSelection::FulfillsITSHitRequirements(uint8_t itsClusterMap) const
-{
-  constexpr uint8_t bit = 1;
-  for (auto& itsRequirement : mRequiredITSHits) {
-    auto hits = std::count_if(itsRequirement.second.begin(), itsRequirement.second.end(), [&](auto&& requiredLayer) { return itsClusterMap & (bit << requiredLayer); });
-    if ((itsRequirement.first == -1) && (hits > 0)) {
-      return false; // no hits were required in specified layers
-    } else if (hits < itsRequirement.first) {
-      return false; // not enough hits found in specified layers
+// mask of the given ITS layers in the ITS cluster map
+uint8_t TrackSelection::GetITSLayersMask(std::set<uint8_t> const& layers)
+{
+  uint8_t mask = 0;
+  for (const auto& layer : layers) {
+    if (layer < 8) {
+      mask |= 1 << layer;
     }
   }
-  return true;
+  return mask;
 }
 
 const std::string TrackSelection::mCutNames[static_cast<int>(TrackSelection::TrackCuts::kNCuts)] = {"TrackType", "PtRange", "EtaRange", "TPCNCls", "TPCCrossedRows", "TPCCrossedRowsOverNCls", "TPCChi2NDF", "TPCRefit", "ITSNCls", "ITSChi2NDF", "ITSRefit", "ITSHits", "GoldenChi2", "DCAxy", "DCAz", "TPCFracSharedCls"};
@@ -129,11 +126,13 @@ void TrackSelection::SetRequireHitsInITSLayers(int8_t minNRequiredHits, std::set
 {
   // layer 0 corresponds to the the innermost ITS layer
   mRequiredITSHits.push_back(std::make_pair(minNRequiredHits, requiredLayers));
+  mRequiredITSHitsMasks.push_back(std::make_pair(minNRequiredHits, GetITSLayersMask(requiredLayers)));
   LOG(info) << "Track selection, set require hits in ITS layers: " << static_cast<int>(minNRequiredHits);
 }
 void TrackSelection::SetRequireNoHitsInITSLayers(std::set<uint8_t> excludedLayers)
 {
   mRequiredITSHits.push_back(std::make_pair(-1, excludedLayers));
+  mRequiredITSHitsMasks.push_back(std::make_pair(-1, GetITSLayersMask(excludedLayers)));
   LOG(info) << "Track selection, set require no hits in ITS layers";
 }
 
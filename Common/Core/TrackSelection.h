@@ -20,7 +20,9 @@
 
 #include <Rtypes.h>
 
+#include <bit>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <set>
@@ -70,89 +72,47 @@ class TrackSelection
 
   static const std::string mCutNames[static_cast<int>(TrackCuts::kNCuts)];
 
+  // mask of a track passing all the cuts
+  static constexpr uint16_t kAllCutsMask = (1 << static_cast<int>(TrackCuts::kNCuts)) - 1;
+
   // Temporary function to check if track passes selection criteria. To be replaced by framework filters.
   template <typename T>
   bool IsSelected(T const& track) const
   {
-    if (!IsSelected(track, TrackCuts::kTrackType)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kPtRange)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kEtaRange)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCNCls)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCCrossedRows)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCCrossedRowsOverNCls)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCChi2NDF)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCRefit)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kITSNCls)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kITSChi2NDF)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kITSRefit)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kITSHits)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kGoldenChi2)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kDCAxy)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kDCAz)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCFracSharedCls)) {
-      return false;
-    }
-    return true;
+    return IsSelectedMask(track) == kAllCutsMask;
   }
 
   // Temporary function to check if track passes and return a flag. To be replaced by framework filters.
+  // Each column is read once and the cuts are combined without branches, the pT-dependent DCAxy cut being the only call.
   template <typename T>
   uint16_t IsSelectedMask(T const& track) const
   {
-    uint16_t flag = 0;
+    const auto trackType = track.trackType();
+    const bool isRun2 = trackType == o2::aod::track::Run2Track || trackType == o2::aod::track::Run2Tracklet;
+    const auto flags = track.flags();
+    const float pt = track.pt();
+    const float eta = track.eta();
+    const float maxDcaXY = mMaxDcaXYPtDep ? mMaxDcaXYPtDep(pt) : mMaxDcaXY;
+    const bool hasTPCRefit = isRun2 ? (flags & o2::aod::track::TPCrefit) != 0 : track.hasTPC();
+    const bool hasITSRefit = isRun2 ? (flags & o2::aod::track::ITSrefit) != 0 : track.hasITS();
 
-    auto setFlag = [&](const TrackCuts& cut) {
-      if (IsSelected(track, cut)) {
-        flag |= 1UL << static_cast<int>(cut);
-      }
-    };
-
-    setFlag(TrackCuts::kTrackType);
-    setFlag(TrackCuts::kPtRange);
-    setFlag(TrackCuts::kEtaRange);
-    setFlag(TrackCuts::kTPCNCls);
-    setFlag(TrackCuts::kTPCCrossedRows);
-    setFlag(TrackCuts::kTPCCrossedRowsOverNCls);
-    setFlag(TrackCuts::kTPCChi2NDF);
-    setFlag(TrackCuts::kTPCRefit);
-    setFlag(TrackCuts::kITSNCls);
-    setFlag(TrackCuts::kITSChi2NDF);
-    setFlag(TrackCuts::kITSRefit);
-    setFlag(TrackCuts::kITSHits);
-    setFlag(TrackCuts::kGoldenChi2);
-    setFlag(TrackCuts::kDCAxy);
-    setFlag(TrackCuts::kDCAz);
-    setFlag(TrackCuts::kTPCFracSharedCls);
+    uint16_t flag = 0;
+    flag |= cutFlag(TrackCuts::kTrackType, trackType == mTrackType);
+    flag |= cutFlag(TrackCuts::kPtRange, (pt >= mMinPt) & (pt <= mMaxPt));
+    flag |= cutFlag(TrackCuts::kEtaRange, (eta >= mMinEta) & (eta <= mMaxEta));
+    flag |= cutFlag(TrackCuts::kTPCNCls, track.tpcNClsFound() >= mMinNClustersTPC);
+    flag |= cutFlag(TrackCuts::kTPCCrossedRows, track.tpcNClsCrossedRows() >= mMinNCrossedRowsTPC);
+    flag |= cutFlag(TrackCuts::kTPCCrossedRowsOverNCls, track.tpcCrossedRowsOverFindableCls() >= mMinNCrossedRowsOverFindableClustersTPC);
+    flag |= cutFlag(TrackCuts::kTPCChi2NDF, track.tpcChi2NCl() <= mMaxChi2PerClusterTPC);
+    flag |= cutFlag(TrackCuts::kTPCRefit, !mRequireTPCRefit | hasTPCRefit);
+    flag |= cutFlag(TrackCuts::kITSNCls, track.itsNCls() >= mMinNClustersITS);
+    flag |= cutFlag(TrackCuts::kITSChi2NDF, track.itsChi2NCl() <= mMaxChi2PerClusterITS);
+    flag |= cutFlag(TrackCuts::kITSRefit, !mRequireITSRefit | hasITSRefit);
+    flag |= cutFlag(TrackCuts::kITSHits, FulfillsITSHitRequirements(track.itsClusterMap()));
+    flag |= cutFlag(TrackCuts::kGoldenChi2, !(isRun2 & mRequireGoldenChi2) | ((flags & o2::aod::track::GoldenChi2) != 0));
+    flag |= cutFlag(TrackCuts::kDCAxy, std::fabs(track.dcaXY()) <= maxDcaXY);
+    flag |= cutFlag(TrackCuts::kDCAz, std::fabs(track.dcaZ()) <= mMaxDcaZ);
+    flag |= cutFlag(TrackCuts::kTPCFracSharedCls, track.tpcFractionSharedCls() <= mMaxTPCFractionSharedCls);
 
     return flag;
   }
@@ -235,14 +195,35 @@ class TrackSelection
   void SetRequireHitsInITSLayers(int8_t minNRequiredHits, std::set<uint8_t> requiredLayers);
   void SetRequireNoHitsInITSLayers(std::set<uint8_t> excludedLayers);
   /// @brief Reset ITS requirements
-  void ResetITSRequirements() { mRequiredITSHits.clear(); }
+  void ResetITSRequirements()
+  {
+    mRequiredITSHits.clear();
+    mRequiredITSHitsMasks.clear();
+  }
   void SetMaxTPCFractionSharedCls(float maxTPCFractionSharedCls);
 
   /// @brief Print the track selection
   void print() const;
 
  private:
-  bool FulfillsITSHitRequirements(uint8_t itsClusterMap) const;
+  static constexpr uint16_t cutFlag(TrackCuts cut, bool isSelected) { return static_cast<uint16_t>(isSelected) << static_cast<int>(cut); }
+
+  static uint8_t GetITSLayersMask(std::set<uint8_t> const& layers);
+
+  bool FulfillsITSHitRequirements(uint8_t itsClusterMap) const
+  {
+    // objects written before the masks were stored (class version 1) only have the layer sets
+    const bool hasMasks = mRequiredITSHitsMasks.size() == mRequiredITSHits.size();
+    for (std::size_t i = 0; i < mRequiredITSHits.size(); i++) {
+      const int8_t minNRequiredHits = mRequiredITSHits[i].first;
+      const uint8_t layersMask = hasMasks ? mRequiredITSHitsMasks[i].second : GetITSLayersMask(mRequiredITSHits[i].second);
+      const int hits = std::popcount(static_cast<uint8_t>(itsClusterMap & layersMask));
+      if ((minNRequiredHits == -1) ? (hits > 0) : (hits < minNRequiredHits)) {
+        return false; // hits found in excluded layers, or not enough hits found in required layers
+      }
+    }
+    return true;
+  }
 
   o2::aod::track::TrackTypeEnum mTrackType{o2::aod::track::TrackTypeEnum::Track};
 
@@ -270,8 +251,10 @@ class TrackSelection
 
   // vector of ITS requirements (minNRequiredHits in specific requiredLayers)
   std::vector<std::pair<int8_t, std::set<uint8_t>>> mRequiredITSHits{};
+  // same requirements with the layers as a mask of the ITS cluster map
+  std::vector<std::pair<int8_t, uint8_t>> mRequiredITSHitsMasks{};
 
-  ClassDefNV(TrackSelection, 1);
+  ClassDefNV(TrackSelection, 2);
 };
 
 #endif // COMMON_CORE_TRACKSELECTION_H_
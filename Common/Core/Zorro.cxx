@@ -16,8 +16,6 @@
 
 #include <CCDB/BasicCCDBManager.h>
 #include <CommonConstants/LHCConstants.h>
-#include <CommonDataFormat/IRFrame.h>
-#include <CommonDataFormat/InteractionRecord.h>
 #include <CommonUtils/StringUtils.h>
 #include <Framework/HistogramRegistry.h>
 #include <Framework/HistogramSpec.h>
@@ -35,11 +33,10 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
-using o2::InteractionRecord;
-
 namespace
 {
 int findBin(TH1* hist, const std::string& label)
@@ -191,8 +188,6 @@ std::vector<int> Zorro::initCCDB(o2::ccdb::BasicCCDBManager* ccdb, int runNumber
   mSelections = mCCDB->getForRun<TH1D>(mBaseCCDBPath + "SelectionCounters", runNumber, true);
   mInspectedTVX = mCCDB->getForRun<TH1D>(mBaseCCDBPath + "InspectedTVX", runNumber, true);
   setupHelpers(timestamp);
-  mLastBCglobalId = 0;
-  mLastSelectedIdx = 0;
   mTOIs.clear();
   mTOIidx.clear();
   std::vector<std::string> tokens = o2::utils::Str::tokenize(tois, ','); // tokens are trimmed
@@ -219,64 +214,123 @@ std::vector<int> Zorro::initCCDB(o2::ccdb::BasicCCDBManager* ccdb, int runNumber
 
 std::bitset<128> Zorro::fetch(uint64_t bcGlobalId, uint64_t tolerance)
 {
-  mLastResult.reset();
-  if (bcGlobalId < mBCranges.front().getMin().toLong() - tolerance || bcGlobalId > mBCranges.back().getMax().toLong() + tolerance) {
+  if (bcGlobalId < mBCrangesStart.front() - tolerance || bcGlobalId > mBCrangesEnd.back() + tolerance) {
     setupHelpers((mOrbitResetTimestamp + static_cast<int64_t>(bcGlobalId * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000);
   }
 
-  o2::dataformats::IRFrame bcFrame{InteractionRecord::long2IR(bcGlobalId) - tolerance, InteractionRecord::long2IR(bcGlobalId) + tolerance};
-  if (bcGlobalId < mLastBCglobalId) { /// Handle the possible discontinuity in the BC processed by the analyses
-    mLastSelectedIdx = 0;
+  const uint64_t bcMin = bcGlobalId > tolerance ? bcGlobalId - tolerance : 0;
+  const uint64_t bcMax = bcGlobalId + tolerance;
+  /// The ranges overlapping [bcMin, bcMax] start at most at bcMax and come after the last range ending before bcMin
+  const size_t first = std::lower_bound(mBCrangesMaxEnd.begin(), mBCrangesMaxEnd.end(), bcMin) - mBCrangesMaxEnd.begin();
+  const size_t last = std::upper_bound(mBCrangesStart.begin(), mBCrangesStart.end(), bcMax) - mBCrangesStart.begin();
+  accumulateBCranges(first, last, bcMin);
+  return mLastResult;
+}
+
+void Zorro::fetchBatch(const std::vector<uint64_t>& bcGlobalIds, std::vector<std::bitset<128>>& results, uint64_t tolerance)
+{
+  results.assign(bcGlobalIds.size(), {});
+  /// Process the BCs in increasing order, so that the overlapping ranges are found with a single sweep
+  std::vector<size_t> order(bcGlobalIds.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&bcGlobalIds](size_t a, size_t b) { return bcGlobalIds[a] < bcGlobalIds[b]; });
+  size_t first{0}, last{0};
+  for (const auto iBC : order) {
+    const uint64_t bcGlobalId = bcGlobalIds[iBC];
+    if (bcGlobalId < mBCrangesStart.front() - tolerance || bcGlobalId > mBCrangesEnd.back() + tolerance) {
+      if (setupHelpers((mOrbitResetTimestamp + static_cast<int64_t>(bcGlobalId * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000)) {
+        first = last = 0;
+      }
+    }
+    const uint64_t bcMin = bcGlobalId > tolerance ? bcGlobalId - tolerance : 0;
+    const uint64_t bcMax = bcGlobalId + tolerance;
+    while (first < mBCrangesMaxEnd.size() && mBCrangesMaxEnd[first] < bcMin) {
+      ++first;
+    }
+    last = std::max(last, first);
+    while (last < mBCrangesStart.size() && mBCrangesStart[last] <= bcMax) {
+      ++last;
+    }
+    accumulateBCranges(first, last, bcMin);
+    results[iBC] = mLastResult;
   }
-  uint64_t lastSelectedIdx = mLastSelectedIdx;
-  mLastBCglobalId = bcGlobalId;
-  for (size_t i = mLastSelectedIdx; i < mBCranges.size(); i++) {
-    if (!mBCranges[i].isOutside(bcFrame)) {
-      for (int iMask{0}; iMask < 2; ++iMask) {
-        for (int iTOI{0}; iTOI < 64; ++iTOI) {
-          if (mZorroHelpers->at(i).selMask[iMask] & (1ull << iTOI)) {
-            mLastResult.set(iMask * 64 + iTOI, 1);
-            if (!mAccountedBCranges[i]) {
-              mATcounts[iMask * 64 + iTOI]++;
-              if (mAnalysedTriggers) {
-                mAnalysedTriggers->Fill(iMask * 64 + iTOI);
-              }
-            }
-          }
+}
+
+void Zorro::accumulateBCranges(size_t first, size_t last, uint64_t bcMin)
+{
+  mLastResult.reset();
+  mLastNewResult.reset();
+  for (size_t i{first}; i < last; ++i) {
+    if (mBCrangesEnd[i] < bcMin) { /// Range contained in an earlier, longer one
+      continue;
+    }
+    mLastResult |= mBCrangesMask[i];
+    if (mAccountedBCranges[i]) {
+      continue;
+    }
+    mAccountedBCranges[i] = true;
+    mLastNewResult |= mBCrangesMask[i];
+    for (size_t iTrigger{0}; iTrigger < mBCrangesMask[i].size(); ++iTrigger) {
+      if (mBCrangesMask[i].test(iTrigger)) {
+        mATcounts[iTrigger]++;
+        if (mAnalysedTriggers) {
+          mAnalysedTriggers->Fill(iTrigger);
         }
       }
-      mAccountedBCranges[i] = true;
-      mLastSelectedIdx = mLastSelectedIdx == lastSelectedIdx-- ? i : mLastSelectedIdx; /// Decrease lastSelectedIdx to make sure this check is valid only in its first instance
-    } else if (mBCranges[i].getMax() < bcFrame.getMin()) {
-      mLastSelectedIdx = i;
-    } else if (mBCranges[i].getMin() > bcFrame.getMax()) {
-      break;
     }
   }
-  return mLastResult;
+}
+
+void Zorro::setupToiHistoBins(TH2* toiHisto)
+{
+  if (toiHisto == mToiHisto && mAnalysedTriggers == mToiHistoAnalysedTriggers && mRunNumber == mToiHistoRunNumber) {
+    return;
+  }
+  mToiHisto = toiHisto;
+  mToiHistoAnalysedTriggers = mAnalysedTriggers;
+  mToiHistoRunNumber = mRunNumber;
+  mToiHistoBinX = -1;
+  mToiHistoBinsY.assign(mTOIs.size(), -1);
+  mToiHistoBinsYAnalysed.assign(mTOIs.size(), -1);
+  mAnalysedTriggersBins.assign(mTOIs.size(), -1);
 }
 
 bool Zorro::isSelected(uint64_t bcGlobalId, uint64_t tolerance, TH2* ToiHisto)
 {
-  uint64_t lastSelectedIdx = mLastSelectedIdx;
   fetch(bcGlobalId, tolerance);
+  if (ToiHisto) {
+    setupToiHistoBins(ToiHisto);
+  }
   bool retVal{false};
   for (size_t i{0}; i < mTOIidx.size(); ++i) {
     if (mTOIidx[i] < 0) {
       continue;
     } else if (mLastResult.test(mTOIidx[i])) {
+      /// Count each trigger of interest once, at the first selected event of each BC range
+      const bool isNewTrigger = mLastNewResult.test(mTOIidx[i]);
+      if (ToiHisto && mToiHistoBinX < 0) {
+        mToiHistoBinX = ToiHisto->GetXaxis()->FindBin(Form("%d", mRunNumber));
+      }
       if (ToiHisto && mAnalysedTriggers) {
-        int binX = ToiHisto->GetXaxis()->FindBin(Form("%d", mRunNumber));
-        int binY = ToiHisto->GetYaxis()->FindBin(Form("%s AnalysedTriggers", mTOIs[i].data()));
-        ToiHisto->SetBinContent(binX, binY, mAnalysedTriggers->GetBinContent(mAnalysedTriggers->GetXaxis()->FindBin(mTOIs[i].data())));
+        if (mToiHistoBinsYAnalysed[i] < 0) {
+          mToiHistoBinsYAnalysed[i] = ToiHisto->GetYaxis()->FindBin(Form("%s AnalysedTriggers", mTOIs[i].data()));
+          mAnalysedTriggersBins[i] = mAnalysedTriggers->GetXaxis()->FindBin(mTOIs[i].data());
+        }
+        ToiHisto->SetBinContent(mToiHistoBinX, mToiHistoBinsYAnalysed[i], mAnalysedTriggers->GetBinContent(mAnalysedTriggersBins[i]));
       }
-      mTOIcounts[i] += (lastSelectedIdx != mLastSelectedIdx); /// Avoid double counting
-      if (mAnalysedTriggersOfInterest && lastSelectedIdx != mLastSelectedIdx) {
+      mTOIcounts[i] += isNewTrigger; /// Avoid double counting
+      if (mAnalysedTriggersOfInterest && isNewTrigger) {
         mAnalysedTriggersOfInterest->Fill(i);
         mZorroSummary.increaseTOIcounter(mRunNumber, i);
       }
-      if (ToiHisto && lastSelectedIdx != mLastSelectedIdx) {
-        ToiHisto->Fill(Form("%d", mRunNumber), Form("%s", mTOIs[i].data()), 1);
+      if (ToiHisto && isNewTrigger) {
+        if (mToiHistoBinsY[i] < 0) {
+          mToiHistoBinsY[i] = ToiHisto->GetYaxis()->FindBin(mTOIs[i].data());
+        }
+        /// FindBin returns -1 for labels which cannot be added: skip the fill, as Fill(label, label) does
+        if (mToiHistoBinX >= 0 && mToiHistoBinsY[i] >= 0) {
+          ToiHisto->Fill(ToiHisto->GetXaxis()->GetBinCenter(mToiHistoBinX), ToiHisto->GetYaxis()->GetBinCenter(mToiHistoBinsY[i]));
+        }
       }
       retVal = true;
     }
@@ -309,17 +363,27 @@ bool Zorro::isNotSelectedByAny(uint64_t bcGlobalId, uint64_t tolerance)
   return mLastResult.none();
 }
 
-void Zorro::setupHelpers(int64_t timestamp)
+bool Zorro::setupHelpers(int64_t timestamp)
 {
   if (mCCDB->isCachedObjectValid(mBaseCCDBPath + "ZorroHelpers", timestamp)) {
-    return;
+    return false;
   }
   mZorroHelpers = mCCDB->getSpecific<std::vector<ZorroHelper>>(mBaseCCDBPath + "ZorroHelpers", timestamp, {{"runNumber", std::to_string(mRunNumber)}});
   std::sort(mZorroHelpers->begin(), mZorroHelpers->end(), [](const auto& a, const auto& b) { return std::min(a.bcAOD, a.bcEvSel) < std::min(b.bcAOD, b.bcEvSel); });
-  mBCranges.clear();
+  mBCrangesStart.clear();
+  mBCrangesEnd.clear();
+  mBCrangesMaxEnd.clear();
+  mBCrangesMask.clear();
   mAccountedBCranges.clear();
   for (const auto& helper : *mZorroHelpers) {
-    mBCranges.emplace_back(InteractionRecord::long2IR(std::min(helper.bcAOD, helper.bcEvSel)), InteractionRecord::long2IR(std::max(helper.bcAOD, helper.bcEvSel)));
+    mBCrangesStart.push_back(std::min(helper.bcAOD, helper.bcEvSel));
+    mBCrangesEnd.push_back(std::max(helper.bcAOD, helper.bcEvSel));
+    mBCrangesMaxEnd.push_back(mBCrangesMaxEnd.empty() ? mBCrangesEnd.back() : std::max(mBCrangesMaxEnd.back(), mBCrangesEnd.back()));
+    std::bitset<128> mask{helper.selMask[1]};
+    mask <<= 64;
+    mask |= std::bitset<128>{helper.selMask[0]};
+    mBCrangesMask.push_back(mask);
   }
-  mAccountedBCranges.resize(mBCranges.size(), false);
+  mAccountedBCranges.resize(mBCrangesStart.size(), false);
+  return true;
 }
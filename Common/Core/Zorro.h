@@ -22,13 +22,13 @@
 #include "ZorroHelper.h"
 #include "ZorroSummary.h"
 
-#include <CommonDataFormat/IRFrame.h>
 #include <Framework/HistogramRegistry.h>
 
 #include <TH1.h>
 #include <TH2.h>
 
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <utility>
@@ -48,6 +48,17 @@ class Zorro
   Zorro() = default;
   std::vector<int> initCCDB(o2::ccdb::BasicCCDBManager* ccdb, int runNumber, uint64_t timestamp, std::string tois, int bcTolerance = 500);
   std::bitset<128> fetch(uint64_t bcGlobalId, uint64_t tolerance = 100);
+  void fetchBatch(const std::vector<uint64_t>& bcGlobalIds, std::vector<std::bitset<128>>& results, uint64_t tolerance = 100);
+  template <typename TBCs>
+  void fetchBatch(const TBCs& bcs, std::vector<std::bitset<128>>& results, uint64_t tolerance = 100)
+  {
+    std::vector<uint64_t> bcGlobalIds;
+    bcGlobalIds.reserve(bcs.size());
+    for (const auto& bc : bcs) {
+      bcGlobalIds.push_back(bc.globalBC());
+    }
+    fetchBatch(bcGlobalIds, results, tolerance);
+  }
   bool isSelected(uint64_t bcGlobalId, uint64_t tolerance = 100, TH2* toiHisto = nullptr);
   bool isNotSelectedByAny(uint64_t bcGlobalId, uint64_t tolerance = 100);
 
@@ -71,7 +82,9 @@ class Zorro
   ZorroSummary* getZorroSummary() { return &mZorroSummary; }
 
  private:
-  void setupHelpers(int64_t timestamp);
+  bool setupHelpers(int64_t timestamp);
+  void accumulateBCranges(size_t first, size_t last, uint64_t bcMin);
+  void setupToiHistoBins(TH2* toiHisto);
 
   ZorroSummary mZorroSummary{"ZorroSummary", "ZorroSummary"};
 
@@ -87,14 +100,28 @@ class Zorro
   std::vector<TH1*> mAnalysedTriggersOfInterestList; /// Per run histograms
 
   int mBCtolerance = 100;
-  uint64_t mLastBCglobalId = 0;
-  uint64_t mLastSelectedIdx = 0;
   TH1D* mScalers = nullptr;
   TH1D* mSelections = nullptr;
   TH1D* mInspectedTVX = nullptr;
   std::bitset<128> mLastResult;
+  std::bitset<128> mLastNewResult;      /// Triggers of the last result from BC ranges not inspected before
   std::vector<bool> mAccountedBCranges; /// Avoid double accounting of inspected BC ranges
-  std::vector<o2::dataformats::IRFrame> mBCranges;
+
+  /// BC ranges sorted by start, with a running maximum of the end for the binary search of the ranges overlapping a BC
+  std::vector<uint64_t> mBCrangesStart;
+  std::vector<uint64_t> mBCrangesEnd;
+  std::vector<uint64_t> mBCrangesMaxEnd;
+  std::vector<std::bitset<128>> mBCrangesMask;
+
+  /// Bins of the TOI histogram passed to isSelected, cached per run (-1 if not looked up yet)
+  TH2* mToiHisto = nullptr;
+  TH1* mToiHistoAnalysedTriggers = nullptr;
+  int mToiHistoRunNumber = 0;
+  int mToiHistoBinX = -1;
+  std::vector<int> mToiHistoBinsY;
+  std::vector<int> mToiHistoBinsYAnalysed;
+  std::vector<int> mAnalysedTriggersBins;
+
   std::vector<ZorroHelper>* mZorroHelpers = nullptr;
   std::vector<std::string> mTOIs;
   std::vector<int> mTOIidx;
@@ -47,6 +47,7 @@
 #include <RtypesCore.h>
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cmath>
 #include <cstdint>
@@ -165,6 +166,10 @@ class BcSelectionModule
   TriggerAliases* aliases = nullptr;
   EventSelectionParams* par = nullptr;
   std::map<uint64_t, uint32_t>* mapRCT = nullptr;
+  int lastRunRun2 = -1;                              // run of the Run 2 parameters and alias masks below (fetched once per run)
+  std::array<uint64_t, 32> aliasTriggerMask{};       // Run 2 trigger classes of each alias bit, flattened from the TriggerAliases maps
+  std::array<uint64_t, 32> aliasTriggerMaskNext50{}; // same for the next 50 trigger classes
+
   std::map<int64_t, std::vector<int16_t>> mapInactiveChips; // number of inactive chips vs orbit per layer
   int64_t prevOrbitForInactiveChips = 0;                    // cached next stored orbit in the inactive chip map
   int64_t nextOrbitForInactiveChips = 0;                    // cached previous stored orbit in the inactive chip map
@@ -311,22 +316,31 @@ class BcSelectionModule
     }
     bcselbuffer.clear();
     for (const auto& bc : bcs) {
-      uint64_t timestamp = timestamps[bc.globalIndex()];
-      par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
-      aliases = ccdb->template getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", timestamp);
+      if (bc.runNumber() != lastRunRun2) {
+        lastRunRun2 = bc.runNumber();
+        uint64_t timestamp = timestamps[bc.globalIndex()];
+        par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+        aliases = ccdb->template getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", timestamp);
+        // flatten the alias -> trigger mask maps, aliases beyond the 32 bits of the alias word are never set
+        aliasTriggerMask.fill(0);
+        aliasTriggerMaskNext50.fill(0);
+        for (const auto& al : aliases->GetAliasToTriggerMaskMap()) {
+          if (al.first < aliasTriggerMask.size()) {
+            aliasTriggerMask[al.first] |= al.second;
+          }
+        }
+        for (const auto& al : aliases->GetAliasToTriggerMaskNext50Map()) {
+          if (al.first < aliasTriggerMaskNext50.size()) {
+            aliasTriggerMaskNext50[al.first] |= al.second;
+          }
+        }
+      }
       // fill fired aliases
       uint32_t alias{0};
       uint64_t triggerMask = bc.triggerMask();
-      for (const auto& al : aliases->GetAliasToTriggerMaskMap()) {
-        if (triggerMask & al.second) {
-          alias |= BIT(al.first);
-        }
-      }
       uint64_t triggerMaskNext50 = bc.triggerMaskNext50();
-      for (const auto& al : aliases->GetAliasToTriggerMaskNext50Map()) {
-        if (triggerMaskNext50 & al.second) {
-          alias |= BIT(al.first);
-        }
+      for (uint32_t i = 0; i < aliasTriggerMask.size(); i++) {
+        alias |= ((triggerMask & aliasTriggerMask[i]) | (triggerMaskNext50 & aliasTriggerMaskNext50[i])) ? BIT(i) : 0;
       }
       alias |= BIT(kALL);
 
@@ -639,6 +653,9 @@ class EventSelectionModule
   std::bitset<nBCsPerOrbit> bcPatternB; // bc pattern of colliding bunches
   std::vector<int> bcsPattern;          // pattern of colliding BCs
 
+  int lastRunRun2 = -1;                    // run of parRun2 (needed to access ccdb only if run!=lastRunRun2)
+  EventSelectionParams* parRun2 = nullptr; // Run 2 event selection parameters of lastRunRun2
+
   int64_t bcSOR = -1;                   // global bc of the start of the first orbit
   int64_t nBCsPerTF = -1;               // duration of TF in bcs, should be 128*3564 or 32*3564
   int rofOffset = -1;                   // ITS ROF offset, in bc
@@ -825,8 +842,12 @@ class EventSelectionModule
     }
     for (const auto& col : collisions) {
       auto bc = col.template bc_as<soa::Join<aod::BCs, aod::Run2BCInfos, aod::Run2MatchedToBCSparse>>();
-      uint64_t timestamp = timestamps[bc.globalIndex()];
-      EventSelectionParams* par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+      if (bc.runNumber() != lastRunRun2) {
+        lastRunRun2 = bc.runNumber();
+        uint64_t timestamp = timestamps[bc.globalIndex()];
+        parRun2 = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+      }
+      EventSelectionParams* par = parRun2;
       bool* applySelection = par->getSelection(evselOpts.muonSelection);
       if (evselOpts.isMC == 1) {
         applySelection[aod::evsel::kIsBBZAC] = 0;
@@ -1187,10 +1208,15 @@ class EventSelectionModule
     }
 
     // save indices of collisions for occupancy calculation (both in ROF and in time range)
-    std::vector<std::vector<int>> vCollsInSameITSROF;
-    std::vector<std::vector<int>> vCollsInPrevITSROF;
-    std::vector<std::vector<int>> vCollsInTimeWin;
-    std::vector<std::vector<float>> vTimeDeltaForColls; // delta time wrt a given collision
+    // the collisions in the same ITS ROF and in the time window of a given collision are contiguous ranges of collision indices around it,
+    // those in the previous ROF are stored in flat arrays: vCollsInPrevITSROF[vOffsetCollsInPrevITSROF[colIndex]...vOffsetCollsInPrevITSROF[colIndex + 1] - 1]
+    std::vector<int> vFirstCollInSameITSROF(cols.size(), 0);
+    std::vector<int> vLastCollInSameITSROF(cols.size(), 0);
+    std::vector<int> vOffsetCollsInPrevITSROF(cols.size() + 1, 0);
+    std::vector<int> vCollsInPrevITSROF;
+    std::vector<int> vFirstCollInTimeWin(cols.size(), 0);
+    std::vector<int> vLastCollInTimeWin(cols.size(), 0);
+    std::vector<std::pair<float, float>> pairsDeltaTimeMult; // (delta time wrt a given collision, mult), for the median time calc
     for (const auto& col : cols) {
       int32_t colIndex = col.globalIndex();
       int64_t foundGlobalBC = vFoundGlobalBC[colIndex];
@@ -1205,7 +1231,6 @@ class EventSelectionModule
       int64_t rofId = (foundGlobalBC + nBCsPerOrbit - rofOffset) / rofLength;
 
       // ### for in-ROF occupancy
-      std::vector<int> vAssocCollInSameROF;
       // find all collisions in the same ROF before a given collision
       int32_t minColIndex = colIndex - 1;
       while (minColIndex >= 0) {
@@ -1220,9 +1245,9 @@ class EventSelectionModule
         // check if we are within the same ROF
         if (thisRofId != rofId)
           break;
-        vAssocCollInSameROF.push_back(minColIndex);
         minColIndex--;
       }
+      vFirstCollInSameITSROF[colIndex] = minColIndex + 1;
       // find all collisions in the same ROF after the current one
       int32_t maxColIndex = colIndex + 1;
       while (maxColIndex < cols.size()) {
@@ -1233,13 +1258,11 @@ class EventSelectionModule
         int64_t thisRofId = (thisBC + nBCsPerOrbit - rofOffset) / rofLength;
         if (thisRofId != rofId)
           break;
-        vAssocCollInSameROF.push_back(maxColIndex);
         maxColIndex++;
       }
-      vCollsInSameITSROF.push_back(vAssocCollInSameROF);
+      vLastCollInSameITSROF[colIndex] = maxColIndex - 1;
 
       // ### bookkeep collisions in previous ROF
-      std::vector<int> vAssocCollInPrevROF;
       minColIndex = colIndex - 1;
       while (minColIndex >= 0) {
         int64_t thisBC = vFoundGlobalBC[minColIndex];
@@ -1249,18 +1272,17 @@ class EventSelectionModule
           break;
         int64_t thisRofId = (thisBC + nBCsPerOrbit - rofOffset) / rofLength;
         if (thisRofId == rofId - 1)
-          vAssocCollInPrevROF.push_back(minColIndex);
+          vCollsInPrevITSROF.push_back(minColIndex);
         else if (thisRofId < rofId - 1)
           break;
         minColIndex--;
       }
-      vCollsInPrevITSROF.push_back(vAssocCollInPrevROF);
+      vOffsetCollsInPrevITSROF[colIndex + 1] = vCollsInPrevITSROF.size();
 
       // ### for occupancy in time windows
-      std::vector<int> vAssocToThisCol;
-      std::vector<float> vCollsTimeDeltaWrtGivenColl;
-      std::vector<float> vProxyNtracksAssocColls; // mult of associated collisions, for the median time calc
       // find all collisions in time window before the current one
+      pairsDeltaTimeMult.clear();
+      int proxyTotalMultInTimeWin = 0;
       minColIndex = colIndex - 1;
       while (minColIndex >= 0) {
         int64_t thisBC = vFoundGlobalBC[minColIndex];
@@ -1272,11 +1294,11 @@ class EventSelectionModule
         // check if we are within the chosen time range
         if (dt < timeWinOccupancyCalcMinNS)
           break;
-        vAssocToThisCol.push_back(minColIndex);
-        vCollsTimeDeltaWrtGivenColl.push_back(dt);
-        vProxyNtracksAssocColls.push_back(vProxyForCollNtracks[minColIndex]);
+        pairsDeltaTimeMult.emplace_back(dt, vProxyForCollNtracks[minColIndex]);
+        proxyTotalMultInTimeWin = static_cast<int>(proxyTotalMultInTimeWin + static_cast<float>(vProxyForCollNtracks[minColIndex]));
         minColIndex--;
       }
+      vFirstCollInTimeWin[colIndex] = minColIndex + 1;
       // find all collisions in time window after the current one
       maxColIndex = colIndex + 1;
       while (maxColIndex < cols.size()) {
@@ -1287,35 +1309,35 @@ class EventSelectionModule
         float dt = (thisBC - foundGlobalBC) * bcNS; // ns
         if (dt > timeWinOccupancyCalcMaxNS)
           break;
-        vAssocToThisCol.push_back(maxColIndex);
-        vCollsTimeDeltaWrtGivenColl.push_back(dt);
-        vProxyNtracksAssocColls.push_back(vProxyForCollNtracks[maxColIndex]);
+        pairsDeltaTimeMult.emplace_back(dt, vProxyForCollNtracks[maxColIndex]);
+        proxyTotalMultInTimeWin = static_cast<int>(proxyTotalMultInTimeWin + static_cast<float>(vProxyForCollNtracks[maxColIndex]));
         maxColIndex++;
       }
-      vCollsInTimeWin.push_back(vAssocToThisCol);
-      vTimeDeltaForColls.push_back(vCollsTimeDeltaWrtGivenColl);
+      vLastCollInTimeWin[colIndex] = maxColIndex - 1;
 
       // calculation of the median time for the occupancy in a given time window
-      std::vector<std::pair<float, float>> pairsDeltaTimeMult;
-      for (size_t iCol = 0; iCol < vCollsTimeDeltaWrtGivenColl.size(); iCol++)
-        pairsDeltaTimeMult.emplace_back(vCollsTimeDeltaWrtGivenColl[iCol], vProxyNtracksAssocColls[iCol]);
       std::sort(pairsDeltaTimeMult.begin(), pairsDeltaTimeMult.end()); // sorts by first element by default
-      int proxyTotalMultInTimeWin = std::accumulate(vProxyNtracksAssocColls.begin(), vProxyNtracksAssocColls.end(), 0);
 
       float sumMult = 0.0;
-      for (size_t iCol = 0; iCol < vCollsTimeDeltaWrtGivenColl.size(); iCol++) {
+      for (size_t iCol = 0; iCol < pairsDeltaTimeMult.size(); iCol++) {
         sumMult += pairsDeltaTimeMult[iCol].second;
         if (sumMult > proxyTotalMultInTimeWin / 2.0) {
           vMedianTimeForOccupancy[colIndex] = pairsDeltaTimeMult[iCol].first / 1e3; // ns -> us
           break;
         }
       }
-      for (size_t iCol = 0; iCol < vCollsTimeDeltaWrtGivenColl.size(); iCol++) {
+      for (size_t iCol = 0; iCol < pairsDeltaTimeMult.size(); iCol++) {
         LOGP(debug, "dt={} mult={}", pairsDeltaTimeMult[iCol].first, pairsDeltaTimeMult[iCol].second);
       }
       LOGP(debug, "   --> median time = {}", vMedianTimeForOccupancy[colIndex]);
     }
 
+    // prefix sums of the ITS tracks of the collisions, for the in-ROF occupancy
+    std::vector<int64_t> vSumTracksITS567upToColl(cols.size() + 1, 0);
+    for (size_t iCol = 0; iCol < cols.size(); iCol++) {
+      vSumTracksITS567upToColl[iCol + 1] = vSumTracksITS567upToColl[iCol] + vTracksITS567perColl[iCol];
+    }
+
     // perform the occupancy calculation per ITS ROF and also in the pre-defined time window
     std::vector<int> vNumTracksITS567inFullTimeWin(cols.size(), 0); // counter of tracks in full time window for occupancy studies (excluding given event)
     std::vector<float> vSumAmpFT0CinFullTimeWin(cols.size(), 0);    // sum of FT0C of tracks in full time window for occupancy studies (excluding given event)
@@ -1334,13 +1356,15 @@ class EventSelectionModule
       float vZ = col.posZ();
 
       // ### in-ROF occupancy
-      std::vector<int> vAssocCollInSameROF = vCollsInSameITSROF[colIndex];
-      int nITS567tracksForSameRofVetoStrict = 0;    // to veto events with other collisions in the same ITS ROF
+      int firstCollInSameROF = vFirstCollInSameITSROF[colIndex];
+      int lastCollInSameROF = vLastCollInSameITSROF[colIndex];
+      // to veto events with other collisions in the same ITS ROF
+      int nITS567tracksForSameRofVetoStrict = vSumTracksITS567upToColl[lastCollInSameROF + 1] - vSumTracksITS567upToColl[firstCollInSameROF] - vTracksITS567perColl[colIndex];
       int nCollsInRofWithFT0CAboveVetoStandard = 0; // to veto events with other collisions in the same ITS ROF, with per-collision multiplicity above threshold
       int nITS567tracksForRofVetoOnCloseVz = 0;     // to veto events with nearby collisions with close vZ
-      for (uint32_t iCol = 0; iCol < vAssocCollInSameROF.size(); iCol++) {
-        int thisColIndex = vAssocCollInSameROF[iCol];
-        nITS567tracksForSameRofVetoStrict += vTracksITS567perColl[thisColIndex];
+      for (int thisColIndex = firstCollInSameROF; thisColIndex <= lastCollInSameROF; thisColIndex++) {
+        if (thisColIndex == colIndex)
+          continue;
         if (vAmpFT0CperColl[thisColIndex] > evselOpts.confFT0CamplCutVetoOnCollInROF)
           nCollsInRofWithFT0CAboveVetoStandard++;
         if (std::fabs(vCollVz[thisColIndex] - vZ) < evselOpts.confEpsilonVzDiffVetoInROF)
@@ -1352,27 +1376,28 @@ class EventSelectionModule
       vNoCollInSameRofWithCloseVz[colIndex] = (nITS567tracksForRofVetoOnCloseVz == 0);
 
       // ### occupancy in previous ROF
-      std::vector<int> vAssocCollInPrevROF = vCollsInPrevITSROF[colIndex];
       float totalFT0amplInPrevROF = 0;
-      for (uint32_t iCol = 0; iCol < vAssocCollInPrevROF.size(); iCol++) {
-        int thisColIndex = vAssocCollInPrevROF[iCol];
+      for (int iCol = vOffsetCollsInPrevITSROF[colIndex]; iCol < vOffsetCollsInPrevITSROF[colIndex + 1]; iCol++) {
+        int thisColIndex = vCollsInPrevITSROF[iCol];
         totalFT0amplInPrevROF += vAmpFT0CperColl[thisColIndex];
       }
       // veto events if FT0C amplitude in previous ITS ROF is above threshold
       vNoHighMultCollInPrevRof[colIndex] = (totalFT0amplInPrevROF < evselOpts.confFT0CamplCutVetoOnCollInROF);
 
       // ### occupancy in time windows
-      std::vector<int> vAssocToThisCol = vCollsInTimeWin[colIndex];
-      std::vector<float> vCollsTimeDeltaWrtGivenColl = vTimeDeltaForColls[colIndex];
       int nITS567tracksInFullTimeWindow = 0;
       float sumAmpFT0CInFullTimeWindow = 0;
       int nITS567tracksForVetoNarrow = 0;      // to veto events with nearby collisions (narrow range) with per-collision multiplicity above threshold
       int nITS567tracksForVetoStrict = 0;      // to veto events with nearby collisions
       int nCollsWithFT0CAboveVetoStandard = 0; // to veto events with nearby collisions that have per-collision multiplicity above threshold
       int colIndexFirstRejectedByTFborderCut = -1;
-      for (uint32_t iCol = 0; iCol < vAssocToThisCol.size(); iCol++) {
-        int thisColIndex = vAssocToThisCol[iCol];
-        float dt = vCollsTimeDeltaWrtGivenColl[iCol] / 1e3; // ns -> us
+      // collisions in the time window, first before the current one (going back in time) and then after it
+      int nCollsBeforeInTimeWin = colIndex - vFirstCollInTimeWin[colIndex];
+      int nCollsInTimeWin = nCollsBeforeInTimeWin + vLastCollInTimeWin[colIndex] - colIndex;
+      for (int iCol = 0; iCol < nCollsInTimeWin; iCol++) {
+        int thisColIndex = iCol < nCollsBeforeInTimeWin ? colIndex - 1 - iCol : colIndex + 1 + (iCol - nCollsBeforeInTimeWin);
+        float dtNS = (vFoundGlobalBC[thisColIndex] - vFoundGlobalBC[colIndex]) * bcNS;
+        float dt = dtNS / 1e3; // ns -> us
         // counting tracks from other collisions in fixed time windows
         if (std::fabs(dt) < evselOpts.confTimeRangeVetoOnCollNarrow)
           nITS567tracksForVetoNarrow += vProxyForCollNtracks[thisColIndex];
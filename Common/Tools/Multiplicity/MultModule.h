@@ -29,10 +29,12 @@
 #include <Framework/Logger.h>
 #include <Framework/RunningWorkflowInfo.h>
 
+#include <TAxis.h>
 #include <TFile.h>
 #include <TFormula.h>
 #include <TH1.h>
 #include <TList.h>
+#include <TMath.h>
 #include <TProfile.h>
 #include <TString.h>
 
@@ -297,6 +299,82 @@ struct multEntry {
   uint16_t spdClustersL1 = 0;
 };
 
+// flat copy of a 1D calibration histogram (TH1 or TProfile), built once per run
+// bins are found with the same arithmetic as TAxis::FindFixBin and the interpolation follows TH1::Interpolate,
+// so that per-collision lookups give the same values without going through the histogram
+class calibrationTable
+{
+ public:
+  void set(const TH1* h)
+  {
+    mContents.clear();
+    mCenters.clear();
+    mEdges.clear();
+    if (h == nullptr) {
+      return;
+    }
+    const TAxis* axis = h->GetXaxis();
+    mNBins = axis->GetNbins();
+    mMin = axis->GetXmin();
+    mMax = axis->GetXmax();
+    if (axis->GetXbins()->GetSize() > 0) {
+      mEdges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + mNBins + 1);
+    }
+    for (int i = 0; i <= mNBins + 1; i++) {
+      mContents.push_back(h->GetBinContent(i));
+      mCenters.push_back(axis->GetBinCenter(i));
+    }
+    mInterpolatedAtZero = interpolate(0.0);
+  }
+
+  bool isValid() const { return !mContents.empty(); }
+
+  // equivalent of h->GetBinContent(h->FindFixBin(x))
+  double getBinContent(double x) const { return mContents[findBin(x)]; }
+
+  // equivalent of h->Interpolate(x)
+  double interpolate(double x) const
+  {
+    if (x <= mCenters[1]) {
+      return mContents[1];
+    }
+    if (x >= mCenters[mNBins]) {
+      return mContents[mNBins];
+    }
+    int bin = findBin(x);
+    if (x <= mCenters[bin]) {
+      bin--;
+    }
+    return mContents[bin] + (x - mCenters[bin]) * ((mContents[bin + 1] - mContents[bin]) / (mCenters[bin + 1] - mCenters[bin]));
+  }
+
+  // h->Interpolate(0.0), the reference of the vertex-Z equalisation
+  double getInterpolatedAtZero() const { return mInterpolatedAtZero; }
+
+ private:
+  int findBin(double x) const
+  {
+    if (x < mMin) {
+      return 0;
+    }
+    if (!(x < mMax)) {
+      return mNBins + 1;
+    }
+    if (mEdges.empty()) {
+      return 1 + static_cast<int>(mNBins * (x - mMin) / (mMax - mMin));
+    }
+    return 1 + static_cast<int>(TMath::BinarySearch(static_cast<Long64_t>(mEdges.size()), mEdges.data(), x));
+  }
+
+  int mNBins = 0;
+  double mMin = 0.0;
+  double mMax = 0.0;
+  std::vector<double> mEdges{};    // bin edges, empty for uniform binning
+  std::vector<double> mContents{}; // bin contents, with under- and overflow
+  std::vector<double> mCenters{};  // bin centers, with under- and overflow
+  double mInterpolatedAtZero = 0.0;
+};
+
 // strangenessBuilder: 1st-order configurables
 struct standardConfigurables : o2::framework::ConfigurableGroup {
   // self-configuration configurables
@@ -361,6 +439,16 @@ class MultModule
   TProfile* hVtxZNMFTTracks;    // non-legacy, added August/2025
   TProfile* hVtxZNGlobalTracks; // non-legacy, added August/2025
 
+  // flat copies of the vtx-z profiles above, used per collision
+  calibrationTable calibVtxZFV0A;
+  calibrationTable calibVtxZFT0A;
+  calibrationTable calibVtxZFT0C;
+  calibrationTable calibVtxZFDDA;
+  calibrationTable calibVtxZFDDC;
+  calibrationTable calibVtxZNTracks;
+  calibrationTable calibVtxZNMFTTracks;
+  calibrationTable calibVtxZNGlobalTracks;
+
   // declaration of structs here
   // (N.B.: will be invisible to the outside, create your own copies)
   o2::common::multiplicity::standardConfigurables internalOpts;
@@ -374,32 +462,46 @@ class MultModule
     TH1* mhVtxAmpCorrV0A = nullptr;
     TH1* mhVtxAmpCorrV0C = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrV0ATable{};
+    calibrationTable mVtxAmpCorrV0CTable{};
+    calibrationTable mMultSelCalibTable{};
   } Run2V0MInfo;
   struct TagRun2V0ACalibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorrV0A = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrV0ATable{};
+    calibrationTable mMultSelCalibTable{};
   } Run2V0AInfo;
   struct TagRun2SPDTrackletsCalibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrTable{};
+    calibrationTable mMultSelCalibTable{};
   } Run2SPDTksInfo;
   struct TagRun2SPDClustersCalibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorrCL0 = nullptr;
     TH1* mhVtxAmpCorrCL1 = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrCL0Table{};
+    calibrationTable mVtxAmpCorrCL1Table{};
+    calibrationTable mMultSelCalibTable{};
   } Run2SPDClsInfo;
   struct TagRun2CL0Calibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrTable{};
+    calibrationTable mMultSelCalibTable{};
   } Run2CL0Info;
   struct TagRun2CL1Calibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    calibrationTable mVtxAmpCorrTable{};
+    calibrationTable mMultSelCalibTable{};
   } Run2CL1Info;
   struct CalibrationInfo {
     std::string name = "";
@@ -407,6 +509,7 @@ class MultModule
     TH1* mhMultSelCalib = nullptr;
     float mMCScalePars[6] = {0.0};
     TFormula* mMCScale = nullptr;
+    calibrationTable mMultSelCalibTable{};
     explicit CalibrationInfo(std::string name)
       : name(name),
         mCalibrationStored(false),
@@ -670,6 +773,14 @@ class MultModule
           hVtxZNTracks = static_cast<TProfile*>(lCalibObjects->FindObject("hVtxZNTracksPV"));
           hVtxZNMFTTracks = static_cast<TProfile*>(lCalibObjects->FindObject("hVtxZMFT"));
           hVtxZNGlobalTracks = static_cast<TProfile*>(lCalibObjects->FindObject("hVtxZNGlobals"));
+          calibVtxZFV0A.set(hVtxZFV0A);
+          calibVtxZFT0A.set(hVtxZFT0A);
+          calibVtxZFT0C.set(hVtxZFT0C);
+          calibVtxZFDDA.set(hVtxZFDDA);
+          calibVtxZFDDC.set(hVtxZFDDC);
+          calibVtxZNTracks.set(hVtxZNTracks);
+          calibVtxZNMFTTracks.set(hVtxZNMFTTracks);
+          calibVtxZNGlobalTracks.set(hVtxZNGlobalTracks);
           lCalibLoaded = true;
           // Capture error
           if (!hVtxZFV0A || !hVtxZFT0A || !hVtxZFT0C || !hVtxZFDDA || !hVtxZFDDC || !hVtxZNTracks) {
@@ -777,7 +888,7 @@ class MultModule
     // vertex-Z equalized signals
     if (internalOpts.mEnabledTables[kFV0MultZeqs]) {
       if (mults.multFV0A > -1.0f && std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multFV0AZeq = hVtxZFV0A->Interpolate(0.0) * mults.multFV0A / hVtxZFV0A->Interpolate(collision.posZ());
+        mults.multFV0AZeq = calibVtxZFV0A.getInterpolatedAtZero() * mults.multFV0A / calibVtxZFV0A.interpolate(collision.posZ());
       } else {
         mults.multFV0AZeq = 0.0f;
       }
@@ -785,12 +896,12 @@ class MultModule
     }
     if (internalOpts.mEnabledTables[kFT0MultZeqs]) {
       if (mults.multFT0A > -1.0f && std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multFT0AZeq = hVtxZFT0A->Interpolate(0.0) * mults.multFT0A / hVtxZFT0A->Interpolate(collision.posZ());
+        mults.multFT0AZeq = calibVtxZFT0A.getInterpolatedAtZero() * mults.multFT0A / calibVtxZFT0A.interpolate(collision.posZ());
       } else {
         mults.multFT0AZeq = 0.0f;
       }
       if (mults.multFT0C > -1.0f && std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multFT0CZeq = hVtxZFT0C->Interpolate(0.0) * mults.multFT0C / hVtxZFT0C->Interpolate(collision.posZ());
+        mults.multFT0CZeq = calibVtxZFT0C.getInterpolatedAtZero() * mults.multFT0C / calibVtxZFT0C.interpolate(collision.posZ());
       } else {
         mults.multFT0CZeq = 0.0f;
       }
@@ -798,12 +909,12 @@ class MultModule
     }
     if (internalOpts.mEnabledTables[kFDDMultZeqs]) {
       if (mults.multFDDA > -1.0f && std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multFDDAZeq = hVtxZFDDA->Interpolate(0.0) * mults.multFDDA / hVtxZFDDA->Interpolate(collision.posZ());
+        mults.multFDDAZeq = calibVtxZFDDA.getInterpolatedAtZero() * mults.multFDDA / calibVtxZFDDA.interpolate(collision.posZ());
       } else {
         mults.multFDDAZeq = 0.0f;
       }
       if (mults.multFDDC > -1.0f && std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multFDDCZeq = hVtxZFDDC->Interpolate(0.0) * mults.multFDDC / hVtxZFDDC->Interpolate(collision.posZ());
+        mults.multFDDCZeq = calibVtxZFDDC.getInterpolatedAtZero() * mults.multFDDC / calibVtxZFDDC.interpolate(collision.posZ());
       } else {
         mults.multFDDCZeq = 0.0f;
       }
@@ -881,10 +992,10 @@ class MultModule
 
       cursors.multsGlobal(mults.multGlobalTracks, mults.multNbrContribsEta08GlobalTrackWoDCA, mults.multNbrContribsEta10GlobalTrackWoDCA, mults.multNbrContribsEta05GlobalTrackWoDCA);
 
-      if (!hVtxZNGlobalTracks || std::fabs(collision.posZ()) > 15.0f) {
+      if (!calibVtxZNGlobalTracks.isValid() || std::fabs(collision.posZ()) > 15.0f) {
         mults.multGlobalTracksZeq = mults.multGlobalTracks; // if no equalization available, don't do it
       } else {
-        mults.multGlobalTracksZeq = hVtxZNGlobalTracks->Interpolate(0.0) * mults.multGlobalTracks / hVtxZNGlobalTracks->Interpolate(collision.posZ());
+        mults.multGlobalTracksZeq = calibVtxZNGlobalTracks.getInterpolatedAtZero() * mults.multGlobalTracks / calibVtxZNGlobalTracks.interpolate(collision.posZ());
       }
 
       // provide vertex-Z equalized Nglobals (or non-equalized if missing or beyond range)
@@ -912,7 +1023,7 @@ class MultModule
     }
     if (internalOpts.mEnabledTables[kPVMultZeqs]) {
       if (std::fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-        mults.multNContribsZeq = hVtxZNTracks->Interpolate(0.0) * mults.multNContribs / hVtxZNTracks->Interpolate(collision.posZ());
+        mults.multNContribsZeq = calibVtxZNTracks.getInterpolatedAtZero() * mults.multNContribs / calibVtxZNTracks.interpolate(collision.posZ());
       } else {
         mults.multNContribsZeq = 0.0f;
       }
@@ -1005,10 +1116,10 @@ class MultModule
     mults[collision.globalIndex()].multMFTTracks = nTracks;
 
     // vertex-Z equalized MFT
-    if (!hVtxZNMFTTracks || std::fabs(collision.posZ()) > 15.0f) {
+    if (!calibVtxZNMFTTracks.isValid() || std::fabs(collision.posZ()) > 15.0f) {
       mults[collision.globalIndex()].multMFTTracksZeq = mults[collision.globalIndex()].multMFTTracks; // if no equalization available, don't do it
     } else {
-      mults[collision.globalIndex()].multMFTTracksZeq = hVtxZNMFTTracks->Interpolate(0.0) * mults[collision.globalIndex()].multMFTTracks / hVtxZNMFTTracks->Interpolate(collision.posZ());
+      mults[collision.globalIndex()].multMFTTracksZeq = calibVtxZNMFTTracks.getInterpolatedAtZero() * mults[collision.globalIndex()].multMFTTracks / calibVtxZNMFTTracks.interpolate(collision.posZ());
     }
 
     // provide vertex-Z equalized Nglobals (or non-equalized if missing or beyond range)
@@ -1082,6 +1193,9 @@ class MultModule
                 LOGF(info, "MC Scale information from V0M for run %d not available", bc.runNumber());
               }
             }
+            Run2V0MInfo.mVtxAmpCorrV0ATable.set(Run2V0MInfo.mhVtxAmpCorrV0A);
+            Run2V0MInfo.mVtxAmpCorrV0CTable.set(Run2V0MInfo.mhVtxAmpCorrV0C);
+            Run2V0MInfo.mMultSelCalibTable.set(Run2V0MInfo.mhMultSelCalib);
             Run2V0MInfo.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1093,6 +1207,8 @@ class MultModule
           Run2V0AInfo.mhVtxAmpCorrV0A = getccdb("hVtx_fAmplitude_V0A_Normalized");
           Run2V0AInfo.mhMultSelCalib = getccdb("hMultSelCalib_V0A");
           if ((Run2V0AInfo.mhVtxAmpCorrV0A != nullptr) && (Run2V0AInfo.mhMultSelCalib != nullptr)) {
+            Run2V0AInfo.mVtxAmpCorrV0ATable.set(Run2V0AInfo.mhVtxAmpCorrV0A);
+            Run2V0AInfo.mMultSelCalibTable.set(Run2V0AInfo.mhMultSelCalib);
             Run2V0AInfo.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1104,6 +1220,8 @@ class MultModule
           Run2SPDTksInfo.mhVtxAmpCorr = getccdb("hVtx_fnTracklets_Normalized");
           Run2SPDTksInfo.mhMultSelCalib = getccdb("hMultSelCalib_SPDTracklets");
           if ((Run2SPDTksInfo.mhVtxAmpCorr != nullptr) && (Run2SPDTksInfo.mhMultSelCalib != nullptr)) {
+            Run2SPDTksInfo.mVtxAmpCorrTable.set(Run2SPDTksInfo.mhVtxAmpCorr);
+            Run2SPDTksInfo.mMultSelCalibTable.set(Run2SPDTksInfo.mhMultSelCalib);
             Run2SPDTksInfo.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1116,6 +1234,9 @@ class MultModule
           Run2SPDClsInfo.mhVtxAmpCorrCL1 = getccdb("hVtx_fnSPDClusters1_Normalized");
           Run2SPDClsInfo.mhMultSelCalib = getccdb("hMultSelCalib_SPDClusters");
           if ((Run2SPDClsInfo.mhVtxAmpCorrCL0 != nullptr) && (Run2SPDClsInfo.mhVtxAmpCorrCL1 != nullptr) && (Run2SPDClsInfo.mhMultSelCalib != nullptr)) {
+            Run2SPDClsInfo.mVtxAmpCorrCL0Table.set(Run2SPDClsInfo.mhVtxAmpCorrCL0);
+            Run2SPDClsInfo.mVtxAmpCorrCL1Table.set(Run2SPDClsInfo.mhVtxAmpCorrCL1);
+            Run2SPDClsInfo.mMultSelCalibTable.set(Run2SPDClsInfo.mhMultSelCalib);
             Run2SPDClsInfo.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1127,6 +1248,8 @@ class MultModule
           Run2CL0Info.mhVtxAmpCorr = getccdb("hVtx_fnSPDClusters0_Normalized");
           Run2CL0Info.mhMultSelCalib = getccdb("hMultSelCalib_CL0");
           if ((Run2CL0Info.mhVtxAmpCorr != nullptr) && (Run2CL0Info.mhMultSelCalib != nullptr)) {
+            Run2CL0Info.mVtxAmpCorrTable.set(Run2CL0Info.mhVtxAmpCorr);
+            Run2CL0Info.mMultSelCalibTable.set(Run2CL0Info.mhMultSelCalib);
             Run2CL0Info.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1138,6 +1261,8 @@ class MultModule
           Run2CL1Info.mhVtxAmpCorr = getccdb("hVtx_fnSPDClusters1_Normalized");
           Run2CL1Info.mhMultSelCalib = getccdb("hMultSelCalib_CL1");
           if ((Run2CL1Info.mhVtxAmpCorr != nullptr) && (Run2CL1Info.mhMultSelCalib != nullptr)) {
+            Run2CL1Info.mVtxAmpCorrTable.set(Run2CL1Info.mhVtxAmpCorr);
+            Run2CL1Info.mMultSelCalibTable.set(Run2CL1Info.mhMultSelCalib);
             Run2CL1Info.mCalibrationStored = true;
           } else {
             // continue filling with non-valid values (105)
@@ -1223,6 +1348,7 @@ class MultModule
                 LOGF(warning, "MC Scale information from %s for run %d not available", estimator.name.c_str(), bc.runNumber());
               }
             }
+            estimator.mMultSelCalibTable.set(estimator.mhMultSelCalib);
             estimator.mCalibrationStored = true;
             estimator.isSane();
           } else {
@@ -1302,7 +1428,7 @@ class MultModule
             scaledMultiplicity = scaleMC(multiplicity, estimator.mMCScalePars);
             LOGF(debug, "Unscaled %s multiplicity: %f, scaled %s multiplicity: %f", estimator.name.c_str(), multiplicity, estimator.name.c_str(), scaledMultiplicity);
           }
-          percentile = estimator.mhMultSelCalib->GetBinContent(estimator.mhMultSelCalib->FindFixBin(scaledMultiplicity));
+          percentile = estimator.mMultSelCalibTable.getBinContent(scaledMultiplicity);
           if (assignOutOfRange)
             percentile = 100.5f;
         }
@@ -1396,10 +1522,10 @@ class MultModule
               v0m = scaleMC(mults[iEv].multFV0A + mults[iEv].multFV0C, Run2V0MInfo.mMCScalePars);
               LOGF(debug, "Unscaled v0m: %f, scaled v0m: %f", mults[iEv].multFV0A + mults[iEv].multFV0C, v0m);
             } else {
-              v0m = mults[iEv].multFV0A * Run2V0MInfo.mhVtxAmpCorrV0A->GetBinContent(Run2V0MInfo.mhVtxAmpCorrV0A->FindFixBin(mults[iEv].posZ)) +
-                    mults[iEv].multFV0C * Run2V0MInfo.mhVtxAmpCorrV0C->GetBinContent(Run2V0MInfo.mhVtxAmpCorrV0C->FindFixBin(mults[iEv].posZ));
+              v0m = mults[iEv].multFV0A * Run2V0MInfo.mVtxAmpCorrV0ATable.getBinContent(mults[iEv].posZ) +
+                    mults[iEv].multFV0C * Run2V0MInfo.mVtxAmpCorrV0CTable.getBinContent(mults[iEv].posZ);
             }
-            cV0M = Run2V0MInfo.mhMultSelCalib->GetBinContent(Run2V0MInfo.mhMultSelCalib->FindFixBin(v0m));
+            cV0M = Run2V0MInfo.mMultSelCalibTable.getBinContent(v0m);
           }
           LOGF(debug, "centRun2V0M=%.0f", cV0M);
           // fill centrality columns
@@ -1408,8 +1534,8 @@ class MultModule
         if (internalOpts.mEnabledTables[kCentRun2V0As]) {
           float cV0A = 105.0f;
           if (Run2V0AInfo.mCalibrationStored) {
-            float v0a = mults[iEv].multFV0A * Run2V0AInfo.mhVtxAmpCorrV0A->GetBinContent(Run2V0AInfo.mhVtxAmpCorrV0A->FindFixBin(mults[iEv].posZ));
-            cV0A = Run2V0AInfo.mhMultSelCalib->GetBinContent(Run2V0AInfo.mhMultSelCalib->FindFixBin(v0a));
+            float v0a = mults[iEv].multFV0A * Run2V0AInfo.mVtxAmpCorrV0ATable.getBinContent(mults[iEv].posZ);
+            cV0A = Run2V0AInfo.mMultSelCalibTable.getBinContent(v0a);
           }
           LOGF(debug, "centRun2V0A=%.0f", cV0A);
           // fill centrality columns
@@ -1418,8 +1544,8 @@ class MultModule
         if (internalOpts.mEnabledTables[kCentRun2SPDTrks]) {
           float cSPD = 105.0f;
           if (Run2SPDTksInfo.mCalibrationStored) {
-            float spdm = mults[iEv].multTracklets * Run2SPDTksInfo.mhVtxAmpCorr->GetBinContent(Run2SPDTksInfo.mhVtxAmpCorr->FindFixBin(mults[iEv].posZ));
-            cSPD = Run2SPDTksInfo.mhMultSelCalib->GetBinContent(Run2SPDTksInfo.mhMultSelCalib->FindFixBin(spdm));
+            float spdm = mults[iEv].multTracklets * Run2SPDTksInfo.mVtxAmpCorrTable.getBinContent(mults[iEv].posZ);
+            cSPD = Run2SPDTksInfo.mMultSelCalibTable.getBinContent(spdm);
           }
           LOGF(debug, "centSPDTracklets=%.0f", cSPD);
           cursors.centRun2SPDTracklets(cSPD);
@@ -1427,9 +1553,9 @@ class MultModule
         if (internalOpts.mEnabledTables[kCentRun2SPDClss]) {
           float cSPD = 105.0f;
           if (Run2SPDClsInfo.mCalibrationStored) {
-            float spdm = mults[iEv].spdClustersL0 * Run2SPDClsInfo.mhVtxAmpCorrCL0->GetBinContent(Run2SPDClsInfo.mhVtxAmpCorrCL0->FindFixBin(mults[iEv].posZ)) +
-                         mults[iEv].spdClustersL1 * Run2SPDClsInfo.mhVtxAmpCorrCL1->GetBinContent(Run2SPDClsInfo.mhVtxAmpCorrCL1->FindFixBin(mults[iEv].posZ));
-            cSPD = Run2SPDClsInfo.mhMultSelCalib->GetBinContent(Run2SPDClsInfo.mhMultSelCalib->FindFixBin(spdm));
+            float spdm = mults[iEv].spdClustersL0 * Run2SPDClsInfo.mVtxAmpCorrCL0Table.getBinContent(mults[iEv].posZ) +
+                         mults[iEv].spdClustersL1 * Run2SPDClsInfo.mVtxAmpCorrCL1Table.getBinContent(mults[iEv].posZ);
+            cSPD = Run2SPDClsInfo.mMultSelCalibTable.getBinContent(spdm);
           }
           LOGF(debug, "centSPDClusters=%.0f", cSPD);
           cursors.centRun2SPDClusters(cSPD);
@@ -1437,8 +1563,8 @@ class MultModule
         if (internalOpts.mEnabledTables[kCentRun2CL0s]) {
           float cCL0 = 105.0f;
           if (Run2CL0Info.mCalibrationStored) {
-            float cl0m = mults[iEv].spdClustersL0 * Run2CL0Info.mhVtxAmpCorr->GetBinContent(Run2CL0Info.mhVtxAmpCorr->FindFixBin(mults[iEv].posZ));
-            cCL0 = Run2CL0Info.mhMultSelCalib->GetBinContent(Run2CL0Info.mhMultSelCalib->FindFixBin(cl0m));
+            float cl0m = mults[iEv].spdClustersL0 * Run2CL0Info.mVtxAmpCorrTable.getBinContent(mults[iEv].posZ);
+            cCL0 = Run2CL0Info.mMultSelCalibTable.getBinContent(cl0m);
           }
           LOGF(debug, "centCL0=%.0f", cCL0);
           cursors.centRun2CL0(cCL0);
@@ -1446,8 +1572,8 @@ class MultModule
         if (internalOpts.mEnabledTables[kCentRun2CL1s]) {
           float cCL1 = 105.0f;
           if (Run2CL1Info.mCalibrationStored) {
-            float cl1m = mults[iEv].spdClustersL1 * Run2CL1Info.mhVtxAmpCorr->GetBinContent(Run2CL1Info.mhVtxAmpCorr->FindFixBin(mults[iEv].posZ));
-            cCL1 = Run2CL1Info.mhMultSelCalib->GetBinContent(Run2CL1Info.mhMultSelCalib->FindFixBin(cl1m));
+            float cl1m = mults[iEv].spdClustersL1 * Run2CL1Info.mVtxAmpCorrTable.getBinContent(mults[iEv].posZ);
+            cCL1 = Run2CL1Info.mMultSelCalibTable.getBinContent(cl1m);
           }
           LOGF(debug, "centCL1=%.0f", cCL1);
           cursors.centRun2CL1(cCL1);
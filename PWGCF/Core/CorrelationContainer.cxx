@@ -57,7 +57,9 @@ CorrelationContainer::CorrelationContainer() : TNamed(),
                                                mSkipScaleMixedEvent(kFALSE),
                                                mCache(nullptr),
                                                mGetMultCacheOn(kFALSE),
-                                               mGetMultCache(nullptr)
+                                               mGetMultCache(nullptr),
+                                               mPairHistShadows(),
+                                               mPairHistShadowTemplate(nullptr)
 {
   // Default constructor
 }
@@ -84,7 +86,9 @@ CorrelationContainer::CorrelationContainer(const char* name, const char* objTitl
                                                                                                    mSkipScaleMixedEvent(kFALSE),
                                                                                                    mCache(nullptr),
                                                                                                    mGetMultCacheOn(kFALSE),
-                                                                                                   mGetMultCache(nullptr)
+                                                                                                   mGetMultCache(nullptr),
+                                                                                                   mPairHistShadows(),
+                                                                                                   mPairHistShadowTemplate(nullptr)
 {
   // correlationAxis has to provide a 6 length list of AxisSpec which contain:
   //   delta_eta, pt_assoc, pt_trig, multiplicity/centrality, delta_phi, vertex
@@ -139,7 +143,9 @@ CorrelationContainer::CorrelationContainer(const CorrelationContainer& c) : TNam
                                                                             mSkipScaleMixedEvent(kFALSE),
                                                                             mCache(nullptr),
                                                                             mGetMultCacheOn(kFALSE),
-                                                                            mGetMultCache(nullptr)
+                                                                            mGetMultCache(nullptr),
+                                                                            mPairHistShadows(),
+                                                                            mPairHistShadowTemplate(nullptr)
 {
   //
   // CorrelationContainer copy constructor
@@ -177,6 +183,16 @@ CorrelationContainer::~CorrelationContainer()
     delete mCache;
     mCache = nullptr;
   }
+
+  for (auto* shadow : mPairHistShadows) {
+    delete shadow;
+  }
+  mPairHistShadows.clear();
+
+  if (mPairHistShadowTemplate) {
+    delete mPairHistShadowTemplate;
+    mPairHistShadowTemplate = nullptr;
+  }
 }
 
 //____________________________________________________________________
@@ -1654,3 +1670,76 @@ void CorrelationContainer::fillEvent(Float_t centrality, CFStep step)
   // Fill per-event information
   mEventCount->Fill(step, centrality);
 }
+
+void CorrelationContainer::fillPairs(CFStep step, std::size_t n, const Float_t* deltaEta, const Float_t* ptAssociated, const Float_t* deltaPhi, const Float_t* weight,
+                                     Float_t ptTrigger, Float_t centrality, Float_t zVtx, const Float_t* massAssociated, const Double_t* massTrigger, Int_t shadow)
+{
+  // Fill the pairs of one trigger particle
+  // the coordinates are in the order of the axes: delta_eta, pt_assoc, pt_trig, multiplicity/centrality, delta_phi, vertex, [user axes], followed by the weight
+
+  StepTHn* hist = (shadow < 0) ? mPairHist : mPairHistShadows[shadow];
+
+  Double_t valuesAndWeight[9];
+  Int_t nValues = 6;
+  valuesAndWeight[2] = ptTrigger;
+  valuesAndWeight[3] = centrality;
+  valuesAndWeight[5] = zVtx;
+  if (massAssociated) {
+    nValues++;
+  }
+  if (massTrigger) {
+    valuesAndWeight[nValues++] = *massTrigger;
+  }
+
+  for (std::size_t i = 0; i < n; i++) {
+    valuesAndWeight[0] = deltaEta[i];
+    valuesAndWeight[1] = ptAssociated[i];
+    valuesAndWeight[4] = deltaPhi[i];
+    if (massAssociated) {
+      valuesAndWeight[6] = massAssociated[i];
+    }
+    valuesAndWeight[nValues] = weight[i];
+    hist->Fill(step, nValues + 1, valuesAndWeight);
+  }
+}
+
+void CorrelationContainer::setNShadowPairHists(Int_t n)
+{
+  // creates n empty shadow pair histograms, replacing the existing ones (which are merged first)
+
+  mergeShadowPairHists();
+  for (auto* shadow : mPairHistShadows) {
+    delete shadow;
+  }
+  mPairHistShadows.clear();
+
+  if (n <= 0) {
+    return;
+  }
+  if (!mPairHistShadowTemplate) {
+    mPairHistShadowTemplate = dynamic_cast<StepTHn*>(mPairHist->Clone());
+  }
+  for (Int_t i = 0; i < n; i++) {
+    mPairHistShadows.push_back(dynamic_cast<StepTHn*>(mPairHistShadowTemplate->Clone()));
+  }
+}
+
+void CorrelationContainer::mergeShadowPairHists()
+{
+  // adds the shadow pair histograms to the pair histogram and empties them
+
+  if (mPairHistShadows.empty()) {
+    return;
+  }
+
+  TList list;
+  for (auto* shadow : mPairHistShadows) {
+    list.Add(shadow);
+  }
+  mPairHist->Merge(&list);
+
+  for (auto& shadow : mPairHistShadows) {
+    delete shadow;
+    shadow = dynamic_cast<StepTHn*>(mPairHistShadowTemplate->Clone());
+  }
+}
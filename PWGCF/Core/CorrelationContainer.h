@@ -18,6 +18,9 @@
 #include "TString.h"
 #include "Framework/HistogramSpec.h"
 
+#include <cstddef>
+#include <vector>
+
 class TH1;
 class TH1F;
 class TH3;
@@ -103,6 +106,20 @@ class CorrelationContainer : public TNamed
 
   void fillEvent(Float_t centrality, CFStep step);
 
+  // Fills the pair histogram with the pairs of one trigger particle (n entries in the arrays deltaEta, ptAssociated, deltaPhi and weight).
+  //   The coordinates common to all the pairs are set once, so that their bins are found once by StepTHn.
+  //   massAssociated (n entries) and massTrigger are the values of the user axes, nullptr if not present.
+  //   shadow selects one of the shadow pair histograms (see setNShadowPairHists), -1 fills the pair histogram itself
+  void fillPairs(CFStep step, std::size_t n, const Float_t* deltaEta, const Float_t* ptAssociated, const Float_t* deltaPhi, const Float_t* weight,
+                 Float_t ptTrigger, Float_t centrality, Float_t zVtx, const Float_t* massAssociated = nullptr, const Double_t* massTrigger = nullptr, Int_t shadow = -1);
+
+  // Shadow pair histograms: empty copies of the pair histogram which can be filled concurrently (e.g. one per thread) without locking,
+  //   and are added to the pair histogram by mergeShadowPairHists() (e.g. at the end of each dataframe).
+  //   setNShadowPairHists has to be called before the pair histogram is filled
+  void setNShadowPairHists(Int_t n);
+  Int_t getNShadowPairHists() const { return mPairHistShadows.size(); }
+  void mergeShadowPairHists();
+
   void extendTrackingEfficiency(Bool_t verbose = kFALSE);
 
   void setEtaRange(Float_t etaMin, Float_t etaMax)
@@ -178,6 +195,9 @@ class CorrelationContainer : public TNamed
   Bool_t mGetMultCacheOn; //! cache for getHistsZVtxMult function active
   THnBase* mGetMultCache; //! cache for getHistsZVtxMult function
 
+  std::vector<StepTHn*> mPairHistShadows; //! shadow pair histograms, see setNShadowPairHists
+  StepTHn* mPairHistShadowTemplate;       //! empty pair histogram from which the shadow pair histograms are created
+
   ClassDef(CorrelationContainer, 2) // underlying event histogram container
 };
 
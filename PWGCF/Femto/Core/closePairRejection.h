@@ -36,6 +36,7 @@
 #include <optional>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace o2::analysis::femto
@@ -230,7 +231,14 @@ class CloseTrackRejection
     }
   }
 
-  void setMagField(float magField) { mMagField = magField; }
+  void setMagField(float magField)
+  {
+    if (magField != mMagField) {
+      mPhistarCache1.clear();
+      mPhistarCache2.clear();
+    }
+    mMagField = magField;
+  }
 
   template <typename T1, typename T2>
   void compute(T1 const& track1, T2 const& track2)
@@ -255,11 +263,23 @@ class CloseTrackRejection
 
     mDeta = t1.eta() - t2.eta();
 
+    if (mPlotAngularCorrelation) {
+      mPhi1 = t1.phi();
+      mPhi2 = t2.phi();
+      mEta1 = t1.eta();
+      mEta2 = t2.eta();
+    }
+
+    // if no dphistar histogram is filled, the pair cannot be close if it is already outside of the deta window
+    if (!mPlotAverage && !mPlotAllRadii && std::fabs(mDeta - mDetaCenter) >= mDetaMax) {
+      return;
+    }
+
+    auto const& phistar1 = getPhistar(t1, mChargeAbsTrack1, mPhistarCache1);
+    auto const& phistar2 = getPhistar(t2, mChargeAbsTrack2, mPhistarCache2);
     for (size_t i = 0; i < TpcRadii.size(); i++) {
-      auto phistar1 = phistar(mMagField, TpcRadii[i], mChargeAbsTrack1 * t1.signedPt(), t1.phi());
-      auto phistar2 = phistar(mMagField, TpcRadii[i], mChargeAbsTrack2 * t2.signedPt(), t2.phi());
-      if (phistar1 && phistar2) {
-        mDphistar.at(i) = RecoDecay::constrainAngle(phistar1.value() - phistar2.value(), -o2::constants::math::PI); // constrain angular difference between -pi and pi
+      if (phistar1.mask[i] && phistar2.mask[i]) {
+        mDphistar.at(i) = RecoDecay::constrainAngle(phistar1.phistar[i] - phistar2.phistar[i], -o2::constants::math::PI); // constrain angular difference between -pi and pi
         mDphistarMask.at(i) = true;
         count++;
       }
@@ -270,13 +290,6 @@ class CloseTrackRejection
     } else {
       mAverageDphistar = 0.f; // if computation at all radii fail, set it 0
     }
-
-    if (mPlotAngularCorrelation) {
-      mPhi1 = t1.phi();
-      mPhi2 = t2.phi();
-      mEta1 = t1.eta();
-      mEta2 = t2.eta();
-    }
   }
 
   void fill(float kinematic)
@@ -363,6 +376,41 @@ class CloseTrackRejection
   bool isActivated() const { return mIsActivated; }
 
  private:
+  // phistar of a track at all radii. It only depends on phi and on the signed pt scaled by the charge (for a given magnetic field),
+  // so it is computed once per track and reused for all the pairs (same and mixed event) the track enters
+  struct Phistar {
+    float phi = 0.f;
+    float signedPt = 0.f;
+    std::array<float, Nradii> phistar = {0.f};
+    std::array<bool, Nradii> mask = {false};
+  };
+
+  template <typename T>
+  Phistar const& getPhistar(T const& track, int chargeAbs, std::unordered_map<int64_t, Phistar>& cache)
+  {
+    const float signedPt = chargeAbs * track.signedPt();
+    const float phi = track.phi();
+    auto it = cache.find(track.globalIndex());
+    if (it != cache.end() && it->second.phi == phi && it->second.signedPt == signedPt) {
+      return it->second;
+    }
+    if (it == cache.end()) {
+      if (cache.size() >= MaxCachedTracks) {
+        cache.clear(); // tracks of previous dataframes, keep the memory bounded
+      }
+      it = cache.emplace(track.globalIndex(), Phistar{}).first;
+    }
+    auto& entry = it->second;
+    entry.phi = phi;
+    entry.signedPt = signedPt;
+    for (size_t i = 0; i < TpcRadii.size(); i++) {
+      auto value = phistar(mMagField, TpcRadii[i], signedPt, phi);
+      entry.phistar[i] = value.value_or(0.f);
+      entry.mask[i] = value.has_value();
+    }
+    return entry;
+  }
+
   std::optional<float> phistar(float magfield, float radius, float signedPt, float phi)
   {
     double arg = 0.3 * (0.1 * magfield) * (0.01 * radius) / (2. * signedPt);
@@ -408,6 +456,10 @@ class CloseTrackRejection
   bool mRandomizeTracks = false;
   std::mt19937 mRng;
   std::uniform_int_distribution<int> mSwapDist{0, 1};
+
+  static constexpr size_t MaxCachedTracks = 100000;
+  std::unordered_map<int64_t, Phistar> mPhistarCache1; // phistar of the tracks used as first track, by global index
+  std::unordered_map<int64_t, Phistar> mPhistarCache2; // phistar of the tracks used as second track, by global index
 };
 
 template <const char* prefix>
@@ -20,8 +20,11 @@
 
 #include "Framework/HistogramRegistry.h"
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace o2;
@@ -58,6 +61,7 @@ class FemtoDreamDetaDphiStar
     atWhichRadiiToSelect = atWhichRadiiToCut;
     radiiTPC = radiiTPCtoCut;
     fillQA = fillTHSparse;
+    mPhiStars.clear();
 
     if constexpr (mPartOneType == o2::aod::femtodreamparticle::ParticleType::kTrack && (mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kTrack || mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kCascadeV0Child || mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kCascadeBachelor)) {
       std::string dirName = static_cast<std::string>(dirNames[0]);
@@ -178,6 +182,10 @@ class FemtoDreamDetaDphiStar
   bool isClosePair(Part1 const& part1, Part2 const& part2, Parts const& particles, float lmagfield, float Q3 = 999.)
   {
     magfield = lmagfield;
+    if (magfield != mPhiStarsMagfield || mPhiStars.size() >= kMaxCachedPhiStars) {
+      mPhiStars.clear();
+      mPhiStarsMagfield = magfield;
+    }
 
     if constexpr (mPartOneType == o2::aod::femtodreamparticle::ParticleType::kTrack && (mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kTrack || mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kCascadeV0Child)) {
       /// Track-Track combination
@@ -189,7 +197,7 @@ class FemtoDreamDetaDphiStar
       }
       auto deta = part1.eta() - part2.eta();
       auto dphi_AT_PV = part1.phi() - part2.phi();
-      auto dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(part1, radiiTPC) - PhiAtSpecificRadiiTPC(part2, radiiTPC);
+      auto dphi_AT_SpecificRadii = GetPhiStar(part1).atSpecificRadius - GetPhiStar(part2).atSpecificRadius;
       bool sameCharge = false;
       auto dphiAvg = AveragePhiStar(part1, part2, 0, &sameCharge);
       if (Q3 == 999) {
@@ -287,7 +295,7 @@ class FemtoDreamDetaDphiStar
           auto daughterPart2 = particles.begin() + indexOfDaughterPart2;
           auto deta = daughterPart1.eta() - daughterPart2.eta();
           auto dphi_AT_PV = daughterPart1.phi() - daughterPart2.phi();
-          auto dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(daughterPart1, radiiTPC) - PhiAtSpecificRadiiTPC(daughterPart2, radiiTPC);
+          auto dphi_AT_SpecificRadii = GetPhiStar(daughterPart1).atSpecificRadius - GetPhiStar(daughterPart2).atSpecificRadius;
           bool sameCharge = false;
           auto dphiAvg = AveragePhiStar(*daughterPart1, *daughterPart2, nhist, &sameCharge);
           if (Q3 == 999) {
@@ -360,7 +368,7 @@ class FemtoDreamDetaDphiStar
         auto daughter = particles.begin() + indexOfDaughter;
         auto deta = part1.eta() - daughter.eta();
         auto dphi_AT_PV = part1.phi() - daughter.phi();
-        auto dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(part1, radiiTPC) - PhiAtSpecificRadiiTPC(daughter, radiiTPC);
+        auto dphi_AT_SpecificRadii = GetPhiStar(part1).atSpecificRadius - GetPhiStar(daughter).atSpecificRadius;
         bool sameCharge = false;
         auto dphiAvg = AveragePhiStar(part1, *daughter, i, &sameCharge);
         if (Q3 == 999) {
@@ -444,7 +452,7 @@ class FemtoDreamDetaDphiStar
           auto daughterPart2 = particles.begin() + indexOfDaughterPart2;
           auto deta = daughterPart1.eta() - daughterPart2.eta();
           auto dphi_AT_PV = daughterPart1.phi() - daughterPart2.phi();
-          auto dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(daughterPart1, radiiTPC) - PhiAtSpecificRadiiTPC(daughterPart2, radiiTPC);
+          auto dphi_AT_SpecificRadii = GetPhiStar(daughterPart1).atSpecificRadius - GetPhiStar(daughterPart2).atSpecificRadius;
           bool sameCharge = false;
           auto dphiAvg = AveragePhiStar(*daughterPart1, *daughterPart2, nhist, &sameCharge);
           if (Q3 == 999) {
@@ -515,7 +523,7 @@ class FemtoDreamDetaDphiStar
         daughterPhi = part2.prong2Phi();
         deta = part1.eta() - daughterEta;
         dphi_AT_PV = part1.phi() - daughterPhi;
-        dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(part1, radiiTPC) - PhiAtSpecificRadiiTPC<true, 2>(part2, radiiTPC);
+        dphi_AT_SpecificRadii = GetPhiStar(part1).atSpecificRadius - PhiAtSpecificRadiiTPC<true, 2>(part2, radiiTPC);
         dphiAvg = AveragePhiStar<true>(part1, part2, 2, &sameCharge);
 
         if (Q3 == 999) {
@@ -591,7 +599,7 @@ class FemtoDreamDetaDphiStar
         daughterPhi = part2.prong1Phi();
         deta = part1.eta() - daughterEta;
         dphi_AT_PV = part1.phi() - daughterPhi;
-        dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(part1, radiiTPC) - PhiAtSpecificRadiiTPC<true, 1>(part2, radiiTPC);
+        dphi_AT_SpecificRadii = GetPhiStar(part1).atSpecificRadius - PhiAtSpecificRadiiTPC<true, 1>(part2, radiiTPC);
         dphiAvg = AveragePhiStar<true>(part1, part2, 1, &sameCharge);
         // histdetadpi[1][0]->Fill(deta, dphiAvg);
 
@@ -671,7 +679,7 @@ class FemtoDreamDetaDphiStar
         auto daughter = particles.begin() + indexOfDaughter;
         auto deta = part1.eta() - daughter.eta();
         auto dphi_AT_PV = part1.phi() - daughter.phi();
-        auto dphi_AT_SpecificRadii = PhiAtSpecificRadiiTPC(part1, radiiTPC) - PhiAtSpecificRadiiTPC(daughter, radiiTPC);
+        auto dphi_AT_SpecificRadii = GetPhiStar(part1).atSpecificRadius - GetPhiStar(daughter).atSpecificRadius;
         bool sameCharge = false;
         auto dphiAvg = AveragePhiStar(part1, *daughter, i, &sameCharge);
         if (Q3 == 999) {
@@ -788,15 +796,25 @@ class FemtoDreamDetaDphiStar
   std::array<std::shared_ptr<THnSparse>, 3> histdetadpi_eta{};
   std::array<std::shared_ptr<THnSparse>, 3> histdetadpi_phi{};
 
-  ///  Calculate phi at all required radii stored in tmpRadiiTPC
-  /// Magnetic field to be provided in Tesla
+  /// phi* of a particle at all the radii in tmpRadiiTPC and at radiiTPC. It only depends on phi, pt and charge of the particle
+  /// (for a given magnetic field), so it is computed once per particle and reused for all the pairs it enters, in same and mixed events
+  struct PhiStar {
+    float phi = 0.f;
+    float pt = 0.f;
+    int charge = 0;
+    std::array<float, 9> atRadii{};
+    float atSpecificRadius = 0.f;
+  };
+
+  static constexpr size_t kMaxCachedPhiStars = 100000; ///< the cache is cleared beyond this size (particles of previous dataframes)
+  std::unordered_map<int64_t, PhiStar> mPhiStars;      ///< phi* of the particles, by global index
+  float mPhiStarsMagfield = 0.f;                       ///< magnetic field of the phi* in mPhiStars
+
+  /// Get the charge from cutcontainer using masks
   template <typename T>
-  int PhiAtRadiiTPC(const T& part, std::vector<float>& tmpVec)
+  int GetCharge(const T& part)
   {
-
-    float phi0 = part.phi();
-    // Start: Get the charge from cutcontainer using masks
-    int charge = 0.;
+    int charge = 0;
     if ((part.cut() & kSignMinusMask) == kValue0 && (part.cut() & kSignPlusMask) == kValue0) {
       charge = 0;
     } else if ((part.cut() & kSignPlusMask) == kSignPlusMask) {
@@ -806,23 +824,30 @@ class FemtoDreamDetaDphiStar
     } else {
       LOG(fatal) << "FemtoDreamDetaDphiStar: Charge bits are set wrong!";
     }
-    // End: Get the charge from cutcontainer using masks
-    float pt = part.pt();
+    return charge;
+  }
+
+  ///  Get phi* of a particle, computed at the first call for the particle
+  /// The returned reference stays valid until the next call of isClosePair
+  template <typename T>
+  const PhiStar& GetPhiStar(const T& part)
+  {
+    const float phi = part.phi();
+    const float pt = part.pt();
+    const int charge = GetCharge(part);
+    auto [it, isNew] = mPhiStars.try_emplace(part.globalIndex());
+    auto& phiStar = it->second;
+    if (!isNew && phiStar.phi == phi && phiStar.pt == pt && phiStar.charge == charge) {
+      return phiStar;
+    }
+    phiStar.phi = phi;
+    phiStar.pt = pt;
+    phiStar.charge = charge;
     for (size_t i = 0; i < 9; i++) {
-      if (runOldVersion) {
-        tmpVec.push_back(phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
-      }
-      if (!runOldVersion) {
-        auto arg = 0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt);
-        // for very low pT particles, this value goes outside of range -1 to 1 at at large tpc radius; asin fails
-        if (std::fabs(arg) < 1) {
-          tmpVec.push_back(phi0 - std::asin(0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
-        } else {
-          tmpVec.push_back(999);
-        }
-      }
+      phiStar.atRadii[i] = PhiAtSpecificRadiiTPC(part, tmpRadiiTPC[i]);
     }
-    return charge;
+    phiStar.atSpecificRadius = PhiAtSpecificRadiiTPC(part, radiiTPC);
+    return phiStar;
   }
 
   ///  Calculate phi at specific radii
@@ -853,19 +878,9 @@ class FemtoDreamDetaDphiStar
       }
     } else {
       phi0 = part.phi();
-      // Start: Get the charge from cutcontainer using masks
-      if ((part.cut() & kSignMinusMask) == kValue0 && (part.cut() & kSignPlusMask) == kValue0) {
-        charge = 0;
-      } else if ((part.cut() & kSignPlusMask) == kSignPlusMask) {
-        charge = 1;
-      } else if ((part.cut() & kSignMinusMask) == kSignMinusMask) {
-        charge = -1;
-      } else {
-        LOG(fatal) << "FemtoDreamDetaDphiStar: Charge bits are set wrong!";
-      }
+      charge = GetCharge(part);
       pt = part.pt();
     }
-    // End: Get the charge from cutcontainer using masks
     float phiAtRadii = 0;
     if (runOldVersion) {
       phiAtRadii = phi0 - std::asin(0.3 * charge * 0.1 * magfield * radii * 0.01 / (2. * pt));
@@ -930,25 +945,27 @@ class FemtoDreamDetaDphiStar
   template <bool isHF = false, typename T1, typename T2>
   float AveragePhiStar(const T1& part1, const T2& part2, int iHist, bool* sameCharge)
   {
-    std::vector<float> tmpVec1;
-    std::vector<float> tmpVec2;
-    auto charge1 = PhiAtRadiiTPC(part1, tmpVec1);
+    const auto& phiStar1 = GetPhiStar(part1);
+    std::vector<float> tmpVecHF;
+    const float* phiAtRadii2 = nullptr;
     if constexpr (!isHF) {
-      auto charge2 = PhiAtRadiiTPC(part2, tmpVec2);
-      if (charge1 == charge2) {
+      const auto& phiStar2 = GetPhiStar(part2);
+      if (phiStar1.charge == phiStar2.charge) {
         *sameCharge = true;
       }
+      phiAtRadii2 = phiStar2.atRadii.data();
     } else {
-      PhiAtRadiiTPCForHF(part2, tmpVec2, iHist);
+      PhiAtRadiiTPCForHF(part2, tmpVecHF, iHist);
       *sameCharge = true; // always true as we checked the condition in the HF task
+      phiAtRadii2 = tmpVecHF.data();
     }
-    int num = tmpVec1.size();
+    int num = phiStar1.atRadii.size();
     int meaningfulEntries = num;
     float dPhiAvg = 0;
     float dphi;
     for (int i = 0; i < num; i++) {
-      if (tmpVec1.at(i) != 999 && tmpVec2.at(i) != 999) {
-        dphi = tmpVec1.at(i) - tmpVec2.at(i);
+      if (phiStar1.atRadii[i] != 999 && phiAtRadii2[i] != 999) {
+        dphi = phiStar1.atRadii[i] - phiAtRadii2[i];
       } else {
         dphi = 0;
         meaningfulEntries = meaningfulEntries - 1;
@@ -11,6 +11,7 @@
 
 #include "GFW.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <string>
 #include <utility>
@@ -85,12 +86,18 @@ int GFW::CreateRegions()
     return 0;
   }
   int nRegions = 0;
+  fMaxHar = 1;
+  fMaxPow = 1;
   for (auto pItr = fRegions.begin(); pItr != fRegions.end(); pItr++) {
-    GFWCumulant* lCumulant = new GFWCumulant();
-    lCumulant->CreateComplexVectorArrayVarPower(pItr->Nhar, pItr->NparVec, pItr->NpT);
-    fCumulants.push_back(*lCumulant);
+    fCumulants.emplace_back();
+    fCumulants.back().CreateComplexVectorArrayVarPower(pItr->Nhar, pItr->NparVec, pItr->NpT);
+    fMaxHar = std::max(fMaxHar, fCumulants.back().GetNHarmonics());
+    fMaxPow = std::max(fMaxPow, fCumulants.back().GetMaxPower());
     ++nRegions;
   }
+  fPhases.resize(fMaxHar);
+  fPrefactors.resize(fMaxPow);
+  fCompiledCFGs.clear(); // Recompiled at the first calculation
   if (nRegions)
     fInitialized = true;
   return nRegions;
@@ -98,9 +105,29 @@ int GFW::CreateRegions()
 void GFW::Fill(double eta, int ptin, double phi, double weight, int mask, double SecondWeight)
 {
   // if(!fInitialized) return;
+  FillTrack(eta, ptin, phi, weight, mask, SecondWeight);
+};
+void GFW::Fill(const FillBatch& batch)
+{
+  // All regions are filled in one pass over the tracks, in the order they were added
+  for (int iTrack = 0; iTrack < batch.Size(); ++iTrack)
+    FillTrack(batch.Eta[iTrack], batch.PtIn[iTrack], batch.Phi[iTrack], batch.Weight[iTrack], batch.Mask[iTrack], batch.SecondWeight[iTrack]);
+};
+void GFW::FillTrack(double eta, int ptin, double phi, double weight, int mask, double SecondWeight)
+{
+  // Phases and weight prefactors are calculated once per track, only if one of the regions accepts it, and shared by all regions
+  ++fQVersion;
+  bool lCalculated = false;
   for (int i = 0; i < static_cast<int>(fRegions.size()); ++i) {
-    if (fRegions.at(i).EtaMin < eta && fRegions.at(i).EtaMax > eta && (fRegions.at(i).BitMask & mask))
-      fCumulants.at(i).FillArray(ptin, phi, weight, SecondWeight);
+    if (!(fRegions[i].EtaMin < eta && fRegions[i].EtaMax > eta && (fRegions[i].BitMask & mask)))
+      continue;
+    GFWCumulant& lCumulant = fCumulants.at(i);
+    if (!lCalculated) {
+      GFWCumulant::CalculatePhases(phi, fMaxHar, fPhases.data());
+      GFWCumulant::CalculatePrefactors(weight, SecondWeight, fMaxPow, fPrefactors.data());
+      lCalculated = true;
+    }
+    lCumulant.FillArray(ptin, fPhases.data(), fPrefactors.data());
   }
 };
 complex<double> GFW::TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant* r1, GFWCumulant* r2, GFWCumulant* r3)
@@ -165,6 +192,7 @@ void GFW::Clear()
     CreateRegions();
   for (auto ptr = fCumulants.begin(); ptr != fCumulants.end(); ++ptr)
     ptr->ResetQs();
+  ++fQVersion;
 };
 GFW::CorrConfig GFW::GetCorrelatorConfig(string config, string head, bool ptdif)
 {
@@ -246,6 +274,7 @@ GFW::CorrConfig GFW::GetCorrelatorConfig(string config, string head, bool ptdif)
   ReturnConfig.Head = head;
   ReturnConfig.pTDif = ptdif;
   // ReturnConfig.pTbin = ptbin;
+  ReturnConfig.Index = static_cast<int>(fListOfCFGs.size());
   fListOfCFGs.push_back(ReturnConfig);
   return ReturnConfig;
 };
@@ -257,11 +286,13 @@ complex<double> GFW::Calculate(int poi, int ref, vector<int> hars, int ptbin)
   GFWCumulant* qovl = qpoi;
   return RecursiveCorr(qpoi, qref, qovl, ptbin, hars);
 };
-complex<double> GFW::Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZero)
+complex<double> GFW::Calculate(const CorrConfig& corconf, int ptbin, bool SetHarmsToZero)
 {
   // if(!fInitialized) return complex<double>(0,0); //First check if initialised, if not -- initialize, and if it fails, return
   if (corconf.Regs.size() == 0)
     return complex<double>(0, 0); // Check if we have any regions at all
+  // Configurations obtained from GetCorrelatorConfig are evaluated from the compiled DAG, others with the recursion
+  const int lCompiled = FindCompiledConfig(corconf);
   complex<double> retval(1, 0);
   int ptInd;
   for (int i = 0; i < static_cast<int>(corconf.Regs.size()); i++) { // looping over all regions
@@ -281,27 +312,173 @@ complex<double> GFW::Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZer
       return complex<double>(0, 0); // if REF is not filled, don't even continue. Could be redundant, but should save little CPU time
     if (!qpoi->IsPtBinFilled(ptInd))
       return complex<double>(0, 0); // if POI is not filled, don't even continue. Could be redundant, but should save little CPU time
-    GFWCumulant* qovl = 0;
     // Check if in the ref. region we have enough particles (no. of particles in the region >= no of harmonics for subevent)
     int sz1 = corconf.Hars.at(i).size();
     if (poi != ref)
       sz1--;
     if (qref->GetN() < sz1)
       return complex<double>(0, 0);
+    const int lRoot = (lCompiled > -1) ? (SetHarmsToZero ? fCompiledCFGs[lCompiled].RootsZero[i] : fCompiledCFGs[lCompiled].Roots[i]) : -1;
+    if (lRoot > -1) {
+      retval *= EvaluateNode(lRoot, ptInd);
+      continue;
+    }
+    GFWCumulant* qovl = 0;
     // Then, figure the overlap
     if (ovl > -1) // if overlap is defined, then (unless it's explicitly disabled)
       qovl = &fCumulants.at(ovl);
     else if (ref == poi)
       qovl = qref; // If ref and poi are the same, then the same is for overlap. Only, when OL not explicitly defined
+    vector<int> hars = corconf.Hars.at(i);
     if (SetHarmsToZero) {
-      for (int j = 0; j < static_cast<int>(corconf.Hars.at(i).size()); j++) {
-        corconf.Hars.at(i).at(j) = 0;
+      for (int j = 0; j < static_cast<int>(hars.size()); j++) {
+        hars.at(j) = 0;
       }
     }
-    retval *= RecursiveCorr(qpoi, qref, qovl, ptInd, corconf.Hars.at(i));
+    retval *= RecursiveCorr(qpoi, qref, qovl, ptInd, hars);
   }
   return retval;
 };
+int GFW::FindCompiledConfig(const CorrConfig& corconf)
+{
+  if (corconf.Index < 0 || corconf.Index >= static_cast<int>(fListOfCFGs.size()) || fCumulants.empty())
+    return -1;
+  const CorrConfig& lConf = fListOfCFGs[corconf.Index];
+  if (lConf.Regs != corconf.Regs || lConf.Hars != corconf.Hars || lConf.Overlap != corconf.Overlap || lConf.ptInd != corconf.ptInd)
+    return -1; // modified after GetCorrelatorConfig, calculate it explicitly
+  if (fCompiledCFGs.size() != fListOfCFGs.size())
+    CompileConfigs();
+  return corconf.Index;
+};
+void GFW::CompileConfigs()
+{
+  // Traces the recursion of RecursiveCorr for all configurations (with and without harmonics), creating each distinct term once
+  fCorrNodes.clear();
+  fCorrTerms.clear();
+  fCorrNodeIndex.clear();
+  fCompiledCFGs.assign(fListOfCFGs.size(), CompiledConfig{});
+  for (int iConf = 0; iConf < static_cast<int>(fListOfCFGs.size()); iConf++) {
+    const CorrConfig& lConf = fListOfCFGs[iConf];
+    for (int i = 0; i < static_cast<int>(lConf.Regs.size()); i++) {
+      if (lConf.Regs.at(i).size() == 0 || lConf.Hars.at(i).size() == 0) {
+        fCompiledCFGs[iConf].Roots.push_back(-1);
+        fCompiledCFGs[iConf].RootsZero.push_back(-1);
+        continue;
+      }
+      int poi = lConf.Regs.at(i).at(0);
+      int ref = (lConf.Regs.at(i).size() > 1) ? lConf.Regs.at(i).at(1) : poi;
+      int ovl = lConf.Overlap.at(i);
+      if (ovl < 0 && ref == poi)
+        ovl = ref;
+      vector<int> hars = lConf.Hars.at(i);
+      vector<int> pows(hars.size(), 1);
+      fCompiledCFGs[iConf].Roots.push_back(CompileNode(poi, ref, ovl, hars, pows));
+      std::fill(hars.begin(), hars.end(), 0);
+      fCompiledCFGs[iConf].RootsZero.push_back(CompileNode(poi, ref, ovl, hars, pows));
+    }
+  }
+  fNPtSlots = 1;
+  for (const auto& lRegion : fRegions)
+    fNPtSlots = std::max(fNPtSlots, lRegion.NpT);
+  fNodeValues.assign(fCorrNodes.size() * fNPtSlots, complex<double>(0, 0));
+  fNodeVersions.assign(fCorrNodes.size() * fNPtSlots, 0);
+};
+int GFW::AddVecNode(int cumulant, int har, int pow, bool ptdif)
+{
+  vector<int> lKey = {kVecNode, cumulant, har, pow, ptdif};
+  auto lItr = fCorrNodeIndex.find(lKey);
+  if (lItr != fCorrNodeIndex.end())
+    return lItr->second;
+  CorrNode lNode;
+  lNode.Type = kVecNode;
+  lNode.Cumulant = cumulant;
+  lNode.Har = har;
+  lNode.Pow = pow;
+  lNode.PtDif = ptdif;
+  fCorrNodes.push_back(lNode);
+  fCorrNodeIndex[lKey] = static_cast<int>(fCorrNodes.size()) - 1;
+  return static_cast<int>(fCorrNodes.size()) - 1;
+};
+int GFW::CompileNode(int poi, int ref, int ovl, vector<int>& hars, vector<int>& pows)
+{
+  // Same steps as RecursiveCorr, with cumulants given by their index (-1 for no overlap)
+  if ((pows.at(0) != 1) && ovl > -1)
+    poi = ovl;
+  if (hars.size() < 2)
+    return AddVecNode(poi, hars.at(0), pows.at(0), true);
+  vector<int> lKey = {(hars.size() < 3) ? kTwoNode : kRecNode, poi, ref, ovl};
+  lKey.insert(lKey.end(), hars.begin(), hars.end());
+  lKey.insert(lKey.end(), pows.begin(), pows.end());
+  auto lItr = fCorrNodeIndex.find(lKey);
+  if (lItr != fCorrNodeIndex.end())
+    return lItr->second;
+  CorrNode lNode;
+  if (hars.size() < 3) {
+    lNode.Type = kTwoNode;
+    lNode.First = AddVecNode(poi, hars.at(0), pows.at(0), true);
+    lNode.Second = AddVecNode(ref, hars.at(1), pows.at(1), true);
+    lNode.Third = (ovl > -1) ? AddVecNode(ovl, hars.at(0) + hars.at(1), pows.at(0) + pows.at(1), true) : -1;
+  } else {
+    lNode.Type = kRecNode;
+    int harlast = hars.at(hars.size() - 1);
+    int powlast = pows.at(pows.size() - 1);
+    hars.erase(hars.end() - 1);
+    pows.erase(pows.end() - 1);
+    lNode.First = CompileNode(poi, ref, ovl, hars, pows);
+    lNode.Second = AddVecNode(ref, harlast, powlast, false);
+    vector<pair<int, int>> lTerms;
+    int lDegeneracy = 1;
+    int harSize = static_cast<int>(hars.size());
+    for (int i = harSize - 1; i >= 0; i--) {
+      if (i > 2) {
+        if (hars.at(i) == hars.at(i - 1) && pows.at(i) == pows.at(i - 1)) {
+          lDegeneracy++;
+          continue;
+        }
+      }
+      hars.at(i) += harlast;
+      pows.at(i) += powlast;
+      lTerms.push_back(std::make_pair(CompileNode(poi, ref, ovl, hars, pows), lDegeneracy));
+      lDegeneracy = 1;
+      hars.at(i) -= harlast;
+      pows.at(i) -= powlast;
+    }
+    hars.push_back(harlast);
+    pows.push_back(powlast);
+    lNode.FirstTerm = static_cast<int>(fCorrTerms.size());
+    lNode.NTerms = static_cast<int>(lTerms.size());
+    fCorrTerms.insert(fCorrTerms.end(), lTerms.begin(), lTerms.end());
+  }
+  fCorrNodes.push_back(lNode);
+  fCorrNodeIndex[lKey] = static_cast<int>(fCorrNodes.size()) - 1;
+  return static_cast<int>(fCorrNodes.size()) - 1;
+};
+complex<double> GFW::EvaluateNode(int node, int ptbin)
+{
+  if (ptbin < 0 || ptbin >= fNPtSlots)
+    ptbin = 0; // out-of-range bins fall back to the first one, as in GFWCumulant::Vec
+  const int lSlot = node * fNPtSlots + ptbin;
+  if (fNodeVersions[lSlot] == fQVersion)
+    return fNodeValues[lSlot];
+  const CorrNode& lNode = fCorrNodes[node];
+  complex<double> lValue;
+  if (lNode.Type == kVecNode) {
+    lValue = fCumulants[lNode.Cumulant].Vec(lNode.Har, lNode.Pow, lNode.PtDif ? ptbin : 0);
+  } else if (lNode.Type == kTwoNode) {
+    lValue = EvaluateNode(lNode.First, ptbin) * EvaluateNode(lNode.Second, ptbin) - ((lNode.Third > -1) ? EvaluateNode(lNode.Third, ptbin) : complex<double>(0., 0.));
+  } else {
+    lValue = EvaluateNode(lNode.First, ptbin) * EvaluateNode(lNode.Second, ptbin);
+    for (int iTerm = lNode.FirstTerm; iTerm < lNode.FirstTerm + lNode.NTerms; iTerm++) {
+      complex<double> subtractVal = EvaluateNode(fCorrTerms[iTerm].first, ptbin);
+      if (fCorrTerms[iTerm].second > 1)
+        subtractVal *= fCorrTerms[iTerm].second;
+      lValue -= subtractVal;
+    }
+  }
+  fNodeValues[lSlot] = lValue;
+  fNodeVersions[lSlot] = fQVersion;
+  return lValue;
+};
 vector<pair<int, vector<int>>> GFW::GetHarmonicsSingleConfig(const CorrConfig& incfg)
 {
   vector<pair<int, vector<int>>> retPair;
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <complex>
 #include <cstdio>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -50,6 +51,34 @@ class GFW
     std::vector<int> ptInd;
     bool pTDif = false;
     std::string Head = "";
+    int Index = -1; // Position in the list of configurations of this GFW, used to find its compiled form
+  };
+  struct FillBatch { // Tracks of one event, filled into all regions at once with Fill(const FillBatch&)
+    std::vector<double> Eta{};
+    std::vector<int> PtIn{};
+    std::vector<double> Phi{};
+    std::vector<double> Weight{};
+    std::vector<int> Mask{};
+    std::vector<double> SecondWeight{};
+    void Add(double eta, int ptin, double phi, double weight, int mask, double secondWeight = -1)
+    {
+      Eta.push_back(eta);
+      PtIn.push_back(ptin);
+      Phi.push_back(phi);
+      Weight.push_back(weight);
+      Mask.push_back(mask);
+      SecondWeight.push_back(secondWeight);
+    };
+    void Clear()
+    {
+      Eta.clear();
+      PtIn.clear();
+      Phi.clear();
+      Weight.clear();
+      Mask.clear();
+      SecondWeight.clear();
+    };
+    int Size() const { return static_cast<int>(Phi.size()); }
   };
   GFW();
   ~GFW();
@@ -61,15 +90,55 @@ class GFW
   void AddRegion(std::string refName, int lNhar, int* lNparVec, double lEtaMin, double lEtaMax, int lNpT, int BitMask);  // Legacy support, array instead of a vector
   int CreateRegions();
   void Fill(double eta, int ptin, double phi, double weight, int mask, double secondWeight = -1);
+  void Fill(const FillBatch& batch);
   void Clear();
   GFWCumulant GetCumulant(int index) { return fCumulants.at(index); }
   CorrConfig GetCorrelatorConfig(std::string config, std::string head = "", bool ptdif = false);
-  std::complex<double> Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZero);
+  std::complex<double> Calculate(const CorrConfig& corconf, int ptbin, bool SetHarmsToZero);
   void InitializePowerArrays();
 
  protected:
   bool fInitialized;
   std::vector<CorrConfig> fListOfCFGs;
+  int fMaxHar = 1;                                // Max. number of harmonics over all regions
+  int fMaxPow = 1;                                // Max. power over all regions
+  std::vector<std::complex<double>> fPhases = {}; // Phases of the track being filled, shared by all regions
+  std::vector<double> fPrefactors = {};           // Weight prefactors of the track being filled, shared by all regions
+  void FillTrack(double eta, int ptin, double phi, double weight, int mask, double secondWeight);
+  // Correlator planner: the recursions of all configurations are compiled once into a DAG of shared terms,
+  // whose values are cached per pT bin until the Q-vectors change
+  enum CorrNodeType { kVecNode = 0,
+                      kTwoNode = 1,
+                      kRecNode = 2 };
+  struct CorrNode {
+    int Type = kVecNode;
+    int Cumulant = -1; // kVecNode: region, harmonic and power of the Q-vector,
+    int Har = 0;       // taken in the requested pT bin if PtDif, otherwise in bin 0
+    int Pow = 0;
+    bool PtDif = true;
+    int First = -1;  // kTwoNode: First * Second - Third (if defined)
+    int Second = -1; // kRecNode: First * Second - terms [FirstTerm, FirstTerm + NTerms)
+    int Third = -1;
+    int FirstTerm = 0;
+    int NTerms = 0;
+  };
+  struct CompiledConfig {
+    std::vector<int> Roots{};     // One node per subevent
+    std::vector<int> RootsZero{}; // Same, with harmonics set to zero
+  };
+  std::vector<CorrNode> fCorrNodes{};               //! Nodes of the DAG
+  std::vector<std::pair<int, int>> fCorrTerms{};    //! Subtracted node and its degeneracy
+  std::map<std::vector<int>, int> fCorrNodeIndex{}; //! Node of each (type, regions, harmonics, powers), to share them
+  std::vector<CompiledConfig> fCompiledCFGs{};      //! Compiled form of fListOfCFGs
+  int fNPtSlots = 1;                                //! Number of cached pT bins per node
+  unsigned long fQVersion = 1;                      //! Incremented whenever the Q-vectors change
+  std::vector<std::complex<double>> fNodeValues{};  //! [node][pT bin]
+  std::vector<unsigned long> fNodeVersions{};       //! Q-vector version of fNodeValues
+  void CompileConfigs();
+  int CompileNode(int poi, int ref, int ovl, std::vector<int>& hars, std::vector<int>& pows);
+  int AddVecNode(int cumulant, int har, int pow, bool ptdif);
+  int FindCompiledConfig(const CorrConfig& corconf);
+  std::complex<double> EvaluateNode(int node, int ptbin);
   std::complex<double> TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant*, GFWCumulant*, GFWCumulant*);
   std::complex<double> RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, std::vector<int>& hars, std::vector<int>& pows); // POI, Ref. flow, overlapping region
   std::complex<double> RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, std::vector<int>& hars);                         // POI, Ref. flow, overlapping region
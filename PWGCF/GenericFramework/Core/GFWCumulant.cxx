@@ -11,22 +11,61 @@
 
 #include "GFWCumulant.h"
 
+#include <algorithm>
 #include <vector>
 
 using std::complex;
 using std::vector;
 
-GFWCumulant::GFWCumulant() : fQvector(0),
+GFWCumulant::GFWCumulant() : fQvector(),
+                             fOffsets(),
+                             fStride(0),
+                             fPhases(),
+                             fPrefactors(),
                              fUsed(kBlank),
                              fNEntries(-1),
                              fN(1),
                              fPow(1),
                              fPt(1),
-                             fFilledPts(0),
+                             fFilledPts(),
                              fInitialized(false) {}
 
 GFWCumulant::~GFWCumulant() {}
+void GFWCumulant::CalculatePhases(double phi, int nHar, complex<double>* phases)
+{
+  // Harmonics built by complex multiplication, exp(i*n*phi) = exp(i*phi)^n, instead of calculating sin and cos for each of them
+  if (nHar < 1)
+    return;
+  phases[0] = complex<double>(1., 0.);
+  const complex<double> lPhase(cos(phi), sin(phi));
+  for (int lN = 1; lN < nHar; lN++)
+    phases[lN] = phases[lN - 1] * lPhase;
+};
+void GFWCumulant::CalculatePrefactors(double weight, double SecondWeight, int nPow, double* prefactors)
+{
+  // If second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
+  // this is important when POIs are a subset of REFs and have different weights than REFs
+  for (int lPow = 0; lPow < nPow; lPow++) {
+    if (SecondWeight > 0 && lPow > 1)
+      prefactors[lPow] = pow(SecondWeight, lPow - 1) * weight;
+    else
+      prefactors[lPow] = pow(weight, lPow);
+  }
+};
 void GFWCumulant::FillArray(int ptin, double phi, double weight, double SecondWeight)
+{
+  if (!fInitialized)
+    CreateComplexVectorArray(1, 1, 1);
+  if (fPt == 1)
+    ptin = 0; // If one bin, then just fill it straight; otherwise, if ptin is out-of-range, do not fill
+  else if (ptin < 0 || ptin >= fPt)
+    return;
+  // Dont calculate it for each harmonic and power; multiplication is cheaper than sin, cos and power
+  CalculatePhases(phi, fN, fPhases.data());
+  CalculatePrefactors(weight, SecondWeight, fPow, fPrefactors.data());
+  FillArray(ptin, fPhases.data(), fPrefactors.data());
+};
+void GFWCumulant::FillArray(int ptin, const complex<double>* phases, const double* prefactors)
 {
   if (!fInitialized)
     CreateComplexVectorArray(1, 1, 1);
@@ -35,22 +74,13 @@ void GFWCumulant::FillArray(int ptin, double phi, double weight, double SecondWe
   else if (ptin < 0 || ptin >= fPt)
     return;
   fFilledPts[ptin] = true;
+  complex<double>* lQvector = fQvector.data() + ptin * fStride;
   for (int lN = 0; lN < fN; lN++) {
-    double lSin = sin(lN * phi); // No need to recalculate for each power
-    double lCos = cos(lN * phi); // No need to recalculate for each power
-    for (int lPow = 0; lPow < PW(lN); lPow++) {
-      double lPrefactor = 0;
-      // Dont calculate it twice; multiplication is cheaper that power
-      // Also, if second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
-      // this is important when POIs are a subset of REFs and have different weights than REFs
-      if (SecondWeight > 0 && lPow > 1)
-        lPrefactor = pow(SecondWeight, lPow - 1) * weight;
-      else
-        lPrefactor = pow(weight, lPow);
-      double qsin = lPrefactor * lSin;
-      double qcos = lPrefactor * lCos;
-      fQvector[ptin][lN][lPow] += complex<double>(qcos, qsin);
-    }
+    const complex<double> lPhase = phases[lN];
+    complex<double>* lQ = lQvector + fOffsets[lN];
+    const int lNPow = fPowVec[lN];
+    for (int lPow = 0; lPow < lNPow; lPow++)
+      lQ[lPow] += prefactors[lPow] * lPhase;
   }
   Inc();
 };
@@ -58,30 +88,18 @@ void GFWCumulant::ResetQs()
 {
   if (!fNEntries)
     return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
-  for (int i = 0; i < fPt; i++) {
-    fFilledPts[i] = false;
-    for (int lN = 0; lN < fN; lN++) {
-      for (int lPow = 0; lPow < PW(lN); lPow++) {
-        fQvector[i][lN][lPow] = fNullQ;
-      }
-    }
-  }
+  std::fill(fFilledPts.begin(), fFilledPts.end(), false);
+  std::fill(fQvector.begin(), fQvector.end(), fNullQ);
   fNEntries = 0;
 };
 void GFWCumulant::DestroyComplexVectorArray()
 {
   if (!fInitialized)
     return;
-  for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      delete[] fQvector[i][l_n];
-    }
-  }
-  for (int i = 0; i < fPt; i++) {
-    delete[] fQvector[i];
-  }
-  delete[] fQvector;
-  delete[] fFilledPts;
+  fQvector.clear();
+  fOffsets.clear();
+  fFilledPts.clear();
+  fStride = 0;
   fInitialized = false;
   fNEntries = -1;
 };
@@ -98,19 +116,20 @@ void GFWCumulant::CreateComplexVectorArrayVarPower(int N, vector<int> PowVec, in
 {
   DestroyComplexVectorArray();
   fN = N;
-  fPow = 0;
   fPt = Pt;
-  fFilledPts = new bool[Pt];
   fPowVec = PowVec;
-  fQvector = new complex<double>**[fPt];
-  for (int i = 0; i < fPt; i++) {
-    fQvector[i] = new complex<double>*[fN];
-  }
+  fPow = 0;
+  fStride = 0;
+  fOffsets.resize(fN);
   for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      fQvector[i][l_n] = new complex<double>[PW(l_n)];
-    }
+    fOffsets[l_n] = fStride;
+    fStride += PW(l_n);
+    fPow = std::max(fPow, PW(l_n));
   }
+  fQvector.resize(fPt * fStride);
+  fFilledPts.resize(fPt);
+  fPhases.resize(fN);
+  fPrefactors.resize(fPow);
   ResetQs();
   fInitialized = true;
 };
@@ -121,12 +140,12 @@ complex<double> GFWCumulant::Vec(int n, int p, int ptbin)
   if (ptbin >= fPt || ptbin < 0)
     ptbin = 0;
   if (n >= 0)
-    return fQvector[ptbin][n][p];
-  return conj(fQvector[ptbin][-n][p]);
+    return fQvector[ptbin * fStride + fOffsets[n] + p];
+  return conj(fQvector[ptbin * fStride + fOffsets[-n] + p]);
 };
 bool GFWCumulant::IsPtBinFilled(int ptb)
 {
-  if (!fFilledPts)
+  if (fFilledPts.empty())
     return false;
   if (ptb > 0) {
     if (fPt == 1)
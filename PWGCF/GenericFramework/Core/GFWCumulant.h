@@ -27,6 +27,9 @@ class GFWCumulant
   ~GFWCumulant();
   void ResetQs();
   void FillArray(int ptin, double phi, double weight = 1, double SecondWeight = -1);
+  void FillArray(int ptin, const std::complex<double>* phases, const double* prefactors);            // Phases and weight prefactors precomputed with the functions below
+  static void CalculatePhases(double phi, int nHar, std::complex<double>* phases);                   // phases[n] = exp(i*n*phi), n < nHar
+  static void CalculatePrefactors(double weight, double SecondWeight, int nPow, double* prefactors); // prefactors[p] = weight^p, p < nPow
   enum UsedFlags_t { kBlank = 0,
                      kFull = 1,
                      kPt = 2 };
@@ -37,6 +40,8 @@ class GFWCumulant
   };
   void Inc() { fNEntries++; }
   int GetN() { return fNEntries; }
+  int GetNHarmonics() const { return fN; }
+  int GetMaxPower() const { return fPow; }
   bool IsPtBinFilled(int ptb);
   void CreateComplexVectorArray(int N = 1, int P = 1, int Pt = 1);
   void CreateComplexVectorArrayVarPower(int N = 1, std::vector<int> Pvec = {1}, int Pt = 1);
@@ -44,15 +49,19 @@ class GFWCumulant
   void DestroyComplexVectorArray();
   std::complex<double> Vec(int, int, int ptbin = 0); // envelope class to summarize pt-dif. Q-vec getter
  protected:
-  std::complex<double>*** fQvector;
+  // Q-vectors of all pT bins, harmonics and powers, stored contiguously as [ptbin][harmonic][power]
+  std::vector<std::complex<double>> fQvector; //!
+  std::vector<int> fOffsets;                  //! Offset of [harmonic][0] within a pT bin
+  int fStride;                                //! Number of Q-vectors per pT bin
+  std::vector<std::complex<double>> fPhases;  //! Phases of the track being filled
+  std::vector<double> fPrefactors;            //! Weight prefactors of the track being filled
   uint fUsed;
   int fNEntries;
-  // Q-vectors. Could be done recursively, but maybe defining each one of them explicitly is easier to read
   int fN;                   //! Harmonics
-  int fPow;                 //! Power
+  int fPow;                 //! Max. power
   std::vector<int> fPowVec; //! Powers array
   int fPt;                  //! fPt bins
-  bool* fFilledPts;
+  std::vector<bool> fFilledPts;
   bool fInitialized; // Arrays are initialized
   std::complex<double> fNullQ = 0;
 };
@@ -167,6 +167,18 @@ double GFWWeights::getNUE(double pt, double eta, double vz)
     return 1. / weight;
   return 1;
 }
+TH3D* GFWWeights::getIntegratedNUA()
+{
+  if (!fAccInt)
+    createNUA();
+  return fAccInt;
+}
+TH3D* GFWWeights::getIntegratedNUE()
+{
+  if (!fEffInt)
+    createNUE();
+  return fEffInt;
+}
 double GFWWeights::findMax(TH3D* inh, int& ix, int& iy, int& iz)
 {
   double maxv = inh->GetBinContent(1, 1, 1);
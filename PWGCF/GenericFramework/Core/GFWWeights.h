@@ -38,6 +38,8 @@ class GFWWeights : public TNamed
   double getWeight(double phi, double eta, double vz, double pt, double cent, int htype);             // htype: 0 for data, 1 for mc rec, 2 for mc gen
   double getNUA(double phi, double eta, double vz);                                                   // This just fetches correction from integrated NUA, should speed up
   double getNUE(double pt, double eta, double vz);                                                    // fetches weight from fEffInt
+  TH3D* getIntegratedNUA();                                                                           // integrated NUA used by getNUA, created if needed
+  TH3D* getIntegratedNUE();                                                                           // integrated NUE used by getNUE, created if needed
   bool isDataFilled() { return fDataFilled; }
   bool isMCFilled() { return fMCFilled; }
   double findMax(TH3D* inh, int& ix, int& iy, int& iz);
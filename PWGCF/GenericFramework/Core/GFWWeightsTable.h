@@ -0,0 +1,134 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file GFWWeightsTable.h
+/// \brief Immutable lookup table of the NUA/NUE corrections of GFWWeights, for fast per-track access
+
+#ifndef PWGCF_GENERICFRAMEWORK_CORE_GFWWEIGHTSTABLE_H_
+#define PWGCF_GENERICFRAMEWORK_CORE_GFWWEIGHTSTABLE_H_
+
+#include "GFWWeights.h"
+
+#include "TAxis.h"
+#include "TH3.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+/// Inverse weights (1/w, or 1 for empty bins) of a TH3, as returned by GFWWeights::getNUA and getNUE,
+/// stored in a flat array with the under- and overflow bins. Bins are found with the same arithmetic as TAxis::FindBin,
+/// from the axis limits for uniform binning and from the bin edges otherwise
+class GFWWeightsTable
+{
+ public:
+  GFWWeightsTable() = default;
+  explicit GFWWeightsTable(const TH3* hist)
+  {
+    if (!hist)
+      return;
+    fAxes = {Axis(hist->GetXaxis()), Axis(hist->GetYaxis()), Axis(hist->GetZaxis())};
+    fStrideY = fAxes[0].nBins + 2;
+    fStrideZ = fStrideY * (fAxes[1].nBins + 2);
+    fWeights.resize(static_cast<std::size_t>(fStrideZ) * (fAxes[2].nBins + 2));
+    for (int iz = 0; iz <= fAxes[2].nBins + 1; iz++) {
+      for (int iy = 0; iy <= fAxes[1].nBins + 1; iy++) {
+        for (int ix = 0; ix <= fAxes[0].nBins + 1; ix++) {
+          double weight = hist->GetBinContent(ix, iy, iz);
+          fWeights[ix + iy * fStrideY + iz * fStrideZ] = (weight != 0) ? 1. / weight : 1.;
+        }
+      }
+    }
+  }
+
+  bool isValid() const { return !fWeights.empty(); }
+
+  /// Inverse weight at (x, y, z), 1 if the table is empty
+  float get(double x, double y, double z) const
+  {
+    if (fWeights.empty())
+      return 1.f;
+    return fWeights[fAxes[0].findBin(x) + fAxes[1].findBin(y) * fStrideY + fAxes[2].findBin(z) * fStrideZ];
+  }
+
+  /// Inverse weights of n tracks at (x[i], y[i], z), e.g. (phi, eta) or (pt, eta) of all tracks of an event at its vertex z
+  template <typename T>
+  void get(std::size_t n, const T* x, const T* y, double z, float* weights) const
+  {
+    if (fWeights.empty()) {
+      std::fill(weights, weights + n, 1.f);
+      return;
+    }
+    const float* slice = fWeights.data() + fAxes[2].findBin(z) * fStrideZ;
+    for (std::size_t i = 0; i < n; i++)
+      weights[i] = slice[fAxes[0].findBin(x[i]) + fAxes[1].findBin(y[i]) * fStrideY];
+  }
+
+ private:
+  struct Axis {
+    int nBins = 0;
+    double min = 0;
+    double max = 0;
+    std::vector<double> edges{}; // empty for uniform binning
+    Axis() = default;
+    explicit Axis(const TAxis* axis) : nBins(axis->GetNbins()), min(axis->GetXmin()), max(axis->GetXmax())
+    {
+      if (axis->GetXbins()->GetSize() > 0)
+        edges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + nBins + 1);
+    }
+    int findBin(double x) const
+    {
+      if (x < min)
+        return 0;
+      if (!(x < max))
+        return nBins + 1;
+      if (edges.empty())
+        return 1 + static_cast<int>(nBins * (x - min) / (max - min));
+      return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+    }
+  };
+
+  std::vector<Axis> fAxes{};
+  int fStrideY = 0;
+  int fStrideZ = 0;
+  std::vector<float> fWeights{};
+};
+
+/// Tables built once per run and slot (e.g. one slot per particle species), so that retrieving the same GFWWeights
+/// from the CCDB again for a run does not rebuild them
+class GFWWeightsTableCache
+{
+ public:
+  const GFWWeightsTable& getNUA(int run, int slot, GFWWeights* weights)
+  {
+    auto key = std::make_pair(run, slot);
+    auto itr = fNUATables.find(key);
+    if (itr == fNUATables.end())
+      itr = fNUATables.emplace(key, GFWWeightsTable(weights ? weights->getIntegratedNUA() : nullptr)).first;
+    return itr->second;
+  }
+  const GFWWeightsTable& getNUE(int run, int slot, GFWWeights* weights)
+  {
+    auto key = std::make_pair(run, slot);
+    auto itr = fNUETables.find(key);
+    if (itr == fNUETables.end())
+      itr = fNUETables.emplace(key, GFWWeightsTable(weights ? weights->getIntegratedNUE() : nullptr)).first;
+    return itr->second;
+  }
+
+ private:
+  std::map<std::pair<int, int>, GFWWeightsTable> fNUATables{};
+  std::map<std::pair<int, int>, GFWWeightsTable> fNUETables{};
+};
+
+#endif // PWGCF_GENERICFRAMEWORK_CORE_GFWWEIGHTSTABLE_H_
@@ -21,6 +21,7 @@
 #include "GFWPowerArray.h"
 #include "GFWWeights.h"
 #include "GFWWeightsList.h"
+#include "GFWWeightsTable.h"
 
 #include "PWGLF/DataModel/EPCalibrationTables.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
@@ -237,6 +238,8 @@ struct FlowGenericFramework {
     TH1D* mEfficiency = nullptr;
     std::vector<TH1D*> mPIDEfficiencies;
     std::vector<GFWWeights*> mAcceptance;
+    GFWWeightsTableCache mAcceptanceCache;
+    std::vector<const GFWWeightsTable*> mAcceptanceTables;
     bool correctionsLoaded = false;
   } cfg;
 
@@ -871,6 +874,10 @@ struct FlowGenericFramework {
       } else {
         cfg.mAcceptance.push_back(ccdb->getForTimeStamp<GFWWeights>(cfgAcceptance.value + runstr, timestamp));
       }
+      // lookup tables are built once per run, not at each retrieval
+      cfg.mAcceptanceTables.clear();
+      for (std::size_t i = 0; i < cfg.mAcceptance.size(); ++i)
+        cfg.mAcceptanceTables.push_back(&cfg.mAcceptanceCache.getNUA((cfgRunByRun) ? bc.runNumber() : 0, static_cast<int>(i), cfg.mAcceptance[i]));
     }
     if (!cfgEfficiency.value.empty()) {
       if (!cfgUsePIDEfficiencies) {
@@ -896,8 +903,8 @@ struct FlowGenericFramework {
   double getAcceptance(TTrack track, const double& vtxz, int index)
   { // 0 ref, 1 ch, 2 pi, 3 ka, 4 pr
     double wacc = 1;
-    if (!cfg.mAcceptance.empty())
-      wacc = cfg.mAcceptance[index]->getNUA(track.phi(), track.eta(), vtxz);
+    if (!cfg.mAcceptanceTables.empty())
+      wacc = cfg.mAcceptanceTables[index]->get(track.phi(), track.eta(), vtxz);
     return wacc;
   }
 
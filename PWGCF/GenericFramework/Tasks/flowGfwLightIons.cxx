@@ -21,6 +21,7 @@
 #include "GFWPowerArray.h"
 #include "GFWWeights.h"
 #include "GFWWeightsList.h"
+#include "GFWWeightsTable.h"
 
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/Centrality.h"
@@ -172,6 +173,8 @@ struct FlowGfwLightIons {
   struct Config {
     TH1D* mEfficiency = nullptr;
     GFWWeights* mAcceptance;
+    GFWWeightsTableCache mAcceptanceCache;
+    const GFWWeightsTable* mAcceptanceTable = nullptr;
     bool correctionsLoaded = false;
   } cfg;
 
@@ -636,6 +639,8 @@ struct FlowGfwLightIons {
     if (!cfgAcceptance.value.empty()) {
       std::string runstr = (cfgRunByRun) ? "RunByRun/" : "";
       cfg.mAcceptance = ccdb->getForTimeStamp<GFWWeights>(cfgAcceptance.value + runstr, timestamp);
+      // lookup table built once per run, not at each retrieval
+      cfg.mAcceptanceTable = (cfg.mAcceptance) ? &cfg.mAcceptanceCache.getNUA((cfgRunByRun) ? bc.runNumber() : 0, 0, cfg.mAcceptance) : nullptr;
     }
     if (!cfgEfficiency.value.empty()) {
       cfg.mEfficiency = ccdb->getForTimeStamp<TH1D>(cfgEfficiency, timestamp);
@@ -651,8 +656,8 @@ struct FlowGfwLightIons {
   double getAcceptance(TTrack track, const double& vtxz)
   {
     double wacc = 1;
-    if (cfg.mAcceptance)
-      wacc = cfg.mAcceptance->getNUA(track.phi(), track.eta(), vtxz);
+    if (cfg.mAcceptanceTable)
+      wacc = cfg.mAcceptanceTable->get(track.phi(), track.eta(), vtxz);
     return wacc;
   }
 
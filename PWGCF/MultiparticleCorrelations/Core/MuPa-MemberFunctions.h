@@ -14065,7 +14065,7 @@ TComplex Seven(int n1, int n2, int n3, int n4, int n5, int n6, int n7)
 
   int harmonic[7] = {n1, n2, n3, n4, n5, n6, n7};
 
-  TComplex seven = Recursion(7, harmonic);
+  TComplex seven = RecursionMemoised(7, harmonic);
 
   return seven;
 
@@ -14079,7 +14079,7 @@ TComplex Eight(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8)
 
   int harmonic[8] = {n1, n2, n3, n4, n5, n6, n7, n8};
 
-  TComplex eight = Recursion(8, harmonic);
+  TComplex eight = RecursionMemoised(8, harmonic);
 
   return eight;
 
@@ -14093,7 +14093,7 @@ TComplex Nine(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8, in
 
   int harmonic[9] = {n1, n2, n3, n4, n5, n6, n7, n8, n9};
 
-  TComplex nine = Recursion(9, harmonic);
+  TComplex nine = RecursionMemoised(9, harmonic);
 
   return nine;
 
@@ -14107,7 +14107,7 @@ TComplex Ten(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8, int
 
   int harmonic[10] = {n1, n2, n3, n4, n5, n6, n7, n8, n9, n10};
 
-  TComplex ten = Recursion(10, harmonic);
+  TComplex ten = RecursionMemoised(10, harmonic);
 
   return ten;
 
@@ -14121,7 +14121,7 @@ TComplex Eleven(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8,
 
   int harmonic[11] = {n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11};
 
-  TComplex eleven = Recursion(11, harmonic);
+  TComplex eleven = RecursionMemoised(11, harmonic);
 
   return eleven;
 
@@ -14135,7 +14135,7 @@ TComplex Twelve(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8,
 
   int harmonic[12] = {n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12};
 
-  TComplex twelve = Recursion(12, harmonic);
+  TComplex twelve = RecursionMemoised(12, harmonic);
 
   return twelve;
 
@@ -14185,6 +14185,117 @@ TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
 
 //============================================================
 
+TComplex RecursionMemoised(int n, int* harmonic)
+{
+  // Calculate multi-particle correlators as the sum over all set partitions of n particles, where each block B contributes
+  // (-1)^(|B|-1) * (|B|-1)! * Q(sum of harmonics in B, |B|). The block of one particle of the first non-empty class of
+  // equal harmonics is chosen first, and what remains depends only on how many particles of each class are left.
+  // The result for each such state is stored in a table and calculated only once, bottom-up: there are at most 2^n states
+  // (e.g. 4096 for n = 12), and only n+1 of them when all harmonics are the same, e.g. for <cos(n(phi1+...-phi8))>.
+  // Validated against Recursion(...) and nested loops, see ComparisonNestedLoopsVsCorrelations().
+
+  if (n < 1 || n > gMaxCorrelator) {
+    LOGF(fatal, "\033[1;31m%s at line %d : n = %d is not supported\033[0m", __FUNCTION__, __LINE__, n);
+  }
+
+  // a) Group the harmonics into classes of equal values;
+  // b) Mixed-radix index of a state, i.e. of the number of remaining particles in each class;
+  // c) Binomial coefficients and (-1)^(m-1) * (m-1)!;
+  // d) Calculate all states bottom-up. Removing a block always gives a state with a smaller index.
+
+  // a) Group the harmonics into classes of equal values:
+  int classHarmonic[gMaxCorrelator] = {0};
+  int classCount[gMaxCorrelator] = {0};
+  int nClasses = 0;
+  for (int i = 0; i < n; i++) {
+    int c = 0;
+    while (c < nClasses && classHarmonic[c] != harmonic[i]) {
+      c++;
+    }
+    if (c == nClasses) {
+      classHarmonic[nClasses++] = harmonic[i];
+    }
+    classCount[c]++;
+  }
+
+  // b) Mixed-radix index of a state:
+  int stride[gMaxCorrelator] = {0};
+  int nStates = 1;
+  for (int c = 0; c < nClasses; c++) {
+    stride[c] = nStates;
+    nStates *= classCount[c] + 1;
+  }
+
+  // c) Binomial coefficients and (-1)^(m-1) * (m-1)!:
+  double binomial[gMaxCorrelator + 1][gMaxCorrelator + 1] = {{0.}};
+  for (int i = 0; i <= n; i++) {
+    binomial[i][0] = 1.;
+    for (int j = 1; j <= i; j++) {
+      binomial[i][j] = binomial[i - 1][j - 1] + (j < i ? binomial[i - 1][j] : 0.);
+    }
+  }
+  double blockFactor[gMaxCorrelator + 1] = {0.}; // [m], for a block of m particles
+  blockFactor[1] = 1.;
+  for (int m = 2; m <= n; m++) {
+    blockFactor[m] = -1. * (m - 1) * blockFactor[m - 1];
+  }
+
+  // d) Calculate all states bottom-up:
+  std::vector<TComplex> memo(nStates, TComplex(0., 0.)); // [state index], correlator of the remaining particles
+  memo[0] = TComplex(1., 0.);
+  int remaining[gMaxCorrelator] = {0}; // [class], particles left in the state
+  int block[gMaxCorrelator] = {0};     // [class], particles of the class in the removed block
+  for (int s = 1; s < nStates; s++) {
+    int firstClass = -1;
+    for (int c = 0; c < nClasses; c++) {
+      remaining[c] = (s / stride[c]) % (classCount[c] + 1);
+      if (firstClass < 0 && remaining[c] > 0) {
+        firstClass = c;
+      }
+      block[c] = 0;
+    }
+    block[firstClass] = 1;
+
+    // loop over all blocks which contain one given particle of the first non-empty class:
+    TComplex sum(0., 0.);
+    while (true) {
+      int m = 0;
+      int h = 0;
+      int subState = s;
+      double coefficient = binomial[remaining[firstClass] - 1][block[firstClass] - 1];
+      for (int c = 0; c < nClasses; c++) {
+        m += block[c];
+        h += block[c] * classHarmonic[c];
+        subState -= block[c] * stride[c];
+        if (c != firstClass) {
+          coefficient *= binomial[remaining[c]][block[c]];
+        }
+      }
+      sum += coefficient * blockFactor[m] * Q(h, m) * memo[subState];
+
+      // next block:
+      int c = 0;
+      for (; c < nClasses; c++) {
+        if (block[c] < remaining[c]) {
+          block[c]++;
+          break;
+        }
+        block[c] = (c == firstClass) ? 1 : 0;
+      }
+      if (c == nClasses) {
+        break;
+      }
+    } // while (true)
+
+    memo[s] = sum;
+  } // for (int s = 1; s < nStates; s++)
+
+  return memo[nStates - 1];
+
+} // TComplex RecursionMemoised(int n, int* harmonic)
+
+//============================================================
+
 void ResetQ()
 {
   // Reset the components of generic Q-vectors. Use it whenever you call the
@@ -18494,7 +18605,6 @@ void FillQvectorFromSparse()
   double wPt = 1.;       // differential multidimensional pt weight, its dimensions are defined via enum eDiffPtWeights
   double wEta = 1.;      // differential multidimensional eta weight, its dimensions are defined via enum eDiffEtaWeights
   double wCharge = 1.;   // differential multidimensional charge weight, its dimensions are defined via enum eDiffChargeWeights
-  double wToPowerP = 1.; // weight raised to power p
 
   // *) Multidimensional phi weights:
   if (pw.fUseDiffPhiWeights[wPhiPhiAxis]) { // yes, 0th axis serves as a common boolean for this category
@@ -18578,19 +18688,30 @@ void FillQvectorFromSparse()
     }
   } // if(pw.fUseDiffChargeWeights[wChargeChargeAxis])
 
+  // Phases exp(i*h*phi) for all harmonics, from cos(phi) and sin(phi) by angle addition, instead of calling std::cos and std::sin
+  // for each harmonic and each weight power. After gMaxHarmonic*gMaxCorrelator steps, the rounding error is still ~1e-14.
+  double cosH[gMaxHarmonic * gMaxCorrelator + 1] = {1.}; // [h], cos(h*phi)
+  double sinH[gMaxHarmonic * gMaxCorrelator + 1] = {0.}; // [h], sin(h*phi)
+  if (qv.fCalculateQvectors || es.fCalculateEtaSeparations) {
+    const double cosPhi = std::cos(pbyp.fPhi);
+    const double sinPhi = std::sin(pbyp.fPhi);
+    const int nHarmonics = qv.fCalculateQvectors ? gMaxHarmonic * gMaxCorrelator + 1 : gMaxHarmonic + 1;
+    for (int h = 1; h < nHarmonics; h++) {
+      cosH[h] = cosH[h - 1] * cosPhi - sinH[h - 1] * sinPhi;
+      sinH[h] = sinH[h - 1] * cosPhi + cosH[h - 1] * sinPhi;
+    }
+  }
+
   if (qv.fCalculateQvectors) {
+    // Weight raised to power p, calculated once for all harmonics (all powers are 1 without weights):
+    double wToPowerP[gMaxCorrelator + 1] = {1.}; // [wp]
+    for (int wp = 1; wp < gMaxCorrelator + 1; wp++) {
+      wToPowerP[wp] = wToPowerP[wp - 1] * wPhi * wPt * wEta * wCharge;
+    }
     for (int h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
       for (int wp = 0; wp < gMaxCorrelator + 1; wp++) { // weight power
-        if (pw.fUseDiffPhiWeights[wPhiPhiAxis] || pw.fUseDiffPtWeights[wPtPtAxis] || pw.fUseDiffEtaWeights[wEtaEtaAxis] || pw.fUseDiffChargeWeights[wChargeChargeAxis]) {
-          wToPowerP = std::pow(wPhi * wPt * wEta * wCharge, wp);
-          qv.fQvector[h][wp] += TComplex(wToPowerP * std::cos(h * pbyp.fPhi), wToPowerP * std::sin(h * pbyp.fPhi)); // Q-vector with weights, legacy code (TBI 20251027 remove this line)
-          // qv.fQvector[h][wp] += std::complex<double>(wToPowerP * std::cos(h * pbyp.fPhi), wToPowerP * std::sin(h * pbyp.fPhi)); // Q-vector with weights, new code
-          // TBI 20251028 I have to keep it this way for the time being, otherwise I have to change all over the place, e.g. in TComplex Q(int n, int wp), etc.
-        } else {
-          qv.fQvector[h][wp] += TComplex(std::cos(h * pbyp.fPhi), std::sin(h * pbyp.fPhi)); // bare Q-vector without weights, legacy code (TBI 20251027 remove this line)
-          // qv.fQvector[h][wp] += std::complex<double>(std::cos(h * pbyp.fPhi), std::sin(h * pbyp.fPhi)); // bare Q-vector without weights, new code
-          // TBI 20251028 I have to keep it this way for the time being, otherwise I have to change all over the place, e.g. in TComplex Q(int n, int wp), etc.
-        }
+        qv.fQvector[h][wp] += TComplex(wToPowerP[wp] * cosH[h], wToPowerP[wp] * sinH[h]); // Q-vector, legacy code (TBI 20251027 switch to std::complex<double>)
+        // TBI 20251028 I have to keep TComplex for the time being, otherwise I have to change all over the place, e.g. in TComplex Q(int n, int wp), etc.
       } // for(int wp=0;wp<gMaxCorrelator+1;wp++)
     } // for(int h=0;h<gMaxHarmonic*gMaxCorrelator+1;h++)
   } // if (qv.fCalculateQvectors) {
@@ -18605,7 +18726,7 @@ void FillQvectorFromSparse()
             if (es.fEtaSeparationsSkipHarmonics[h]) {
               continue;
             }
-            qv.fQabVector[0][h][e] += TComplex(wPhi * wPt * wEta * wCharge * std::cos((h + 1) * pbyp.fPhi), wPhi * wPt * wEta * wCharge * std::sin((h + 1) * pbyp.fPhi));
+            qv.fQabVector[0][h][e] += TComplex(wPhi * wPt * wEta * wCharge * cosH[h + 1], wPhi * wPt * wEta * wCharge * sinH[h + 1]);
             // Remark: I can hardwire linear weights like this only for 2-p correlations
             // TBI 20251028 Replace TComplex with std::complex<double> (but it's a major modification, see the comment above within if (qv.fCalculateQvectors) )
           }
@@ -18620,7 +18741,7 @@ void FillQvectorFromSparse()
               if (es.fEtaSeparationsSkipHarmonics[h]) {
                 continue;
               }
-              qv.fQabVector[1][h][e] += TComplex(wPhi * wPt * wEta * wCharge * std::cos((h + 1) * pbyp.fPhi), wPhi * wPt * wEta * wCharge * std::sin((h + 1) * pbyp.fPhi));
+              qv.fQabVector[1][h][e] += TComplex(wPhi * wPt * wEta * wCharge * cosH[h + 1], wPhi * wPt * wEta * wCharge * sinH[h + 1]);
               // TBI 20251028 Replace TComplex with std::complex<double> (but it's a major modification, see the comment above within if (qv.fCalculateQvectors) )
               // Remark: I can hardwire linear weights like this only for 2-p correlations
             }
@@ -19529,16 +19650,25 @@ void FillqvectorFromSparse(const eqvectorKine& kineVarChoice, const int& bin, co
   }
 
   // *) Finally, fill differential q-vector in that linearized "global bin":
-  double wToPowerP = 1.; // weight raised to power p
+  //    Phases and powers of the weight are calculated once, as in FillQvectorFromSparse() (all powers are 1 without weights):
+  double cosH[gMaxHarmonic * gMaxCorrelator + 1] = {1.}; // [h], cos(h*phi)
+  double sinH[gMaxHarmonic * gMaxCorrelator + 1] = {0.}; // [h], sin(h*phi)
+  const double cosPhi = std::cos(pbyp.fPhi);
+  const double sinPhi = std::sin(pbyp.fPhi);
+  for (int h = 1; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
+    cosH[h] = cosH[h - 1] * cosPhi - sinH[h - 1] * sinPhi;
+    sinH[h] = sinH[h - 1] * cosPhi + cosH[h - 1] * sinPhi;
+  }
+  // Remark: the first enum serves as a boolean for each category of weights
+  const bool useWeights = pw.fUseDiffPhiWeights[wPhiPhiAxis] || pw.fUseDiffPtWeights[wPtPtAxis] || pw.fUseDiffEtaWeights[wEtaEtaAxis] || pw.fUseDiffChargeWeights[wChargeChargeAxis];
+  double wToPowerP[gMaxCorrelator + 1] = {1.}; // [wp], dWeight = wPhi * wPt * wEta * wcharge raised to power p
+  for (int wp = 1; wp < gMaxCorrelator + 1; wp++) {
+    wToPowerP[wp] = useWeights ? wToPowerP[wp - 1] * dWeight : 1.;
+  }
 
   for (int h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
-    for (int wp = 0; wp < gMaxCorrelator + 1; wp++) {                                                                                                                   // weight power
-      if (pw.fUseDiffPhiWeights[wPhiPhiAxis] || pw.fUseDiffPtWeights[wPtPtAxis] || pw.fUseDiffEtaWeights[wEtaEtaAxis] || pw.fUseDiffChargeWeights[wChargeChargeAxis]) { // yes, because the first enum serves as a boolean for that category
-        wToPowerP = std::pow(dWeight, wp);                                                                                                                              // dWeight = wPhi * wPt * wEta * wcharge
-        qv.fqvector[kineVarChoice][bin][h][wp] += std::complex<double>(wToPowerP * std::cos(h * pbyp.fPhi), wToPowerP * std::sin(h * pbyp.fPhi));                       // q-vector with weights
-      } else {
-        qv.fqvector[kineVarChoice][bin][h][wp] += std::complex<double>(std::cos(h * pbyp.fPhi), std::sin(h * pbyp.fPhi)); // bare q-vector without weights
-      }
+    for (int wp = 0; wp < gMaxCorrelator + 1; wp++) { // weight power
+      qv.fqvector[kineVarChoice][bin][h][wp] += std::complex<double>(wToPowerP[wp] * cosH[h], wToPowerP[wp] * sinH[h]); // q-vector (with weights, if used)
     } // for(int wp=0;wp<gMaxCorrelator+1;wp++)
   } // for (int h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++)
 
@@ -42,6 +42,8 @@
 #include <TVector2.h>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <experimental/type_traits>
 #include <memory>
 #include <string>
@@ -149,7 +151,48 @@ struct CorrelationTask {
   OutputObj<CorrelationContainer> mixed{"mixedEvent"};
 
   // persistent caches
-  std::vector<float> efficiencyAssociatedCache;
+  // associated particles passing the single-particle selections of the current event, one array per column
+  struct AssociatedCache {
+    std::vector<float> eta;
+    std::vector<float> phi;
+    std::vector<float> pt;
+    std::vector<float> efficiency; // efficiency correction, 1 if not applied
+    std::vector<int64_t> globalIndex;
+    std::vector<int64_t> row; // position in the table, to access the track for the pair cuts
+    // only filled if the table has the column
+    std::vector<int8_t> sign;
+    std::vector<uint8_t> decay;
+    std::vector<float> invMass;
+    std::vector<int> prong0Id;
+    std::vector<int> prong1Id;
+
+    std::size_t size() const { return eta.size(); }
+    void clear()
+    {
+      eta.clear();
+      phi.clear();
+      pt.clear();
+      efficiency.clear();
+      globalIndex.clear();
+      row.clear();
+      sign.clear();
+      decay.clear();
+      invMass.clear();
+      prong0Id.clear();
+      prong1Id.clear();
+    }
+  } associatedCache;
+  // accepted pairs of the current trigger particle
+  struct PairCache {
+    std::vector<std::size_t> associated; // index in AssociatedCache
+    std::vector<float> deltaEta;
+    std::vector<float> deltaPhi;
+    std::vector<float> ptAssociated;
+    std::vector<float> massAssociated;
+    std::vector<float> weight;
+
+    void clear() { associated.clear(); }
+  } pairCache;
   std::vector<int> p2indexCache;
 
   std::unique_ptr<TFormula> multCutFormula;
@@ -293,8 +336,6 @@ struct CorrelationTask {
     same->setTrackEtaCut(cfgCutEta);
     mixed->setTrackEtaCut(cfgCutEta);
 
-    if (!cfgEfficiencyAssociated.value.empty())
-      efficiencyAssociatedCache.reserve(512);
     if (doprocessMCEfficiency2Prong || doprocessMCEfficiency2ProngML || doprocessMCReflection2ProngML) {
       p2indexCache.reserve(16);
       if (cfgMcTriggerPDGs->empty())
@@ -542,19 +583,91 @@ struct CorrelationTask {
     return {true, 0.5f * std::log((E + pz) / (E - pz))};
   }
 
-  template <CorrelationContainer::CFStep step, typename TTarget, typename TTracks1, typename TTracks2>
-  void fillCorrelations(TTarget target, TTracks1& tracks1, TTracks2& tracks2, float multiplicity, float posZ, int magField, float eventWeight)
+  template <CorrelationContainer::CFStep step, typename TTracks>
+  void fillAssociatedCache(TTracks& tracks2, float multiplicity, float posZ)
   {
-    // Cache efficiency for particles (too many FindBin lookups)
-    if constexpr (step == CorrelationContainer::kCFStepCorrected) {
-      if (cfg.mEfficiencyAssociated) {
-        efficiencyAssociatedCache.clear();
-        efficiencyAssociatedCache.reserve(tracks2.size());
-        for (const auto& track : tracks2) {
-          efficiencyAssociatedCache.push_back(getEfficiencyCorrection(cfg.mEfficiencyAssociated, track.eta(), track.pt(), multiplicity, posZ));
+    auto& associated = associatedCache;
+    associated.clear();
+
+    int64_t row = -1;
+    for (const auto& track2 : tracks2) {
+      ++row;
+      if constexpr (std::experimental::is_detected<HasPDGCode, typename TTracks::iterator>::value) { // skip those that are specifically chosen to be triggers
+        if (!cfgMcTriggerPDGs->empty() && std::find(cfgMcTriggerPDGs->begin(), cfgMcTriggerPDGs->end(), track2.pdgCode()) != cfgMcTriggerPDGs->end())
+          continue; // TODO: fix cases like MC D0-D0
+      }
+
+      if constexpr (step <= CorrelationContainer::kCFStepTracked && !std::experimental::is_detected<HasDecay, typename TTracks::iterator>::value) {
+        if (!checkObject<step>(track2)) {
+          continue;
         }
       }
+
+      // If decay attributes are found for the second track/particle, we assume 2p-2p correlation
+      if constexpr (std::experimental::is_detected<HasMcDecay, typename TTracks::iterator>::value) {
+        if ((((track2.mcDecay()) != aod::cf2prongtrack::D0ToPiK) && ((track2.mcDecay()) != aod::cf2prongtrack::D0barToKPiExclusive)) || (!cfgPtCentDepMLpromptSel->empty() && (track2.decay() & aod::cf2prongmcpart::Prompt) == 0))
+          continue;
+      } else if constexpr (std::experimental::is_detected<HasDecay, typename TTracks::iterator>::value) {
+        if (cfgDecayParticleMask != 0 && (cfgDecayParticleMask & (1u << static_cast<uint32_t>(track2.decay()))) == 0u) {
+          continue; // skip particles that do not match the decay mask
+        }
+        // track2 here is charged hadron so we don't need rapidity cut for this track...this rapidity is only needed for V0
+      }
+
+      if constexpr (std::experimental::is_detected<HasSign, typename TTracks::iterator>::value) {
+        // TODO: support for MC D0-D0 case
+        if (cfgAssociatedCharge != 0) {
+          if (cfgAssociatedCharge * track2.sign() < 0)
+            continue;
+        } else if (track2.sign() == 0) { // mc particles come in neutrals, need to check explicitly
+          continue;
+        }
+      }
+
+      if constexpr (std::experimental::is_detected<HasMlProbD0, typename TTracks::iterator>::value) {
+        if (!passMLScore(track2))
+          continue;
+      } // ML selection
+
+      associated.eta.push_back(track2.eta());
+      associated.phi.push_back(track2.phi());
+      associated.pt.push_back(track2.pt());
+      associated.globalIndex.push_back(track2.globalIndex());
+      associated.row.push_back(row);
+      float efficiency = 1.0f;
+      if constexpr (step == CorrelationContainer::kCFStepCorrected) {
+        if (cfg.mEfficiencyAssociated) {
+          efficiency = getEfficiencyCorrection(cfg.mEfficiencyAssociated, track2.eta(), track2.pt(), multiplicity, posZ);
+        }
+      }
+      associated.efficiency.push_back(efficiency);
+      if constexpr (std::experimental::is_detected<HasSign, typename TTracks::iterator>::value) {
+        associated.sign.push_back(track2.sign());
+      }
+      if constexpr (std::experimental::is_detected<HasDecay, typename TTracks::iterator>::value) {
+        associated.decay.push_back(track2.decay());
+      }
+      if constexpr (std::experimental::is_detected<HasInvMass, typename TTracks::iterator>::value) {
+        associated.invMass.push_back(track2.invMass());
+      }
+      if constexpr (std::experimental::is_detected<HasProng0Id, typename TTracks::iterator>::value) {
+        associated.prong0Id.push_back(track2.cfTrackProng0Id());
+      }
+      if constexpr (std::experimental::is_detected<HasProng1Id, typename TTracks::iterator>::value) {
+        associated.prong1Id.push_back(track2.cfTrackProng1Id());
+      }
     }
+  }
+
+  template <CorrelationContainer::CFStep step, typename TTarget, typename TTracks1, typename TTracks2>
+  void fillCorrelations(TTarget target, TTracks1& tracks1, TTracks2& tracks2, float multiplicity, float posZ, int magField, float eventWeight)
+  {
+    // The selections which only depend on the associated particle are applied once per event, and the accepted particles are compacted
+    // together with their efficiency correction (too many FindBin lookups otherwise)
+    fillAssociatedCache<step>(tracks2, multiplicity, posZ);
+    const auto& associated = associatedCache;
+    const bool fillMassAxisPair = cfgMassAxis && (doprocessSame2Prong2Prong || doprocessMixed2Prong2Prong || doprocessSame2Prong2ProngML || doprocessMixed2Prong2ProngML) && !(doprocessSame2ProngDerived || doprocessSame2ProngDerivedML || doprocessMixed2ProngDerived || doprocessMixed2ProngDerivedML);
+    const bool applyPairCuts = cfg.mPairCuts || cfgTwoTrackCut > 0;
 
     for (const auto& track1 : tracks1) {
       // LOGF(info, "Track %f | %f | %f  %d %d", track1.eta(), track1.phi(), track1.pt(), track1.isGlobalTrack(), track1.isGlobalTrackSDD());
@@ -631,75 +744,52 @@ struct CorrelationTask {
         target->getTriggerHist()->Fill(step, track1.pt(), multiplicity, posZ, triggerWeight);
       }
 
-      for (const auto& track2 : tracks2) {
+      // pair selections, and pair variables of the accepted pairs
+      const float eta1 = track1.eta();
+      const float phi1 = track1.phi();
+      const float pt1 = track1.pt();
+      auto& pairs = pairCache;
+      pairs.clear();
+      for (std::size_t i = 0; i < associated.size(); ++i) {
         if constexpr (std::is_same<TTracks1, TTracks2>::value) {
-          if (track1.globalIndex() == track2.globalIndex()) {
-            // LOGF(info, "Track identical: %f | %f | %f || %f | %f | %f", track1.eta(), track1.phi(), track1.pt(),  track2.eta(), track2.phi(), track2.pt());
+          if (track1.globalIndex() == associated.globalIndex[i]) {
             continue;
           }
         }
-        if constexpr (std::experimental::is_detected<HasPDGCode, typename TTracks2::iterator>::value) { // skip those that are specifically chosen to be triggers
-          if (!cfgMcTriggerPDGs->empty() && std::find(cfgMcTriggerPDGs->begin(), cfgMcTriggerPDGs->end(), track2.pdgCode()) != cfgMcTriggerPDGs->end())
-            continue; // TODO: fix cases like MC D0-D0
-        }
 
         // Daughter track and particle checks
         if constexpr (std::experimental::is_detected<HasProng0Id, typename TTracks1::iterator>::value) {
-          if (track2.globalIndex() == track1.cfTrackProng0Id()) // do not correlate daughter tracks of the same event
+          if (associated.globalIndex[i] == track1.cfTrackProng0Id()) // do not correlate daughter tracks of the same event
             continue;
         }
         if constexpr (std::experimental::is_detected<HasProng1Id, typename TTracks1::iterator>::value) {
-          if (track2.globalIndex() == track1.cfTrackProng1Id()) // do not correlate daughter tracks of the same event
+          if (associated.globalIndex[i] == track1.cfTrackProng1Id()) // do not correlate daughter tracks of the same event
             continue;
         }
         if constexpr (std::experimental::is_detected<HasPartDaugh0Id, typename TTracks1::iterator>::value) {
-          if (track2.globalIndex() == track1.cfParticleDaugh0Id()) // do not correlate daughter particles of the same event
+          if (associated.globalIndex[i] == track1.cfParticleDaugh0Id()) // do not correlate daughter particles of the same event
             continue;
         }
         if constexpr (std::experimental::is_detected<HasPartDaugh1Id, typename TTracks1::iterator>::value) {
-          if (track2.globalIndex() == track1.cfParticleDaugh1Id()) // do not correlate daughter particles of the same event
+          if (associated.globalIndex[i] == track1.cfParticleDaugh1Id()) // do not correlate daughter particles of the same event
             continue;
         }
 
-        if constexpr (step <= CorrelationContainer::kCFStepTracked && !std::experimental::is_detected<HasDecay, typename TTracks2::iterator>::value) {
-          if (!checkObject<step>(track2)) {
-            continue;
-          }
-        }
-
-        // If decay attributes are found for the second track/particle, we assume 2p-2p correlation
-        if constexpr (std::experimental::is_detected<HasMcDecay, typename TTracks2::iterator>::value) {
-          if ((((track2.mcDecay()) != aod::cf2prongtrack::D0ToPiK) && ((track2.mcDecay()) != aod::cf2prongtrack::D0barToKPiExclusive)) || (!cfgPtCentDepMLpromptSel->empty() && (track2.decay() & aod::cf2prongmcpart::Prompt) == 0))
-            continue;
-        } else if constexpr (std::experimental::is_detected<HasDecay, typename TTracks2::iterator>::value) {
-          if (cfgDecayParticleMask != 0 && (cfgDecayParticleMask & (1u << static_cast<uint32_t>(track2.decay()))) == 0u) {
-            continue; // skip particles that do not match the decay mask
-          }
-
-          // track2 here is charged hadron so we don't need rapidity cut for this track...this rapidity is only needed for V0
-          /*
-            if (cfgV0RapidityMax > 0) {
-            auto [t, y] = getV0Rapidity(track2);
-                  if (t && std::abs(y) > cfgV0RapidityMax)
-            continue;
-            }*/
-        }
-
         if constexpr (std::experimental::is_detected<HasDecay, typename TTracks1::iterator>::value && std::experimental::is_detected<HasDecay, typename TTracks2::iterator>::value) {
-          if (cfgCorrelationMethod == 1 && track1.decay() != track2.decay())
+          if (cfgCorrelationMethod == 1 && track1.decay() != associated.decay[i])
             continue;
-          if (cfgCorrelationMethod == 2 && track1.decay() == track2.decay())
+          if (cfgCorrelationMethod == 2 && track1.decay() == associated.decay[i])
             continue;
         }
 
         if constexpr (std::experimental::is_detected<HasProng0Id, typename TTracks1::iterator>::value) {
           if constexpr (std::experimental::is_detected<HasProng0Id, typename TTracks2::iterator>::value) {
-            if (track1.cfTrackProng0Id() == track2.cfTrackProng0Id()) {
+            if (track1.cfTrackProng0Id() == associated.prong0Id[i]) {
               continue;
             }
           }
           if constexpr (std::experimental::is_detected<HasProng1Id, typename TTracks2::iterator>::value) {
-            if (track1.cfTrackProng0Id() == track2.cfTrackProng1Id()) {
+            if (track1.cfTrackProng0Id() == associated.prong1Id[i]) {
               continue;
             }
           }
@@ -707,34 +797,24 @@ struct CorrelationTask {
 
         if constexpr (std::experimental::is_detected<HasProng1Id, typename TTracks1::iterator>::value) {
           if constexpr (std::experimental::is_detected<HasProng0Id, typename TTracks2::iterator>::value) {
-            if (track1.cfTrackProng1Id() == track2.cfTrackProng0Id()) {
+            if (track1.cfTrackProng1Id() == associated.prong0Id[i]) {
               continue;
             }
           }
           if constexpr (std::experimental::is_detected<HasProng1Id, typename TTracks2::iterator>::value) {
-            if (track1.cfTrackProng1Id() == track2.cfTrackProng1Id()) {
+            if (track1.cfTrackProng1Id() == associated.prong1Id[i]) {
               continue;
             }
           }
         } // no shared prong for two mothers
         // TODO MC daughters check ^^
 
-        if (cfgPtOrder != 0 && track2.pt() >= track1.pt()) {
+        if (cfgPtOrder != 0 && associated.pt[i] >= pt1) {
           continue;
         }
 
-        if constexpr (std::experimental::is_detected<HasSign, typename TTracks2::iterator>::value) {
-          // TODO: support for MC D0-D0 case
-          if (cfgAssociatedCharge != 0) {
-            if (cfgAssociatedCharge * track2.sign() < 0)
-              continue;
-          } else if (track2.sign() == 0) { // mc particles come in neutrals, need to check explicitly
-            continue;
-          }
-        }
-
         if constexpr (std::experimental::is_detected<HasSign, typename TTracks1::iterator>::value && std::experimental::is_detected<HasSign, typename TTracks2::iterator>::value) {
-          if (cfgPairCharge != 0 && cfgPairCharge * track1.sign() * track2.sign() < 0) {
+          if (cfgPairCharge != 0 && cfgPairCharge * track1.sign() * associated.sign[i] < 0) {
             continue;
           }
         }
@@ -742,48 +822,59 @@ struct CorrelationTask {
         if constexpr (std::is_same<TTracks1, TTracks2>::value) {
           if constexpr (step >= CorrelationContainer::kCFStepReconstructed) {
             if constexpr (std::experimental::is_detected<HasSign, typename TTracks1::iterator>::value && std::experimental::is_detected<HasSign, typename TTracks2::iterator>::value) {
-              if (cfg.mPairCuts && mPairCuts.conversionCuts(track1, track2)) {
-                continue;
-              }
-              if (cfgTwoTrackCut > 0 && mPairCuts.twoTrackCut(track1, track2, magField)) {
-                continue;
+              if (applyPairCuts) {
+                auto track2 = tracks2.iteratorAt(associated.row[i]);
+                if (cfg.mPairCuts && mPairCuts.conversionCuts(track1, track2)) {
+                  continue;
+                }
+                if (cfgTwoTrackCut > 0 && mPairCuts.twoTrackCut(track1, track2, magField)) {
+                  continue;
+                }
               }
             }
           }
         }
 
-        float associatedWeight = triggerWeight;
-        if constexpr (step == CorrelationContainer::kCFStepCorrected) {
-          if (cfg.mEfficiencyAssociated) {
-            associatedWeight *= efficiencyAssociatedCache[track2.filteredIndex()];
-          }
-        }
+        pairs.associated.push_back(i);
+      }
 
-        float deltaPhi = RecoDecay::constrainAngle(track1.phi() - track2.phi(), -o2::constants::math::PIHalf);
+      const std::size_t nPairs = pairs.associated.size();
+      pairs.deltaEta.resize(nPairs);
+      pairs.deltaPhi.resize(nPairs);
+      pairs.ptAssociated.resize(nPairs);
+      pairs.weight.resize(nPairs);
+      for (std::size_t iPair = 0; iPair < nPairs; ++iPair) {
+        const auto i = pairs.associated[iPair];
+        pairs.deltaEta[iPair] = eta1 - associated.eta[i];
+        pairs.deltaPhi[iPair] = RecoDecay::constrainAngle(phi1 - associated.phi[i], -o2::constants::math::PIHalf);
+        pairs.ptAssociated[iPair] = associated.pt[i];
+        pairs.weight[iPair] = triggerWeight * associated.efficiency[i];
+      }
 
-        if constexpr (std::experimental::is_detected<HasMlProbD0, typename TTracks2::iterator>::value) {
-          if (!passMLScore(track2))
-            continue;
-        } // ML selection
-
-        // last param is the weight
-        if (cfgMassAxis && (doprocessSame2Prong2Prong || doprocessMixed2Prong2Prong || doprocessSame2Prong2ProngML || doprocessMixed2Prong2ProngML) && !(doprocessSame2ProngDerived || doprocessSame2ProngDerivedML || doprocessMixed2ProngDerived || doprocessMixed2ProngDerivedML)) {
-          if constexpr (std::experimental::is_detected<HasInvMass, typename TTracks1::iterator>::value && std::experimental::is_detected<HasInvMass, typename TTracks2::iterator>::value)
-            target->getPairHist()->Fill(step, track1.eta() - track2.eta(), track2.pt(), track1.pt(), multiplicity, deltaPhi, posZ, track2.invMass(), track1.invMass(), associatedWeight);
-          else
-            LOGF(fatal, "Can not fill mass axis without invMass column. \n no mass for two particles");
-        } else if (cfgMassAxis) {
-          if constexpr (std::experimental::is_detected<HasInvMass, typename TTracks1::iterator>::value)
-            target->getPairHist()->Fill(step, track1.eta() - track2.eta(), track2.pt(), track1.pt(), multiplicity, deltaPhi, posZ, track1.invMass(), associatedWeight);
-          else if constexpr (std::experimental::is_detected<HasPDGCode, typename TTracks1::iterator>::value) {
-            // TParticlePDG *p = pdg->GetParticle(track1.pdgCode()); //TODO: get the mass for the PDG properly
-            target->getPairHist()->Fill(step, track1.eta() - track2.eta(), track2.pt(), track1.pt(), multiplicity, deltaPhi, posZ, 1.8, associatedWeight); // p->Mass()
-          } else {
-            LOGF(fatal, "Can not fill mass axis without invMass column. Disable cfgMassAxis.");
+      if (fillMassAxisPair) {
+        if constexpr (std::experimental::is_detected<HasInvMass, typename TTracks1::iterator>::value && std::experimental::is_detected<HasInvMass, typename TTracks2::iterator>::value) {
+          pairs.massAssociated.resize(nPairs);
+          for (std::size_t iPair = 0; iPair < nPairs; ++iPair) {
+            pairs.massAssociated[iPair] = associated.invMass[pairs.associated[iPair]];
           }
-        } else {
-          target->getPairHist()->Fill(step, track1.eta() - track2.eta(), track2.pt(), track1.pt(), multiplicity, deltaPhi, posZ, associatedWeight);
+          const double massTrigger = track1.invMass();
+          target->fillPairs(step, nPairs, pairs.deltaEta.data(), pairs.ptAssociated.data(), pairs.deltaPhi.data(), pairs.weight.data(), pt1, multiplicity, posZ, pairs.massAssociated.data(), &massTrigger);
+        } else if (nPairs > 0) {
+          LOGF(fatal, "Can not fill mass axis without invMass column. \n no mass for two particles");
+        }
+      } else if (cfgMassAxis) {
+        if constexpr (std::experimental::is_detected<HasInvMass, typename TTracks1::iterator>::value) {
+          const double massTrigger = track1.invMass();
+          target->fillPairs(step, nPairs, pairs.deltaEta.data(), pairs.ptAssociated.data(), pairs.deltaPhi.data(), pairs.weight.data(), pt1, multiplicity, posZ, nullptr, &massTrigger);
+        } else if constexpr (std::experimental::is_detected<HasPDGCode, typename TTracks1::iterator>::value) {
+          // TParticlePDG *p = pdg->GetParticle(track1.pdgCode()); //TODO: get the mass for the PDG properly
+          const double massTrigger = 1.8; // p->Mass()
+          target->fillPairs(step, nPairs, pairs.deltaEta.data(), pairs.ptAssociated.data(), pairs.deltaPhi.data(), pairs.weight.data(), pt1, multiplicity, posZ, nullptr, &massTrigger);
+        } else if (nPairs > 0) {
+          LOGF(fatal, "Can not fill mass axis without invMass column. Disable cfgMassAxis.");
         }
+      } else {
+        target->fillPairs(step, nPairs, pairs.deltaEta.data(), pairs.ptAssociated.data(), pairs.deltaPhi.data(), pairs.weight.data(), pt1, multiplicity, posZ);
       }
     }
   }
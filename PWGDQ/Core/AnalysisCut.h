@@ -68,6 +68,8 @@ class AnalysisCut : public TNamed
     TF1* fFuncHigh; // function for the upper limit cut
   };
 
+  const std::vector<CutContainer>& GetCuts() const { return fCuts; }
+
  protected:
   std::vector<CutContainer> fCuts;
 
@@ -0,0 +1,192 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PWGDQ/Core/AnalysisCutProgram.h"
+
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/AnalysisCut.h"
+
+#include <Framework/Logger.h>
+
+#include <TF1.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//____________________________________________________________________________
+int AnalysisCutProgram::AddCut(const AnalysisCut* cut, int nFuncPoints)
+{
+  //
+  // Compile a cut and append its tests to the program
+  //
+  // The tests are generated starting from the last one to be evaluated, such that the jump targets are always known.
+  //   They are then stored in reverse order, so that the evaluation runs forward through the test arrays
+  std::vector<Test> tests;
+  int entry = kReject;
+  if (cut->IsA() == AnalysisCompositeCut::Class()) {
+    entry = CompileCompositeCut(*(static_cast<const AnalysisCompositeCut*>(cut)), kAccept, kReject, tests);
+  } else {
+    entry = CompileCut(*cut, kAccept, kReject, tests);
+  }
+
+  int offset = fVar.size();
+  int nTests = tests.size();
+  auto remap = [offset, nTests](int target) {
+    return (target < 0 ? target : offset + nTests - 1 - target);
+  };
+  for (auto test = tests.rbegin(); test != tests.rend(); ++test) {
+    const AnalysisCut::CutContainer* c = test->fCut;
+    fVar.push_back(c->fVar);
+    fLow.push_back(c->fLow);
+    fHigh.push_back(c->fHigh);
+    fExclude.push_back(c->fExclude);
+    fDepVar.push_back(c->fDepVar);
+    fDepLow.push_back(c->fDepLow);
+    fDepHigh.push_back(c->fDepHigh);
+    fDepExclude.push_back(c->fDepExclude);
+    fDepVar2.push_back(c->fDepVar2);
+    fDep2Low.push_back(c->fDep2Low);
+    fDep2High.push_back(c->fDep2High);
+    fDep2Exclude.push_back(c->fDep2Exclude);
+    fFuncLow.push_back(c->fFuncLow ? AddFunction(c->fFuncLow, nFuncPoints) : -1);
+    fFuncHigh.push_back(c->fFuncHigh ? AddFunction(c->fFuncHigh, nFuncPoints) : -1);
+    fOnPass.push_back(remap(test->fOnPass));
+    fOnFail.push_back(remap(test->fOnFail));
+  }
+  fEntries.push_back(remap(entry));
+  return fEntries.size() - 1;
+}
+
+//____________________________________________________________________________
+int AnalysisCutProgram::CompileCut(const AnalysisCut& cut, int onPass, int onFail, std::vector<Test>& tests) const
+{
+  //
+  // A simple cut is passed if all its cut containers are passed
+  // Returns the index of the first test to be evaluated
+  //
+  int entry = onPass;
+  const auto& containers = cut.GetCuts();
+  for (auto c = containers.rbegin(); c != containers.rend(); ++c) {
+    tests.push_back({&(*c), entry, onFail});
+    entry = tests.size() - 1;
+  }
+  return entry;
+}
+
+//____________________________________________________________________________
+int AnalysisCutProgram::CompileCompositeCut(const AnalysisCompositeCut& cut, int onPass, int onFail, std::vector<Test>& tests) const
+{
+  //
+  // A composite cut evaluates first the list of simple cuts and then the list of composite cuts (see AnalysisCompositeCut::IsSelected),
+  //   stopping at the first failed cut (AND) or at the first passed cut (OR)
+  // Returns the index of the first test to be evaluated
+  //
+  bool useAND = cut.GetUseAND();
+  int entry = (useAND ? onPass : onFail); // decision if none of the cuts triggers the short-circuit
+  const auto& compositeCuts = cut.GetCompositeCutList();
+  for (auto c = compositeCuts.rbegin(); c != compositeCuts.rend(); ++c) {
+    entry = (useAND ? CompileCompositeCut(*c, entry, onFail, tests) : CompileCompositeCut(*c, onPass, entry, tests));
+  }
+  const auto& cuts = cut.GetCutList();
+  for (auto c = cuts.rbegin(); c != cuts.rend(); ++c) {
+    entry = (useAND ? CompileCut(*c, entry, onFail, tests) : CompileCut(*c, onPass, entry, tests));
+  }
+  return entry;
+}
+
+//____________________________________________________________________________
+int AnalysisCutProgram::AddFunction(TF1* func, int nPoints)
+{
+  //
+  // Register a function used as a cut limit and tabulate it if requested
+  //
+  for (std::size_t i = 0; i < fFunctions.size(); ++i) {
+    if (fFunctions[i] == func && fFuncNPoints[i] == (nPoints > 1 ? nPoints : 0)) {
+      return i;
+    }
+  }
+
+  fFunctions.push_back(func);
+  fFuncOffset.push_back(fFuncTable.size());
+  double xmin = func->GetXmin();
+  double xmax = func->GetXmax();
+  if (nPoints < 2 || !(xmax > xmin)) {
+    if (nPoints > 0) {
+      LOG(warn) << "AnalysisCutProgram::AddFunction(): function " << func->GetName() << " cannot be tabulated, it will be evaluated directly";
+    }
+    fFuncNPoints.push_back(0);
+    fFuncXmin.push_back(0.);
+    fFuncXmax.push_back(0.);
+    fFuncInvStep.push_back(0.);
+    return fFunctions.size() - 1;
+  }
+  double step = (xmax - xmin) / (nPoints - 1);
+  for (int i = 0; i < nPoints; ++i) {
+    fFuncTable.push_back(func->Eval(xmin + i * step));
+  }
+  fFuncNPoints.push_back(nPoints);
+  fFuncXmin.push_back(xmin);
+  fFuncXmax.push_back(xmax);
+  fFuncInvStep.push_back(1.0 / step);
+  return fFunctions.size() - 1;
+}
+
+//____________________________________________________________________________
+float AnalysisCutProgram::EvalFunction(int func, float x) const
+{
+  //
+  // Evaluate a cut limit function, using linear interpolation if the function was tabulated
+  //
+  int nPoints = fFuncNPoints[func];
+  if (nPoints > 0 && x >= fFuncXmin[func] && x <= fFuncXmax[func]) {
+    double t = (x - fFuncXmin[func]) * fFuncInvStep[func];
+    int bin = static_cast<int>(t);
+    if (bin > nPoints - 2) {
+      bin = nPoints - 2;
+    }
+    const double* table = fFuncTable.data() + fFuncOffset[func];
+    return table[bin] + (t - bin) * (table[bin + 1] - table[bin]);
+  }
+  return fFunctions[func]->Eval(x);
+}
+
+//____________________________________________________________________________
+uint64_t AnalysisCutProgram::GetSelectionMask(const float* values) const
+{
+  //
+  // Evaluate all the cuts in the program
+  //
+  uint64_t mask = 0;
+  int nCuts = (GetNCuts() < kMaxCuts ? GetNCuts() : kMaxCuts);
+  for (int icut = 0; icut < nCuts; ++icut) {
+    if (IsSelected(icut, values)) {
+      mask |= (static_cast<uint64_t>(1) << icut);
+    }
+  }
+  return mask;
+}
+
+//____________________________________________________________________________
+void AnalysisCutProgram::IsSelected(int cut, const float* values, int nRows, int stride, uint64_t* mask) const
+{
+  //
+  // Evaluate one cut on a batch of value rows
+  //
+  for (int iword = 0; iword < (nRows + 63) / 64; ++iword) {
+    mask[iword] = 0;
+  }
+  for (int irow = 0; irow < nRows; ++irow) {
+    if (IsSelected(cut, values + static_cast<std::size_t>(irow) * stride)) {
+      mask[irow / 64] |= (static_cast<uint64_t>(1) << (irow % 64));
+    }
+  }
+}
@@ -0,0 +1,134 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Contact: iarsene@cern.ch, i.c.arsene@fys.uio.no
+//
+// Class compiling AnalysisCut / AnalysisCompositeCut trees into a flat program
+//   Each elementary cut (one CutContainer) becomes a test stored in struct-of-arrays layout, together with the
+//   indices of the tests to jump to if the test passes or fails. The AND / OR logic of the composite cuts is thus
+//   encoded in the jumps (short-circuit evaluation), and no recursion over the cut tree is needed at run time.
+//   Several cuts can be added to the same program, and evaluated together into a bit mask.
+//
+
+#ifndef PWGDQ_CORE_ANALYSISCUTPROGRAM_H_
+#define PWGDQ_CORE_ANALYSISCUTPROGRAM_H_
+
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/AnalysisCut.h"
+
+#include <TF1.h>
+
+#include <cstdint>
+#include <vector>
+
+//_________________________________________________________________________
+class AnalysisCutProgram
+{
+ public:
+  AnalysisCutProgram() = default;
+  ~AnalysisCutProgram() = default;
+
+  enum Targets {
+    kAccept = -1,
+    kReject = -2
+  };
+  static constexpr int kMaxCuts = 64; // maximum number of cuts which can be evaluated in GetSelectionMask()
+
+  // Compile a cut (AnalysisCut or AnalysisCompositeCut) and add it to the program. Returns the index of the cut in the program
+  // If nFuncPoints > 0, the TF1 cut limits are tabulated in nFuncPoints equidistant points over the function range and linearly interpolated
+  //   (outside the function range, the TF1 is evaluated directly). Otherwise (default), the TF1 are evaluated as in AnalysisCut::IsSelected()
+  int AddCut(const AnalysisCut* cut, int nFuncPoints = 0);
+  int GetNCuts() const { return fEntries.size(); }
+  int GetNTests() const { return fVar.size(); }
+
+  // Decision of cut number <cut>; identical to calling IsSelected() on the original cut object
+  bool IsSelected(int cut, const float* values) const
+  {
+    int test = fEntries[cut];
+    while (test >= 0) {
+      test = (PassTest(test, values) ? fOnPass[test] : fOnFail[test]);
+    }
+    return test == kAccept;
+  }
+  // Decisions of all the cuts in the program (bit i corresponds to the cut with index i)
+  uint64_t GetSelectionMask(const float* values) const;
+  // Evaluate cut number <cut> on nRows rows of values, the row i starting at values + i * stride
+  // The bit (i % 64) of mask[i / 64] is set if the row i is selected; the mask must hold at least (nRows + 63) / 64 words
+  void IsSelected(int cut, const float* values, int nRows, int stride, uint64_t* mask) const;
+
+ private:
+  // elementary test, used only while compiling
+  struct Test {
+    const AnalysisCut::CutContainer* fCut;
+    int fOnPass;
+    int fOnFail;
+  };
+
+  int CompileCut(const AnalysisCut& cut, int onPass, int onFail, std::vector<Test>& tests) const;
+  int CompileCompositeCut(const AnalysisCompositeCut& cut, int onPass, int onFail, std::vector<Test>& tests) const;
+  int AddFunction(TF1* func, int nPoints);
+
+  bool PassTest(int test, const float* values) const
+  {
+    // dependent variable ranges; if the dependent variables are not in the requested range, the test is passed (see AnalysisCut::IsSelected)
+    int depVar = fDepVar[test];
+    if (depVar != -1) {
+      bool inRange = (values[depVar] > fDepLow[test] && values[depVar] <= fDepHigh[test]);
+      if (inRange == fDepExclude[test]) {
+        return true;
+      }
+    }
+    int depVar2 = fDepVar2[test];
+    if (depVar2 != -1) {
+      bool inRange = (values[depVar2] > fDep2Low[test] && values[depVar2] <= fDep2High[test]);
+      if (inRange == fDep2Exclude[test]) {
+        return true;
+      }
+    }
+    float cutLow = (fFuncLow[test] < 0 ? fLow[test] : EvalFunction(fFuncLow[test], values[depVar]));
+    float cutHigh = (fFuncHigh[test] < 0 ? fHigh[test] : EvalFunction(fFuncHigh[test], values[depVar]));
+    float value = values[fVar[test]];
+    bool inRange = (value >= cutLow) & (value <= cutHigh);
+    return inRange != fExclude[test];
+  }
+  float EvalFunction(int func, float x) const;
+
+  // tests, in struct-of-arrays layout
+  std::vector<int> fVar;
+  std::vector<float> fLow;
+  std::vector<float> fHigh;
+  std::vector<uint8_t> fExclude;
+  std::vector<int> fDepVar;
+  std::vector<float> fDepLow;
+  std::vector<float> fDepHigh;
+  std::vector<uint8_t> fDepExclude;
+  std::vector<int> fDepVar2;
+  std::vector<float> fDep2Low;
+  std::vector<float> fDep2High;
+  std::vector<uint8_t> fDep2Exclude;
+  std::vector<int> fFuncLow;  // index of the function for the lower limit, or -1
+  std::vector<int> fFuncHigh; // index of the function for the upper limit, or -1
+  std::vector<int> fOnPass;   // next test if this test passes (or kAccept / kReject)
+  std::vector<int> fOnFail;   // next test if this test fails (or kAccept / kReject)
+
+  std::vector<int> fEntries; // first test of each cut (or kAccept / kReject for trivial cuts)
+
+  // functions used as cut limits, optionally tabulated
+  std::vector<TF1*> fFunctions;
+  std::vector<int> fFuncNPoints;    // number of tabulated points (0 if the function is not tabulated)
+  std::vector<int> fFuncOffset;     // offset of the tabulated values in fFuncTable
+  std::vector<double> fFuncXmin;    // lower edge of the tabulated range
+  std::vector<double> fFuncXmax;    // upper edge of the tabulated range
+  std::vector<double> fFuncInvStep; // inverse of the tabulation step
+  std::vector<double> fFuncTable;   // tabulated function values
+};
+
+#endif // PWGDQ_CORE_ANALYSISCUTPROGRAM_H_
@@ -25,10 +25,13 @@
 #include <Rtypes.h>
 #include <RtypesCore.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <list>
 #include <memory>
+#include <string_view>
 #include <vector>
 using namespace std;
 
@@ -51,6 +54,9 @@ HistogramManager::HistogramManager() : TNamed("", ""),
                                        fNVars(0),
                                        fUsedVars(nullptr),
                                        fVariablesMap(),
+                                       fFillPlans(),
+                                       fHistClassIndices(),
+                                       fFillPlansReady(false),
                                        fUseDefaultVariableNames(false),
                                        fBinsAllocated(0),
                                        fVariableNames(nullptr),
@@ -67,6 +73,9 @@ HistogramManager::HistogramManager(const char* name, const char* title, const in
                                                                                               fNVars(maxNVars),
                                                                                               fUsedVars(),
                                                                                               fVariablesMap(),
+                                                                                              fFillPlans(),
+                                                                                              fHistClassIndices(),
+                                                                                              fFillPlansReady(false),
                                                                                               fUseDefaultVariableNames(kFALSE),
                                                                                               fBinsAllocated(0),
                                                                                               fVariableNames(),
@@ -125,6 +134,7 @@ void HistogramManager::AddHistClass(const char* histClass)
   fMainList->Add(hList);
   std::list<std::vector<int>> varList;
   fVariablesMap[histClass] = varList;
+  fFillPlansReady = false;
 }
 
 //_________________________________________________________________
@@ -196,6 +206,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fFillPlansReady = false;
 
   // create and configure histograms according to required options
   TH1* h = nullptr;
@@ -406,6 +417,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fFillPlansReady = false;
 
   TH1* h = nullptr;
   switch (dimension) {
@@ -591,6 +603,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fFillPlansReady = false;
 
   uint32_t nbins = 1;
   THnBase* h = nullptr;
@@ -684,6 +697,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fFillPlansReady = false;
 
   // get the min and max for each axis
   auto* xmin = new double[nDimensions];
@@ -750,156 +764,251 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
 }
 
 //__________________________________________________________________
-void HistogramManager::FillHistClass(const char* className, Float_t* values)
+void HistogramManager::CompileFillPlans()
 {
   //
-  //  fill a class of histograms
+  // Build the fill plans for all histogram classes
+  // The histograms in each class are grouped by type and the variable indices needed for filling are resolved,
+  //   such that FillHistClass() does not need to decode the information in fVariablesMap on every call.
+  // Handles are assigned in the order in which the classes appear in the main list, so they remain valid
+  //   when further classes are added
   //
-
-  // get the needed histogram list
-  auto* hList = reinterpret_cast<TList*>(fMainList->FindObject(className));
-  if (!hList) {
-    // TODO: add some meaningfull error message
-    /*LOG(warn) << "HistogramManager::FillHistClass(): Histogram list " << className << " not found!";
-    LOG(warn) << "         Histogram list not filled" << endl; */
+  fFillPlans.clear();
+  fHistClassIndices.clear();
+  if (!fMainList) {
+    fFillPlansReady = true;
     return;
   }
+  fFillPlans.resize(fMainList->GetEntries());
 
-  // get the corresponding std::list containng identifiers to the needed variables to be filled
-  auto const& varList = fVariablesMap[className];
-
-  TIter next(hList);
-
-  TObject* h = nullptr;
-  bool isProfile;
-  bool isTHn;
-  int dimension = 0;
-  bool isSparse = kFALSE;
-  bool isFillLabelx = kFALSE;
-  // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms. We should make this more dynamic
-  //       But maybe its better to have it like to avoid dynamically allocating this array in the histogram loop
-  double fillValues[20] = {0.0};
-  int varX = -1, varY = -1, varZ = -1, varT = -1, varW = -1;
-
-  // loop over the histogram and std::list
-  // NOTE: these two should contain the same number of elements and be synchronized, otherwise its a mess
-  for (auto varIter = varList.begin(); varIter != varList.end(); varIter++) {
-    h = next(); // get the histogram
-    // decode information from the vector of indices
-    isProfile = ((*varIter)[0] == 1 ? true : false);
-    isTHn = ((*varIter)[1] > 0 ? true : false);
-    if (isTHn) {
-      dimension = (*varIter)[1];
-    } else {
-      dimension = (reinterpret_cast<TH1*>(h))->GetDimension();
-    }
+  int classIndex = 0;
+  TIter nextClass(fMainList);
+  TList* hList = nullptr;
+  while ((hList = reinterpret_cast<TList*>(nextClass()))) {
+    FillPlan& plan = fFillPlans[classIndex];
+    fHistClassIndices[hList->GetName()] = classIndex;
+    classIndex++;
 
-    // get the various variable indices
-    varW = (*varIter)[2];
-    if (isTHn) {
-      for (int i = 0; i < dimension; i++) {
-        fillValues[i] = values[(*varIter)[3 + i]];
-      }
-    } else {
-      varX = (*varIter)[3];
-      varY = (*varIter)[4];
-      varZ = (*varIter)[5];
-      varT = (*varIter)[6];
-      isFillLabelx = ((*varIter)[7] == 1 ? true : false);
+    auto varListIt = fVariablesMap.find(hList->GetName());
+    if (varListIt == fVariablesMap.end()) {
+      continue;
     }
+    // NOTE: the histogram list and the std::list of variable identifiers are synchronized (see AddHistogram)
+    TIter next(hList);
+    for (auto const& vars : varListIt->second) {
+      TObject* h = next();
+      bool isProfile = (vars[0] == 1);
+      int nDimTHn = vars[1];
+      int varW = vars[2];
+      if (nDimTHn > 0) {
+        if (nDimTHn > kMaxTHnDimensions) {
+          LOG(error) << "HistogramManager::CompileFillPlans(): THn " << h->GetName() << " has more than " << kMaxTHnDimensions << " dimensions, it will not be filled";
+          continue;
+        }
+        plan.fHn.push_back(reinterpret_cast<THnBase*>(h));
+        plan.fHnOffsets.push_back(static_cast<int>(plan.fHnVars.size()));
+        plan.fHnVars.push_back(varW);
+        plan.fHnVars.push_back(nDimTHn);
+        for (int i = 0; i < nDimTHn; i++) {
+          plan.fHnVars.push_back(vars[3 + i]);
+        }
+        continue;
+      }
 
-    if (!isTHn) {
-      switch (dimension) {
+      int varX = vars[3];
+      int varY = vars[4];
+      int varZ = vars[5];
+      int varT = vars[6];
+      bool isFillLabelx = (vars[7] == 1);
+      switch ((reinterpret_cast<TH1*>(h))->GetDimension()) {
         case 1:
           if (isProfile) {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
-              } else {
-                (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY]);
-              } else {
-                (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY]);
-              }
-            }
+            auto& group = (isFillLabelx ? plan.fLabelProfile : plan.fProfile);
+            auto& groupVars = (isFillLabelx ? plan.fLabelProfileVars : plan.fProfileVars);
+            group.push_back(reinterpret_cast<TProfile*>(h));
+            groupVars.insert(groupVars.end(), {varX, varY, varW});
           } else {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varW]);
-              } else {
-                (reinterpret_cast<TH1*>(h))->Fill(values[varX], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), 1.);
-              } else {
-                (reinterpret_cast<TH1*>(h))->Fill(values[varX]);
-              }
-            }
+            auto& group = (isFillLabelx ? plan.fLabelH1 : plan.fH1);
+            auto& groupVars = (isFillLabelx ? plan.fLabelH1Vars : plan.fH1Vars);
+            group.push_back(reinterpret_cast<TH1*>(h));
+            groupVars.insert(groupVars.end(), {varX, varW});
           }
           break;
         case 2:
           if (isProfile) {
-            if (varW > kNothing) {
-              (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ]);
-            }
+            plan.fProfile2D.push_back(reinterpret_cast<TProfile2D*>(h));
+            plan.fProfile2DVars.insert(plan.fProfile2DVars.end(), {varX, varY, varZ, varW});
           } else {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
-              } else {
-                (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], 1.);
-              } else {
-                (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY]);
-              }
-            }
+            auto& group = (isFillLabelx ? plan.fLabelH2 : plan.fH2);
+            auto& groupVars = (isFillLabelx ? plan.fLabelH2Vars : plan.fH2Vars);
+            group.push_back(reinterpret_cast<TH2*>(h));
+            groupVars.insert(groupVars.end(), {varX, varY, varW});
           }
           break;
         case 3:
           if (isProfile) {
-            if (varW > kNothing) {
-              (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT], values[varW]);
-            } else {
-              (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT]);
-            }
+            plan.fProfile3D.push_back(reinterpret_cast<TProfile3D*>(h));
+            plan.fProfile3DVars.insert(plan.fProfile3DVars.end(), {varX, varY, varZ, varT, varW});
           } else {
-            if (varW > kNothing) {
-              (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ]);
-            }
+            plan.fH3.push_back(reinterpret_cast<TH3*>(h));
+            plan.fH3Vars.insert(plan.fH3Vars.end(), {varX, varY, varZ, varW});
           }
           break;
-
         default:
           break;
-      } // end switch
-      // end if(!isTHn)
-    } else {
-      if (varW > kNothing) {
-        if (isSparse) {
-          (reinterpret_cast<THnSparse*>(h))->Fill(fillValues, values[varW]);
-        } else {
-          (reinterpret_cast<THn*>(h))->Fill(fillValues, values[varW]);
-        }
-      } else {
-        if (isSparse) {
-          (reinterpret_cast<THnSparse*>(h))->Fill(fillValues);
-        } else {
-          (reinterpret_cast<THn*>(h))->Fill(fillValues);
-        }
       }
-    } // end else
-  } // end loop over histograms
+    }
+  }
+  fFillPlansReady = true;
+}
+
+//__________________________________________________________________
+int HistogramManager::GetHistClassIndex(const char* className)
+{
+  //
+  // Get the handle of a histogram class
+  //
+  if (!fFillPlansReady) {
+    CompileFillPlans();
+  }
+  auto it = fHistClassIndices.find(std::string_view(className));
+  if (it == fHistClassIndices.end()) {
+    return kNothing;
+  }
+  return it->second;
+}
+
+//__________________________________________________________________
+void HistogramManager::FillHistClass(const char* className, Float_t* values)
+{
+  //
+  //  fill a class of histograms
+  //
+  int classIndex = GetHistClassIndex(className);
+  if (classIndex == kNothing) {
+    // TODO: add some meaningfull error message
+    /*LOG(warn) << "HistogramManager::FillHistClass(): Histogram list " << className << " not found!";
+    LOG(warn) << "         Histogram list not filled" << endl; */
+    return;
+  }
+  FillHistClass(classIndex, values);
+}
+
+//__________________________________________________________________
+void HistogramManager::FillHistClass(int classIndex, Float_t* values)
+{
+  //
+  //  fill a class of histograms using its precompiled fill plan
+  //
+  if (!fFillPlansReady) {
+    CompileFillPlans();
+  }
+  if (classIndex < 0 || classIndex >= static_cast<int>(fFillPlans.size())) {
+    return;
+  }
+  const FillPlan& plan = fFillPlans[classIndex];
+
+  // 1D histograms
+  const int* vars = plan.fH1Vars.data();
+  for (auto* h : plan.fH1) {
+    if (vars[1] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]]);
+    } else {
+      h->Fill(values[vars[0]]);
+    }
+    vars += 2;
+  }
+  // 1D profiles
+  vars = plan.fProfileVars.data();
+  for (auto* h : plan.fProfile) {
+    if (vars[2] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+    } else {
+      h->Fill(values[vars[0]], values[vars[1]]);
+    }
+    vars += 3;
+  }
+  // 2D histograms
+  vars = plan.fH2Vars.data();
+  for (auto* h : plan.fH2) {
+    if (vars[2] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+    } else {
+      h->Fill(values[vars[0]], values[vars[1]]);
+    }
+    vars += 3;
+  }
+  // 2D profiles
+  vars = plan.fProfile2DVars.data();
+  for (auto* h : plan.fProfile2D) {
+    if (vars[3] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]]);
+    } else {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+    }
+    vars += 4;
+  }
+  // 3D histograms
+  vars = plan.fH3Vars.data();
+  for (auto* h : plan.fH3) {
+    if (vars[3] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]]);
+    } else {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+    }
+    vars += 4;
+  }
+  // 3D profiles
+  vars = plan.fProfile3DVars.data();
+  for (auto* h : plan.fProfile3D) {
+    if (vars[4] > kNothing) {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]], values[vars[4]]);
+    } else {
+      h->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]]);
+    }
+    vars += 5;
+  }
+
+  // histograms filled using the x-axis bin labels; the label is the integer value of the x variable
+  char label[16];
+  vars = plan.fLabelH1Vars.data();
+  for (auto* h : plan.fLabelH1) {
+    snprintf(label, sizeof(label), "%d", static_cast<int>(values[vars[0]]));
+    h->Fill(label, (vars[1] > kNothing ? static_cast<double>(values[vars[1]]) : 1.));
+    vars += 2;
+  }
+  vars = plan.fLabelProfileVars.data();
+  for (auto* h : plan.fLabelProfile) {
+    snprintf(label, sizeof(label), "%d", static_cast<int>(values[vars[0]]));
+    if (vars[2] > kNothing) {
+      h->Fill(label, values[vars[1]], values[vars[2]]);
+    } else {
+      h->Fill(label, values[vars[1]]);
+    }
+    vars += 3;
+  }
+  vars = plan.fLabelH2Vars.data();
+  for (auto* h : plan.fLabelH2) {
+    snprintf(label, sizeof(label), "%d", static_cast<int>(values[vars[0]]));
+    h->Fill(label, values[vars[1]], (vars[2] > kNothing ? static_cast<double>(values[vars[2]]) : 1.));
+    vars += 3;
+  }
+
+  // THn and THnSparse
+  double fillValues[kMaxTHnDimensions] = {0.0};
+  for (std::size_t ih = 0; ih < plan.fHn.size(); ih++) {
+    vars = plan.fHnVars.data() + plan.fHnOffsets[ih];
+    int varW = vars[0];
+    int nDim = vars[1];
+    for (int i = 0; i < nDim; i++) {
+      fillValues[i] = values[vars[2 + i]];
+    }
+    if (varW > kNothing) {
+      plan.fHn[ih]->Fill(fillValues, values[varW]);
+    } else {
+      plan.fHn[ih]->Fill(fillValues);
+    }
+  }
 }
 
 //____________________________________________________________________________________
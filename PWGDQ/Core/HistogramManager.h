@@ -19,17 +19,26 @@
 
 #include <TArrayD.h>
 #include <TAxis.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TH3.h>
 #include <THashList.h>
+#include <THnBase.h>
 #include <TNamed.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
 #include <TString.h>
 
 #include <Rtypes.h>
 #include <RtypesCore.h>
 
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class HistogramManager : public TNamed
@@ -41,7 +50,8 @@ class HistogramManager : public TNamed
   ~HistogramManager() override;
 
   enum Constants {
-    kNothing = -1
+    kNothing = -1,
+    kMaxTHnDimensions = 20
   };
 
   void SetMainHistogramList(THashList* list)
@@ -50,6 +60,7 @@ class HistogramManager : public TNamed
       delete fMainList;
     }
     fMainList = list;
+    fFillPlansReady = false;
   }
 
   // Create a new histogram class
@@ -87,7 +98,14 @@ class HistogramManager : public TNamed
                     int nDimensions, int* vars, TArrayD* binLimits,
                     TString* axLabels = nullptr, int varW = -1, bool useSparse = kFALSE, bool isdouble = false);
 
+  // Fill a class of histograms addressed by its name: the class is looked up on each call, use the handle overload for the
+  // classes filled per track or per pair (the name-based fills are kept for the tasks filling few classes per event)
   void FillHistClass(const char* className, float* values);
+  // Get an integer handle for the histogram class <className>, to be used with the FillHistClass(int, float*) overload
+  // Returns kNothing if the class does not exist. Handles stay valid when further classes or histograms are added
+  int GetHistClassIndex(const char* className);
+  // Fill a class of histograms addressed by its handle, using the precompiled fill plan (no string lookups)
+  void FillHistClass(int classIndex, float* values);
 
   void SetUseDefaultVariableNames(bool flag) { fUseDefaultVariableNames = flag; }
   void SetDefaultVarNames(TString* vars, TString* units);
@@ -105,6 +123,38 @@ class HistogramManager : public TNamed
   bool* fUsedVars;                                                  //! flags of used variables
   std::map<std::string, std::list<std::vector<int>>> fVariablesMap; //!  map holding identifiers for all variables needed by histograms
 
+  // Fill plan of a histogram class, compiled from fMainList and fVariablesMap
+  // Histograms are grouped by type, and the variable indices for each group are stored in flat arrays with a fixed stride
+  // (for THn, the layout is {varW, nDimensions, vars...} and the start of each entry is given by fHnOffsets)
+  struct FillPlan {
+    std::vector<TH1*> fH1;                // TH1: varX, varW
+    std::vector<int> fH1Vars;
+    std::vector<TProfile*> fProfile;      // TProfile: varX, varY, varW
+    std::vector<int> fProfileVars;
+    std::vector<TH2*> fH2;                // TH2: varX, varY, varW
+    std::vector<int> fH2Vars;
+    std::vector<TProfile2D*> fProfile2D;  // TProfile2D: varX, varY, varZ, varW
+    std::vector<int> fProfile2DVars;
+    std::vector<TH3*> fH3;                // TH3: varX, varY, varZ, varW
+    std::vector<int> fH3Vars;
+    std::vector<TProfile3D*> fProfile3D;  // TProfile3D: varX, varY, varZ, varT, varW
+    std::vector<int> fProfile3DVars;
+    std::vector<TH1*> fLabelH1;           // TH1 filled with x-axis labels: varX, varW
+    std::vector<int> fLabelH1Vars;
+    std::vector<TProfile*> fLabelProfile; // TProfile filled with x-axis labels: varX, varY, varW
+    std::vector<int> fLabelProfileVars;
+    std::vector<TH2*> fLabelH2;           // TH2 filled with x-axis labels: varX, varY, varW
+    std::vector<int> fLabelH2Vars;
+    std::vector<THnBase*> fHn;            // THn and THnSparse
+    std::vector<int> fHnVars;
+    std::vector<int> fHnOffsets;
+  };
+  std::vector<FillPlan> fFillPlans;                          //! fill plans, indexed by the histogram class handle
+  std::map<std::string, int, std::less<>> fHistClassIndices; //! map between histogram class names and handles
+  bool fFillPlansReady;                                      //! false if histograms were added since the fill plans were compiled
+
+  void CompileFillPlans();
+
   // various
   bool fUseDefaultVariableNames; //! toggle the usage of default variable names and units
   uint64_t fBinsAllocated;       //! number of allocated bins
@@ -33,6 +33,7 @@
 #include <Rtypes.h>
 #include <RtypesCore.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -137,6 +138,56 @@ void VarManager::ResetValues(int startValue, int endValue, float* values)
   }
 }
 
+//__________________________________________________________________
+VarManager::ValuesContext::ValuesContext() : fValues(kNVars, -9999.),
+                                             fUsedVars()
+{
+  //
+  // constructor; captures the list of variables used at this moment
+  //
+  for (int i = 0; i < kNVars; ++i) {
+    if (fgUsedVars[i]) {
+      fUsedVars.push_back(i);
+    }
+  }
+}
+
+//__________________________________________________________________
+void VarManager::ValuesContext::ResetUsedValues(int startValue, int endValue)
+{
+  //
+  // reset the used variables in the range [startValue, endValue), see ResetValues()
+  //
+  auto it = std::lower_bound(fUsedVars.begin(), fUsedVars.end(), startValue);
+  for (; it != fUsedVars.end() && *it < endValue; ++it) {
+    fValues[*it] = -9999.;
+  }
+}
+
+//__________________________________________________________________
+void VarManager::ValuesContext::CompactValues(std::vector<float>& compact) const
+{
+  //
+  // copy the used variables into a compact vector
+  //
+  compact.resize(fUsedVars.size());
+  for (std::size_t i = 0; i < fUsedVars.size(); ++i) {
+    compact[i] = fValues[fUsedVars[i]];
+  }
+}
+
+//__________________________________________________________________
+void VarManager::ValuesContext::ExpandValues(const std::vector<float>& compact)
+{
+  //
+  // restore the used variables from a compact vector obtained with CompactValues()
+  //
+  std::size_t n = std::min(compact.size(), fUsedVars.size());
+  for (std::size_t i = 0; i < n; ++i) {
+    fValues[fUsedVars[i]] = compact[i];
+  }
+}
+
 //__________________________________________________________________
 void VarManager::SetCollisionSystem(TString system, float energy)
 {
@@ -240,10 +291,14 @@ float VarManager::calculateCosPA(KFParticle kfp, KFParticle PV)
 }
 
 //__________________________________________________________________
-double VarManager::ComputePIDcalibration(int species, double nSigmaValue)
+double VarManager::ComputePIDcalibration(int species, double nSigmaValue, float* values)
 {
   // species: 0 - electron, 1 - pion, 2 - kaon, 3 - proton
+  // values: the array holding the track variables (fgValues by default)
   // Depending on the PID calibration type, we use different types of calibration histograms
+  if (!values) {
+    values = fgValues;
+  }
 
   if (fgCalibrationType == 1) {
     // get the calibration histograms
@@ -278,13 +333,13 @@ double VarManager::ComputePIDcalibration(int species, double nSigmaValue)
     }
 
     // Get the bin indices for the calibration histograms
-    int binTPCncls = calibMeanHist->GetXaxis()->FindBin(fgValues[kTPCncls]);
+    int binTPCncls = calibMeanHist->GetXaxis()->FindBin(values[kTPCncls]);
     binTPCncls = (binTPCncls == 0 ? 1 : binTPCncls);
     binTPCncls = (binTPCncls > calibMeanHist->GetXaxis()->GetNbins() ? calibMeanHist->GetXaxis()->GetNbins() : binTPCncls);
-    int binPin = calibMeanHist->GetYaxis()->FindBin(fgValues[kPin]);
+    int binPin = calibMeanHist->GetYaxis()->FindBin(values[kPin]);
     binPin = (binPin == 0 ? 1 : binPin);
     binPin = (binPin > calibMeanHist->GetYaxis()->GetNbins() ? calibMeanHist->GetYaxis()->GetNbins() : binPin);
-    int binEta = calibMeanHist->GetZaxis()->FindBin(fgValues[kEta]);
+    int binEta = calibMeanHist->GetZaxis()->FindBin(values[kEta]);
     binEta = (binEta == 0 ? 1 : binEta);
     binEta = (binEta > calibMeanHist->GetZaxis()->GetNbins() ? calibMeanHist->GetZaxis()->GetNbins() : binEta);
 
@@ -329,16 +384,16 @@ double VarManager::ComputePIDcalibration(int species, double nSigmaValue)
     }
 
     // Get the bin indices for the calibration histograms
-    int binEta = calibMeanHist->GetAxis(0)->FindBin(fgValues[kEta]);
+    int binEta = calibMeanHist->GetAxis(0)->FindBin(values[kEta]);
     binEta = (binEta == 0 ? 1 : binEta);
     binEta = (binEta > calibMeanHist->GetAxis(0)->GetNbins() ? calibMeanHist->GetAxis(0)->GetNbins() : binEta);
-    int binNpv = calibMeanHist->GetAxis(1)->FindBin(fgValues[kVtxNcontribReal]);
+    int binNpv = calibMeanHist->GetAxis(1)->FindBin(values[kVtxNcontribReal]);
     binNpv = (binNpv == 0 ? 1 : binNpv);
     binNpv = (binNpv > calibMeanHist->GetAxis(1)->GetNbins() ? calibMeanHist->GetAxis(1)->GetNbins() : binNpv);
-    int binNlong = calibMeanHist->GetAxis(2)->FindBin(fgValues[kNTPCcontribLongA]);
+    int binNlong = calibMeanHist->GetAxis(2)->FindBin(values[kNTPCcontribLongA]);
     binNlong = (binNlong == 0 ? 1 : binNlong);
     binNlong = (binNlong > calibMeanHist->GetAxis(2)->GetNbins() ? calibMeanHist->GetAxis(2)->GetNbins() : binNlong);
-    int binTlong = calibMeanHist->GetAxis(3)->FindBin(fgValues[kNTPCmedianTimeLongA]);
+    int binTlong = calibMeanHist->GetAxis(3)->FindBin(values[kNTPCmedianTimeLongA]);
     binTlong = (binTlong == 0 ? 1 : binTlong);
     binTlong = (binTlong > calibMeanHist->GetAxis(3)->GetNbins() ? calibMeanHist->GetAxis(3)->GetNbins() : binTlong);
 
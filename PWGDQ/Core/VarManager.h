@@ -1448,7 +1448,7 @@ class VarManager : public TObject
     fgCalibrationType = type;
     fgUseInterpolatedCalibration = useInterpolation;
   }
-  static double ComputePIDcalibration(int species, double nSigmaValue);
+  static double ComputePIDcalibration(int species, double nSigmaValue, float* values = nullptr);
 
   static TObject* GetCalibrationObject(CalibObjects calib)
   {
@@ -1484,6 +1484,35 @@ class VarManager : public TObject
   static float fgValues[kNVars]; // array holding all variables computed during analysis
   static void ResetValues(int startValue = 0, int endValue = kNVars, float* values = nullptr);
 
+  // Storage for the variables computed by the Fill* functions, alternative to the static fgValues array.
+  // The Fill* functions write by default into fgValues, which makes them non-reentrant. In order to process objects concurrently
+  //   (e.g. to split a pair loop across threads), each thread should own a ValuesContext and pass it as the values argument of the
+  //   Fill* functions, AnalysisCut::IsSelected(), MixingHandler::FindEventCategory() and HistogramManager::FillHistClass()
+  // The list of used variables is captured at construction, so the context should be created only after all the cuts, histograms
+  //   and mixing handlers were configured.
+  // NOTE: the vertexing and propagation functions use the static DCA fitters and are not reentrant.
+  //       The histograms of a HistogramManager are not thread safe, so each thread needs its own histograms (or serialized filling).
+  class ValuesContext
+  {
+   public:
+    ValuesContext();
+
+    float* GetValues() { return fValues.data(); }
+    operator float*() { return fValues.data(); }
+    const std::vector<int>& GetUsedVariables() const { return fUsedVars; }
+    int GetNUsedVariables() const { return fUsedVars.size(); }
+
+    // reset only the used variables in the range [startValue, endValue)
+    void ResetUsedValues(int startValue = 0, int endValue = kNVars);
+    // copy the used variables into a compact vector (ordered as in GetUsedVariables()), and back
+    void CompactValues(std::vector<float>& compact) const;
+    void ExpandValues(const std::vector<float>& compact);
+
+   private:
+    std::vector<float> fValues; // values of all the variables
+    std::vector<int> fUsedVars; // indices of the used variables, in increasing order
+  };
+
  private:
   static bool fgUsedVars[kNVars]; // holds flags for when the corresponding variable is needed (e.g., in the histogram manager, in cuts, mixing handler, etc.)
   static bool fgUsedKF;
@@ -2991,7 +3020,7 @@ void VarManager::FillTrack(T const& track, float* values)
     // compute TPC postcalibrated electron nsigma based on calibration histograms from CCDB
     if (fgUsedVars[kTPCnSigmaEl_Corr] && fgRunTPCPostCalibration[0]) {
       if (!isTPCCalibrated) {
-        values[kTPCnSigmaEl_Corr] = ComputePIDcalibration(0, values[kTPCnSigmaEl]);
+        values[kTPCnSigmaEl_Corr] = ComputePIDcalibration(0, values[kTPCnSigmaEl], values);
       } else {
         LOG(fatal) << "TPC PID postcalibration is configured but the tracks are already postcalibrated. This is not allowed. Please check your configuration.";
         values[kTPCnSigmaEl_Corr] = track.tpcNSigmaEl();
@@ -3001,7 +3030,7 @@ void VarManager::FillTrack(T const& track, float* values)
     // compute TPC postcalibrated pion nsigma if required
     if (fgUsedVars[kTPCnSigmaPi_Corr] && fgRunTPCPostCalibration[1]) {
       if (!isTPCCalibrated) {
-        values[kTPCnSigmaPi_Corr] = ComputePIDcalibration(1, values[kTPCnSigmaPi]);
+        values[kTPCnSigmaPi_Corr] = ComputePIDcalibration(1, values[kTPCnSigmaPi], values);
       } else {
         LOG(fatal) << "TPC PID postcalibration is configured but the tracks are already postcalibrated. This is not allowed. Please check your configuration.";
         values[kTPCnSigmaPi_Corr] = track.tpcNSigmaPi();
@@ -3010,7 +3039,7 @@ void VarManager::FillTrack(T const& track, float* values)
     if (fgUsedVars[kTPCnSigmaKa_Corr] && fgRunTPCPostCalibration[2]) {
       // compute TPC postcalibrated kaon nsigma if required
       if (!isTPCCalibrated) {
-        values[kTPCnSigmaKa_Corr] = ComputePIDcalibration(2, values[kTPCnSigmaKa]);
+        values[kTPCnSigmaKa_Corr] = ComputePIDcalibration(2, values[kTPCnSigmaKa], values);
       } else {
         LOG(fatal) << "TPC PID postcalibration is configured but the tracks are already postcalibrated. This is not allowed. Please check your configuration.";
         values[kTPCnSigmaKa_Corr] = track.tpcNSigmaKa();
@@ -3019,7 +3048,7 @@ void VarManager::FillTrack(T const& track, float* values)
     // compute TPC postcalibrated proton nsigma if required
     if (fgUsedVars[kTPCnSigmaPr_Corr] && fgRunTPCPostCalibration[3]) {
       if (!isTPCCalibrated) {
-        values[kTPCnSigmaPr_Corr] = ComputePIDcalibration(3, values[kTPCnSigmaPr]);
+        values[kTPCnSigmaPr_Corr] = ComputePIDcalibration(3, values[kTPCnSigmaPr], values);
       } else {
         LOG(fatal) << "TPC PID postcalibration is configured but the tracks are already postcalibrated. This is not allowed. Please check your configuration.";
         values[kTPCnSigmaPr_Corr] = track.tpcNSigmaPr();
@@ -5664,23 +5693,23 @@ void VarManager::FillPairVn(T1 const& t1, T2 const& t2, float* values)
   values[kV2EP] = std::isnan(V2EP) || std::isinf(V2EP) ? 0. : V2EP;
   values[kWV2EP] = std::isnan(V2EP) || std::isinf(V2EP) ? 0. : 1.0;
 
-  if (std::isnan(VarManager::fgValues[VarManager::kU2Q2]) == true) {
+  if (std::isnan(values[kU2Q2]) == true) {
     values[kU2Q2] = -999.;
     values[kR2SP_AB] = -999.;
     values[kR2SP_AC] = -999.;
     values[kR2SP_BC] = -999.;
   }
-  if (std::isnan(VarManager::fgValues[VarManager::kU3Q3]) == true) {
+  if (std::isnan(values[kU3Q3]) == true) {
     values[kU3Q3] = -999.;
     values[kR3SP] = -999.;
   }
-  if (std::isnan(VarManager::fgValues[VarManager::kCos2DeltaPhi]) == true) {
+  if (std::isnan(values[kCos2DeltaPhi]) == true) {
     values[kCos2DeltaPhi] = -999.;
     values[kR2EP_AB] = -999.;
     values[kR2EP_AC] = -999.;
     values[kR2EP_BC] = -999.;
   }
-  if (std::isnan(VarManager::fgValues[VarManager::kCos3DeltaPhi]) == true) {
+  if (std::isnan(values[kCos3DeltaPhi]) == true) {
     values[kCos3DeltaPhi] = -999.;
     values[kR3EP] = -999.;
   }
@@ -321,6 +321,18 @@ struct TableMaker {
   std::vector<AnalysisCompositeCut*> fTrackCuts; //! Barrel track cuts
   std::vector<AnalysisCompositeCut*> fMuonCuts;  //! Muon track cuts
 
+  // handles of the histogram classes, resolved once after the histograms are defined (kNothing if a class is not defined)
+  int fHistClassEventBeforeCuts = HistogramManager::kNothing;
+  int fHistClassEventAfterCuts = HistogramManager::kNothing;
+  int fHistClassTrackBeforeCuts = HistogramManager::kNothing;
+  std::vector<int> fHistClassTrackCuts; // one per barrel track cut
+  int fHistClassPostCalibElectron = HistogramManager::kNothing;
+  int fHistClassPostCalibPion = HistogramManager::kNothing;
+  int fHistClassPostCalibProton = HistogramManager::kNothing;
+  int fHistClassMftTracks = HistogramManager::kNothing;
+  int fHistClassMuonBeforeCuts = HistogramManager::kNothing;
+  std::vector<int> fHistClassMuonCuts; // one per muon cut
+
   bool fDoDetailedQA = false; // Bool to set detailed QA true, if QA is set true
   int fCurrentRun;            // needed to detect if the run changed and trigger update of calibrations etc.
 
@@ -515,6 +527,22 @@ struct TableMaker {
     VarManager::SetUseVars(fHistMan->GetUsedVars()); // provide the list of required variables so that VarManager knows what to fill
     fOutputList.setObject(fHistMan->GetMainHistogramList());
 
+    // Resolve the histogram classes once, such that the per-track fills do not need to look them up by name
+    fHistClassEventBeforeCuts = fHistMan->GetHistClassIndex("Event_BeforeCuts");
+    fHistClassEventAfterCuts = fHistMan->GetHistClassIndex("Event_AfterCuts");
+    fHistClassTrackBeforeCuts = fHistMan->GetHistClassIndex("TrackBarrel_BeforeCuts");
+    for (auto& cut : fTrackCuts) {
+      fHistClassTrackCuts.push_back(fHistMan->GetHistClassIndex(Form("TrackBarrel_%s", cut->GetName())));
+    }
+    fHistClassPostCalibElectron = fHistMan->GetHistClassIndex("TrackBarrel_PostCalibElectron");
+    fHistClassPostCalibPion = fHistMan->GetHistClassIndex("TrackBarrel_PostCalibPion");
+    fHistClassPostCalibProton = fHistMan->GetHistClassIndex("TrackBarrel_PostCalibProton");
+    fHistClassMftTracks = fHistMan->GetHistClassIndex("MftTracks");
+    fHistClassMuonBeforeCuts = fHistMan->GetHistClassIndex("Muons_BeforeCuts");
+    for (auto& muonCut : fMuonCuts) {
+      fHistClassMuonCuts.push_back(fHistMan->GetHistClassIndex(Form("Muons_%s", muonCut->GetName())));
+    }
+
     VarManager::SetMatchingPlane(fConfigVariousOptions.fzMatching.value);
 
     if (fConfigVariousOptions.fUseML.value) {
@@ -1108,7 +1136,7 @@ struct TableMaker {
       }
 
       if (fDoDetailedQA) {
-        fHistMan->FillHistClass("Event_BeforeCuts", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassEventBeforeCuts, VarManager::fgValues);
       }
 
       // fill stats information, before selections
@@ -1150,7 +1178,7 @@ struct TableMaker {
       }
       (reinterpret_cast<TH2D*>(fStatsList->At(kStatsEvent)))->Fill(3.0, static_cast<float>(o2::aod::evsel::kNsel));
 
-      fHistMan->FillHistClass("Event_AfterCuts", VarManager::fgValues);
+      fHistMan->FillHistClass(fHistClassEventAfterCuts, VarManager::fgValues);
 
       // create the event tables
       event(tag, bc.runNumber(), collision.posX(), collision.posY(), collision.posZ(), collision.numContrib(), collision.collisionTime(), collision.collisionTimeRes());
@@ -1293,7 +1321,7 @@ struct TableMaker {
       }
 
       if (fDoDetailedQA) {
-        fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassTrackBeforeCuts, VarManager::fgValues);
       }
 
       // apply track cuts and fill stats histogram
@@ -1304,7 +1332,7 @@ struct TableMaker {
           // NOTE: the QA is filled here just for the first occurence of this track.
           //    So if there are histograms of quantities which depend on the collision association, these will not be accurate
           if (fConfigHistOutput.fConfigQA && (fTrackIndexMap.find(track.globalIndex()) == fTrackIndexMap.end())) {
-            fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut)->GetName()), VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassTrackCuts[i], VarManager::fgValues);
           }
           (reinterpret_cast<TH1D*>(fStatsList->At(kStatsTracks)))->Fill(static_cast<float>(i));
         }
@@ -1331,16 +1359,16 @@ struct TableMaker {
         // TODO: this part should be removed since the calibration histogram can be filled as any other histogram
         if (fConfigPostCalibTPC.fConfigIsOnlyforMaps) {
           if (trackFilteringTag & (static_cast<uint64_t>(1) << VarManager::kIsConversionLeg)) { // for electron
-            fHistMan->FillHistClass("TrackBarrel_PostCalibElectron", VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassPostCalibElectron, VarManager::fgValues);
           }
           if (trackFilteringTag & (static_cast<uint64_t>(1) << VarManager::kIsK0sLeg)) { // for pion
-            fHistMan->FillHistClass("TrackBarrel_PostCalibPion", VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassPostCalibPion, VarManager::fgValues);
           }
           if ((static_cast<bool>(trackFilteringTag & (static_cast<uint64_t>(1) << VarManager::kIsLambdaLeg)) * (track.sign()) > 0)) { // for proton from Lambda
-            fHistMan->FillHistClass("TrackBarrel_PostCalibProton", VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassPostCalibProton, VarManager::fgValues);
           }
           if ((static_cast<bool>(trackFilteringTag & (static_cast<uint64_t>(1) << VarManager::kIsALambdaLeg)) * (track.sign()) < 0)) { // for proton from AntiLambda
-            fHistMan->FillHistClass("TrackBarrel_PostCalibProton", VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassPostCalibProton, VarManager::fgValues);
           }
         }
         if (fConfigPostCalibTPC.fConfigSaveElectronSample) { // only save electron sample
@@ -1428,7 +1456,7 @@ struct TableMaker {
 
       if (fConfigHistOutput.fConfigQA) {
         VarManager::FillTrack<TMFTFillMap>(track);
-        fHistMan->FillHistClass("MftTracks", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassMftTracks, VarManager::fgValues);
       }
 
       // write the MFT track global index in the map for skimming (to make sure we have it just once)
@@ -1563,7 +1591,7 @@ struct TableMaker {
       }
 
       if (fDoDetailedQA) {
-        fHistMan->FillHistClass("Muons_BeforeCuts", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassMuonBeforeCuts, VarManager::fgValues);
       }
       // check the cuts and filters
       int i = 0;
@@ -1574,7 +1602,7 @@ struct TableMaker {
           //     will be skipped from histograms if this muon was already filled in the skimming map.
           //    So if there are histograms of quantities which depend on the collision association, these histograms will not be completely accurate
           if (fConfigHistOutput.fConfigQA && (fFwdTrackIndexMap.find(muon.globalIndex()) == fFwdTrackIndexMap.end())) {
-            fHistMan->FillHistClass(Form("Muons_%s", (*cut)->GetName()), VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassMuonCuts[i], VarManager::fgValues);
           }
           (reinterpret_cast<TH1D*>(fStatsList->At(kStatsMuons)))->Fill(static_cast<float>(i));
         }
@@ -13,6 +13,7 @@
 //
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
 #include "PWGDQ/Core/AnalysisCut.h"
+#include "PWGDQ/Core/AnalysisCutProgram.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 #include "PWGDQ/Core/HistogramManager.h"
 #include "PWGDQ/Core/HistogramsLibrary.h"
@@ -192,6 +193,7 @@ struct DQBarrelTrackSelection {
   Service<o2::ccdb::BasicCCDBManager> fCCDB;
 
   std::vector<AnalysisCompositeCut> fTrackCuts;
+  AnalysisCutProgram fTrackCutsProgram; // all the track cuts compiled into a single program
   std::vector<TString> fCutHistNames;
 
   int fCurrentRun; // needed to detect if the run changed and trigger update of calibrations etc.
@@ -210,6 +212,9 @@ struct DQBarrelTrackSelection {
         }
       }
     }
+    for (auto& cut : fTrackCuts) {
+      fTrackCutsProgram.AddCut(&cut);
+    }
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
 
     if (fConfigQA) {
@@ -268,11 +273,10 @@ struct DQBarrelTrackSelection {
         if (fConfigQA) {
           fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
         }
-        int i = 0;
-        for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); ++cut, ++i) {
-          if ((*cut).IsSelected(VarManager::fgValues)) {
-            filterMap |= (static_cast<uint32_t>(1) << i);
-            if (fConfigQA) {
+        filterMap = static_cast<uint32_t>(fTrackCutsProgram.GetSelectionMask(VarManager::fgValues));
+        if (fConfigQA) {
+          for (unsigned int i = 0; i < fCutHistNames.size(); ++i) {
+            if (filterMap & (static_cast<uint32_t>(1) << i)) {
               fHistMan->FillHistClass(fCutHistNames[i].Data(), VarManager::fgValues);
             }
           }
@@ -305,6 +309,7 @@ struct DQMuonsSelection {
   // TODO: configure the histogram classes to be filled by QA
 
   std::vector<AnalysisCompositeCut> fTrackCuts;
+  AnalysisCutProgram fTrackCutsProgram; // all the muon cuts compiled into a single program
   std::vector<TString> fCutHistNames;
 
   void init(o2::framework::InitContext&)
@@ -316,6 +321,9 @@ struct DQMuonsSelection {
         fTrackCuts.push_back(*dqcuts::GetCompositeCut(objArray->At(icut)->GetName()));
       }
     }
+    for (auto& cut : fTrackCuts) {
+      fTrackCutsProgram.AddCut(&cut);
+    }
     VarManager::SetUseVars(AnalysisCut::fgUsedVars);
 
     if (fConfigQA) {
@@ -354,11 +362,10 @@ struct DQMuonsSelection {
         if (fConfigQA) {
           fHistMan->FillHistClass("Muon_BeforeCuts", VarManager::fgValues);
         }
-        int i = 0;
-        for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); ++cut, ++i) {
-          if ((*cut).IsSelected(VarManager::fgValues)) {
-            filterMap |= (static_cast<uint32_t>(1) << i);
-            if (fConfigQA) {
+        filterMap = static_cast<uint32_t>(fTrackCutsProgram.GetSelectionMask(VarManager::fgValues));
+        if (fConfigQA) {
+          for (unsigned int i = 0; i < fCutHistNames.size(); ++i) {
+            if (filterMap & (static_cast<uint32_t>(1) << i)) {
               fHistMan->FillHistClass(fCutHistNames[i].Data(), VarManager::fgValues);
             }
           }
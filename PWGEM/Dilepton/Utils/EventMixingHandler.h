@@ -15,67 +15,173 @@
 #ifndef PWGEM_DILEPTON_UTILS_EVENTMIXINGHANDLER_H_
 #define PWGEM_DILEPTON_UTILS_EVENTMIXINGHANDLER_H_
 
-#include <map>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace o2::aod::pwgem::dilepton::utils
 {
+// hash of the mixing bin and collision keys, e.g. tuple<zbin, centbin, epbin, occbin> and pair<df index, global collision index>
+struct EventMixingKeyHash {
+  template <typename K>
+  std::size_t operator()(const K& key) const
+  {
+    return std::hash<K>{}(key);
+  }
+
+  template <typename K1, typename K2>
+  std::size_t operator()(const std::pair<K1, K2>& key) const
+  {
+    return combine(combine(0, key.first), key.second);
+  }
+
+  template <typename... Ks>
+  std::size_t operator()(const std::tuple<Ks...>& key) const
+  {
+    auto combineAll = [](const auto&... elements) {
+      std::size_t seed = 0;
+      ((seed = combine(seed, elements)), ...);
+      return seed;
+    };
+    return std::apply(combineAll, key);
+  }
+
+ private:
+  template <typename K>
+  static std::size_t combine(std::size_t seed, const K& element)
+  {
+    return seed ^ (std::hash<K>{}(element) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+};
+
+// T : key of the mixing bin, U : key of the collision, V : stored object (e.g. EMTrack, EMFwdTrack, photon)
+// The objects of each collision are stored contiguously, in arrays which are recycled (with their capacity) once the collision leaves the event pool.
+// The collision keys of each mixing bin are a ring of fixed depth, kept contiguous so that they can be returned as a span.
+// The accessors return spans into the handler, which stay valid until the collision is removed from the pool or objects are added to it.
 template <typename T, typename U, typename V>
 class EventMixingHandler
 {
  public:
-  EventMixingHandler()
-  {
-    fNdepth = 0;
-    fMapMixBins.clear();
-    fMap_Tracks_per_collision.clear();
-  }
+  EventMixingHandler() = default;
 
   explicit EventMixingHandler(int ndepth)
   {
     fNdepth = ndepth;
-    fMapMixBins.clear();
-    fMap_Tracks_per_collision.clear();
   }
 
-  ~EventMixingHandler()
-  {
-    fMapMixBins.clear();
-    fMap_Tracks_per_collision.clear();
-  }
+  ~EventMixingHandler() = default;
 
   void SetNdepth(int ndepth) { fNdepth = ndepth; }
 
   void ReserveNTracksPerCollision(U key_df_collision, int ntrack)
   {
-    fMap_Tracks_per_collision[key_df_collision].reserve(ntrack);
+    fTracks[GetTrackSlot(key_df_collision)].reserve(ntrack);
   }
 
   void AddTrackToEventPool(U key_df_collision, V obj)
   {
-    fMap_Tracks_per_collision[key_df_collision].emplace_back(obj);
+    fTracks[GetTrackSlot(key_df_collision)].emplace_back(obj);
   }
 
-  std::vector<U> GetCollisionIdsFromEventPool(T key_bin) { return fMapMixBins[key_bin]; }
-  std::vector<V> GetTracksPerCollision(T key_bin, int index) { return fMap_Tracks_per_collision[fMapMixBins[key_bin][index]]; }
-  std::vector<V> GetTracksPerCollision(U key_df_collision) { return fMap_Tracks_per_collision[key_df_collision]; }
+  std::span<const U> GetCollisionIdsFromEventPool(T key_bin) const
+  {
+    auto itr = fMixBinIndex.find(key_bin);
+    if (itr == fMixBinIndex.end()) {
+      return {};
+    }
+    return fMixBins[itr->second].GetCollisionIds();
+  }
+
+  std::span<const V> GetTracksPerCollision(T key_bin, int index) const { return GetTracksPerCollision(GetCollisionIdsFromEventPool(key_bin)[index]); }
+
+  std::span<const V> GetTracksPerCollision(U key_df_collision) const
+  {
+    auto itr = fTrackSlotIndex.find(key_df_collision);
+    if (itr == fTrackSlotIndex.end()) {
+      return {};
+    }
+    return fTracks[itr->second];
+  }
 
   // call this function at the end of collision loop
   void AddCollisionIdAtLast(T key_bin, U key_df_collision)
   {
-    // LOGF(info, "fMapMixBins[key_bin].size() = %d", fMapMixBins[key_bin].size());
-    if (static_cast<int>(fMapMixBins[key_bin].size()) >= fNdepth) {
-      fMap_Tracks_per_collision[fMapMixBins[key_bin][0]].clear();
-      fMap_Tracks_per_collision[fMapMixBins[key_bin][0]].shrink_to_fit();
-      fMapMixBins[key_bin].erase(fMapMixBins[key_bin].begin());
+    auto itr = fMixBinIndex.find(key_bin);
+    if (itr == fMixBinIndex.end()) {
+      itr = fMixBinIndex.emplace(key_bin, static_cast<int>(fMixBins.size())).first;
+      fMixBins.emplace_back();
     }
-    fMapMixBins[key_bin].emplace_back(key_df_collision);
+    auto& mixBin = fMixBins[itr->second];
+    if (mixBin.Size() > 0 && static_cast<int>(mixBin.Size()) >= fNdepth) {
+      ReleaseTrackSlot(mixBin.Front());
+      mixBin.PopFront(fNdepth);
+    }
+    mixBin.PushBack(key_df_collision);
   }
 
  private:
-  int fNdepth;                                           // depth of event mixing
-  std::map<T, std::vector<U>> fMapMixBins;               // map : e.g. <zbin, centbin, epbin> -> pair<df index, global collision index>
-  std::map<U, std::vector<V>> fMap_Tracks_per_collision; // map : e.g. pair<df index, global collision index> -> track array
+  // collision keys of one mixing bin, oldest first. The oldest key is removed by moving the start of the ring,
+  // and the keys are moved back to the front of the buffer once the start has moved by the depth (amortised O(1))
+  class MixBin
+  {
+   public:
+    std::size_t Size() const { return fCollisionIds.size() - fFirst; }
+    const U& Front() const { return fCollisionIds[fFirst]; }
+    std::span<const U> GetCollisionIds() const { return std::span<const U>(fCollisionIds.data() + fFirst, Size()); }
+
+    void PopFront(int ndepth)
+    {
+      if (++fFirst >= static_cast<std::size_t>(ndepth)) {
+        fCollisionIds.erase(fCollisionIds.begin(), fCollisionIds.begin() + fFirst);
+        fFirst = 0;
+      }
+    }
+    void PushBack(const U& key_df_collision) { fCollisionIds.emplace_back(key_df_collision); }
+
+   private:
+    std::vector<U> fCollisionIds{};
+    std::size_t fFirst = 0; // position of the oldest collision key
+  };
+
+  int GetTrackSlot(const U& key_df_collision)
+  {
+    auto itr = fTrackSlotIndex.find(key_df_collision);
+    if (itr != fTrackSlotIndex.end()) {
+      return itr->second;
+    }
+    int slot = 0;
+    if (fFreeTrackSlots.empty()) {
+      slot = static_cast<int>(fTracks.size());
+      fTracks.emplace_back();
+    } else {
+      slot = fFreeTrackSlots.back();
+      fFreeTrackSlots.pop_back();
+    }
+    fTrackSlotIndex.emplace(key_df_collision, slot);
+    return slot;
+  }
+
+  void ReleaseTrackSlot(const U& key_df_collision)
+  {
+    auto itr = fTrackSlotIndex.find(key_df_collision);
+    if (itr == fTrackSlotIndex.end()) {
+      return;
+    }
+    fTracks[itr->second].clear(); // keep the capacity for the next collision
+    fFreeTrackSlots.emplace_back(itr->second);
+    fTrackSlotIndex.erase(itr);
+  }
+
+  int fNdepth = 0;                                                  // depth of event mixing
+  std::unordered_map<T, int, EventMixingKeyHash> fMixBinIndex{};    // map : e.g. <zbin, centbin, epbin> -> index in fMixBins
+  std::vector<MixBin> fMixBins{};                                   // e.g. pair<df index, global collision index> of the collisions in the pool of each mixing bin
+  std::unordered_map<U, int, EventMixingKeyHash> fTrackSlotIndex{}; // map : e.g. pair<df index, global collision index> -> index in fTracks
+  std::vector<std::vector<V>> fTracks{};                            // track array of each collision
+  std::vector<int> fFreeTrackSlots{};                               // indices in fTracks which can be reused
 };
 } // namespace o2::aod::pwgem::dilepton::utils
 #endif // PWGEM_DILEPTON_UTILS_EVENTMIXINGHANDLER_H_
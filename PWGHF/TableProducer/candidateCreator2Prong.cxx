@@ -108,14 +108,17 @@ struct HfCandidateCreator2Prong {
   Configurable<double> minParamChange{"minParamChange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
   Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations is chi2/chi2old > this"};
   Configurable<bool> fillHistograms{"fillHistograms", true, "do validation plots"};
+  Configurable<int> nThreadsFit{"nThreadsFit", 1, "number of threads for the secondary-vertex fits with DCAFitterN (1: sequential)"};
   // magnetic field setting from CCDB
   Configurable<bool> isRun2{"isRun2", false, "enable Run 2 or Run 3 GRP objects for magnetic field"};
   Configurable<std::string> ccdbUrl{"ccdbUrl", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> ccdbPathGrp{"ccdbPathGrp", "GLO/GRP/GRP", "Path of the grp file (Run 2)"};
   Configurable<std::string> ccdbPathGrpMag{"ccdbPathGrpMag", "GLO/Config/GRPMagField", "CCDB path of the GRPMagField object (Run 3)"};
 
-  HfEventSelection hfEvSel;        // event selection and monitoring
-  o2::vertexing::DCAFitterN<2> df; // 2-prong vertex fitter
+  HfEventSelection hfEvSel;               // event selection and monitoring
+  o2::vertexing::DCAFitterN<2> df;        // 2-prong vertex fitter
+  std::vector<SVFitResult<2>> fitResults; // inputs and outputs of the DCAFitterN fits of the candidates
+  WorkerPool fitWorkers;                  // threads of the DCAFitterN fits, kept across the collisions
   Service<o2::ccdb::BasicCCDBManager> ccdb{};
 
   int runNumber{0};
@@ -200,6 +203,7 @@ struct HfCandidateCreator2Prong {
       df.setMinRelChi2Change(minRelChi2Change);
       df.setUseAbsDCA(useAbsDCA);
       df.setWeightedFinalPCA(useWeightedFinalPCA);
+      fitWorkers.start(nThreadsFit - 1);
     }
     if (std::accumulate(doprocessKF.begin(), doprocessKF.end(), 0) == 1) {
       registry.fill(HIST("hVertexerType"), aod::hf_cand::VertexerType::KfParticle);
@@ -220,8 +224,11 @@ struct HfCandidateCreator2Prong {
                                       TTracks const&,
                                       BCsType const& bcs)
   {
-    // loop over pairs of track indices
+    // collect the candidates satisfying the event selections, with the magnetic field of their collision
+    fitResults.assign(rowsTrackIndexProng2.size(), {});
+    std::size_t iCand{0};
     for (const auto& rowTrackIndexProng2 : rowsTrackIndexProng2) {
+      auto& fitResult = fitResults[iCand++];
 
       /// reject candidates not satisfying the event selections
       auto collision = rowTrackIndexProng2.template collision_as<Coll>();
@@ -239,8 +246,7 @@ struct HfCandidateCreator2Prong {
 
       auto track0 = rowTrackIndexProng2.template prong0_as<TTracks>();
       auto track1 = rowTrackIndexProng2.template prong1_as<TTracks>();
-      auto trackParVarPos1 = getTrackParCov(track0);
-      auto trackParVarNeg1 = getTrackParCov(track1);
+      fitResult.tracks = {getTrackParCov(track0), getTrackParCov(track1)};
 
       /// Set the magnetic field from ccdb.
       /// The static instance of the propagator was already modified in the HFTrackIndexSkimCreator,
@@ -251,33 +257,44 @@ struct HfCandidateCreator2Prong {
         initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, nullptr, isRun2);
         bz = o2::base::Propagator::Instance()->getNominalBz();
         LOG(info) << ">>>>>>>>>>>> Magnetic field: " << bz;
-        // df.setBz(bz); /// put it outside the 'if'! Otherwise we have a difference wrt bz Configurable (< 1 permille) in Run2 conv. data
-        // df.print();
       }
-      df.setBz(bz);
+      fitResult.bz = bz;
+      fitResult.isSelected = true;
+    }
 
-      // reconstruct the 2-prong secondary vertex
+    // reconstruct the 2-prong secondary vertices
+    fitSecondaryVertices(df, fitResults, fitWorkers);
+
+    // loop over pairs of track indices
+    iCand = 0;
+    for (const auto& rowTrackIndexProng2 : rowsTrackIndexProng2) {
+      auto& fitResult = fitResults[iCand++];
+      if (!fitResult.isSelected) {
+        continue;
+      }
       hCandidates->Fill(SVFitting::BeforeFit);
-      try {
-        if (df.process(trackParVarPos1, trackParVarNeg1) == 0) {
-          continue;
-        }
-      } catch (const std::runtime_error& error) {
-        LOG(info) << "Run time error found: " << error.what() << ". DCAFitterN cannot work, skipping the candidate.";
+      if (fitResult.nVertices < 0) {
+        LOG(info) << "Run time error found: " << fitResult.error << ". DCAFitterN cannot work, skipping the candidate.";
         hCandidates->Fill(SVFitting::Fail);
         continue;
       }
+      if (fitResult.nVertices == 0) {
+        continue;
+      }
       hCandidates->Fill(SVFitting::FitOk);
 
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
+      auto collision = rowTrackIndexProng2.template collision_as<Coll>();
+      auto track0 = rowTrackIndexProng2.template prong0_as<TTracks>();
+      auto track1 = rowTrackIndexProng2.template prong1_as<TTracks>();
+      const auto& secondaryVertex = fitResult.secondaryVertex;
+      const auto chi2PCA = fitResult.chi2PCA;
+      const auto& covMatrixPCA = fitResult.covMatrixPCA;
       registry.fill(HIST("hCovSVXX"), covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
       registry.fill(HIST("hCovSVYY"), covMatrixPCA[2]);
       registry.fill(HIST("hCovSVXZ"), covMatrixPCA[3]);
       registry.fill(HIST("hCovSVZZ"), covMatrixPCA[5]);
-      auto trackParVar0 = df.getTrack(0);
-      auto trackParVar1 = df.getTrack(1);
+      auto trackParVar0 = fitResult.tracks[0];
+      auto trackParVar1 = fitResult.tracks[1];
 
       // get track momenta
       std::array<float, 3> pvec0{};
@@ -311,8 +328,8 @@ struct HfCandidateCreator2Prong {
       registry.fill(HIST("hCovPVZZ"), covMatrixPV[5]);
       o2::dataformats::DCA impactParameter0;
       o2::dataformats::DCA impactParameter1;
-      trackParVar0.propagateToDCA(primaryVertex, bz, &impactParameter0);
-      trackParVar1.propagateToDCA(primaryVertex, bz, &impactParameter1);
+      trackParVar0.propagateToDCA(primaryVertex, fitResult.bz, &impactParameter0);
+      trackParVar1.propagateToDCA(primaryVertex, fitResult.bz, &impactParameter1);
       registry.fill(HIST("hDcaXYProngs"), track0.pt(), impactParameter0.getY() * CentiToMicro);
       registry.fill(HIST("hDcaXYProngs"), track1.pt(), impactParameter1.getY() * CentiToMicro);
       registry.fill(HIST("hDcaZProngs"), track0.pt(), impactParameter0.getZ() * CentiToMicro);
@@ -128,6 +128,7 @@ struct HfCandidateCreator3Prong {
   Configurable<double> minParamChange{"minParamChange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
   Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations is chi2/chi2old > this"};
   Configurable<bool> fillHistograms{"fillHistograms", true, "do validation plots"};
+  Configurable<int> nThreadsFit{"nThreadsFit", 1, "number of threads for the secondary-vertex fits with DCAFitterN (1: sequential)"};
   // magnetic field setting from CCDB
   Configurable<bool> isRun2{"isRun2", false, "enable Run 2 or Run 3 GRP objects for magnetic field"};
   Configurable<std::string> ccdbUrl{"ccdbUrl", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
@@ -145,8 +146,10 @@ struct HfCandidateCreator3Prong {
 
   Configurable<LabeledArray<float>> tpcPidBBParamsLightNuclei{"tpcPidBBParamsLightNuclei", {hf_presel_lightnuclei::BetheBlochParams[0], hf_presel_lightnuclei::NParticleRows, hf_presel_lightnuclei::NBetheBlochParams, hf_presel_lightnuclei::labelsRowsNucleiType, hf_presel_lightnuclei::labelsBetheBlochParams}, "TPC PID Bethe–Bloch parameter configurations for light nuclei (deuteron, triton, helium-3, alpha)"};
 
-  HfEventSelection hfEvSel;        // event selection and monitoring
-  o2::vertexing::DCAFitterN<3> df; // 3-prong vertex fitter
+  HfEventSelection hfEvSel;               // event selection and monitoring
+  o2::vertexing::DCAFitterN<3> df;        // 3-prong vertex fitter
+  std::vector<SVFitResult<3>> fitResults; // inputs and outputs of the DCAFitterN fits of the candidates
+  WorkerPool fitWorkers;                  // threads of the DCAFitterN fits, kept across the collisions
   Service<o2::ccdb::BasicCCDBManager> ccdb{};
 
   int runNumber{0};
@@ -246,6 +249,7 @@ struct HfCandidateCreator3Prong {
     df.setMinRelChi2Change(static_cast<float>(minRelChi2Change));
     df.setUseAbsDCA(useAbsDCA);
     df.setWeightedFinalPCA(useWeightedFinalPCA);
+    fitWorkers.start(nThreadsFit - 1);
 
     ccdb->setURL(ccdbUrl);
     ccdb->setCaching(true);
@@ -294,8 +298,11 @@ struct HfCandidateCreator3Prong {
                                       TracksWCovExtraPidPiKaPrLightNuclei const&,
                                       BCsType const& bcs)
   {
-    // loop over triplets of track indices
+    // collect the candidates satisfying the event selections, with the magnetic field of their collision
+    fitResults.assign(rowsTrackIndexProng3.size(), {});
+    std::size_t iCand{0};
     for (const auto& rowTrackIndexProng3 : rowsTrackIndexProng3) {
+      auto& fitResult = fitResults[iCand++];
 
       /// reject candidates in collisions not satisfying the event selections
       auto collision = rowTrackIndexProng3.template collision_as<Coll>();
@@ -314,9 +321,7 @@ struct HfCandidateCreator3Prong {
       auto track0 = rowTrackIndexProng3.template prong0_as<TracksWCovExtraPidPiKaPrLightNuclei>();
       auto track1 = rowTrackIndexProng3.template prong1_as<TracksWCovExtraPidPiKaPrLightNuclei>();
       auto track2 = rowTrackIndexProng3.template prong2_as<TracksWCovExtraPidPiKaPrLightNuclei>();
-      auto trackParVar0 = getTrackParCov(track0);
-      auto trackParVar1 = getTrackParCov(track1);
-      auto trackParVar2 = getTrackParCov(track2);
+      fitResult.tracks = {getTrackParCov(track0), getTrackParCov(track1), getTrackParCov(track2)};
 
       /// Set the magnetic field from ccdb.
       /// The static instance of the propagator was already modified in the HFTrackIndexSkimCreator,
@@ -327,34 +332,46 @@ struct HfCandidateCreator3Prong {
         initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, nullptr, isRun2);
         bz = o2::base::Propagator::Instance()->getNominalBz();
         LOG(info) << ">>>>>>>>>>>> Magnetic field: " << bz;
-        // df.setBz(bz); /// put it outside the 'if'! Otherwise we have a difference wrt bz Configurable (< 1 permille) in Run2 conv. data
-        // df.print();
       }
-      df.setBz(static_cast<float>(bz));
+      fitResult.bz = bz;
+      fitResult.isSelected = true;
+    }
+
+    // reconstruct the 3-prong secondary vertices
+    fitSecondaryVertices(df, fitResults, fitWorkers);
 
-      // reconstruct the 3-prong secondary vertex
+    // loop over triplets of track indices
+    iCand = 0;
+    for (const auto& rowTrackIndexProng3 : rowsTrackIndexProng3) {
+      auto& fitResult = fitResults[iCand++];
+      if (!fitResult.isSelected) {
+        continue;
+      }
       hCandidates->Fill(SVFitting::BeforeFit);
-      try {
-        if (df.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
-          continue;
-        }
-      } catch (const std::runtime_error& error) {
-        LOG(info) << "Run time error found: " << error.what() << ". DCAFitterN cannot work, skipping the candidate.";
+      if (fitResult.nVertices < 0) {
+        LOG(info) << "Run time error found: " << fitResult.error << ". DCAFitterN cannot work, skipping the candidate.";
         hCandidates->Fill(SVFitting::Fail);
         continue;
       }
+      if (fitResult.nVertices == 0) {
+        continue;
+      }
       hCandidates->Fill(SVFitting::FitOk);
 
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
+      auto collision = rowTrackIndexProng3.template collision_as<Coll>();
+      auto track0 = rowTrackIndexProng3.template prong0_as<TracksWCovExtraPidPiKaPrLightNuclei>();
+      auto track1 = rowTrackIndexProng3.template prong1_as<TracksWCovExtraPidPiKaPrLightNuclei>();
+      auto track2 = rowTrackIndexProng3.template prong2_as<TracksWCovExtraPidPiKaPrLightNuclei>();
+      const auto& secondaryVertex = fitResult.secondaryVertex;
+      const auto chi2PCA = fitResult.chi2PCA;
+      const auto& covMatrixPCA = fitResult.covMatrixPCA;
       registry.fill(HIST("hCovSVXX"), covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
       registry.fill(HIST("hCovSVYY"), covMatrixPCA[2]);
       registry.fill(HIST("hCovSVXZ"), covMatrixPCA[3]);
       registry.fill(HIST("hCovSVZZ"), covMatrixPCA[5]);
-      trackParVar0 = df.getTrack(0);
-      trackParVar1 = df.getTrack(1);
-      trackParVar2 = df.getTrack(2);
+      auto trackParVar0 = fitResult.tracks[0];
+      auto trackParVar1 = fitResult.tracks[1];
+      auto trackParVar2 = fitResult.tracks[2];
 
       // get track momenta
       std::array<float, 3> pvec0{};
@@ -391,9 +408,9 @@ struct HfCandidateCreator3Prong {
       o2::dataformats::DCA impactParameter0;
       o2::dataformats::DCA impactParameter1;
       o2::dataformats::DCA impactParameter2;
-      trackParVar0.propagateToDCA(primaryVertex, bz, &impactParameter0);
-      trackParVar1.propagateToDCA(primaryVertex, bz, &impactParameter1);
-      trackParVar2.propagateToDCA(primaryVertex, bz, &impactParameter2);
+      trackParVar0.propagateToDCA(primaryVertex, fitResult.bz, &impactParameter0);
+      trackParVar1.propagateToDCA(primaryVertex, fitResult.bz, &impactParameter1);
+      trackParVar2.propagateToDCA(primaryVertex, fitResult.bz, &impactParameter2);
       registry.fill(HIST("hDcaXYProngs"), track0.pt(), impactParameter0.getY() * CentiToMicro);
       registry.fill(HIST("hDcaXYProngs"), track1.pt(), impactParameter1.getY() * CentiToMicro);
       registry.fill(HIST("hDcaXYProngs"), track2.pt(), impactParameter2.getY() * CentiToMicro);
@@ -98,6 +98,7 @@ struct HfCandidateSelectorD0 {
   Configurable<std::vector<std::string>> onnxFileNames{"onnxFileNames", std::vector<std::string>{"ModelHandler_onnx_D0ToKPi.onnx"}, "ONNX file names for each pT bin (if not from CCDB full path)"};
   Configurable<int64_t> timestampCCDB{"timestampCCDB", -1, "timestamp of the ONNX file for ML model used to query in CCDB"};
   Configurable<bool> loadModelsFromCCDB{"loadModelsFromCCDB", false, "Flag to enable or disable the loading of models from CCDB"};
+  Configurable<std::vector<int>> mlBackends{"mlBackends", std::vector<int>{}, "Inference backend for each pT bin: 0 = ONNX Runtime, 1 = native tree ensemble, 2 = native tree ensemble validated against ONNX Runtime (empty: ONNX Runtime)"};
   // Mass Cut for trigger analysis
   Configurable<bool> useTriggerMassCut{"useTriggerMassCut", false, "Flag to enable parametrize pT differential mass cut for triggered data"};
 
@@ -148,6 +149,7 @@ struct HfCandidateSelectorD0 {
         hfMlResponse.setModelPathsLocal(onnxFileNames);
       }
       hfMlResponse.cacheInputFeaturesIndices(namesInputFeatures);
+      hfMlResponse.setBackends(mlBackends);
       hfMlResponse.init();
     }
   }
@@ -29,6 +29,7 @@
 #include "PWGHF/Utils/utilsAnalysis.h"
 #include "PWGHF/Utils/utilsBfieldCCDB.h"
 #include "PWGHF/Utils/utilsEvSelHf.h"
+#include "PWGHF/Utils/utilsPvRefitHf.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 
 #include "Common/CCDB/TriggerAliases.h"
@@ -51,8 +52,9 @@
 #include <CommonUtils/ConfigurableParam.h>
 #include <DCAFitter/DCAFitterN.h>
 #include <DetectorsBase/MatLayerCylSet.h>
-#include <DetectorsBase/Propagator.h>     // for PV refit
-#include <DetectorsVertexing/PVertexer.h> // for PV refit
+#include <DetectorsBase/Propagator.h>           // for PV refit
+#include <DetectorsVertexing/PVertexer.h>       // for PV refit
+#include <DetectorsVertexing/PVertexerParams.h> // for PV refit
 #include <Framework/ASoA.h>
 #include <Framework/AnalysisDataModel.h>
 #include <Framework/AnalysisHelpers.h>
@@ -66,6 +68,8 @@
 #include <Framework/Logger.h>
 #include <Framework/runDataProcessing.h>
 #include <MathUtils/BetheBlochAleph.h>
+#include <ReconstructionDataFormats/HelixHelper.h>
+#include <ReconstructionDataFormats/PrimaryVertex.h> // for PV refit
 #include <ReconstructionDataFormats/Track.h>
 #include <ReconstructionDataFormats/Vertex.h> // for PV refit
 
@@ -78,10 +82,12 @@
 
 #include <algorithm> // std::find
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <iterator> // std::distance
+#include <memory>   // std::unique_ptr
 #include <numeric>
 #include <string>  // std::string
 #include <utility> // std::forward
@@ -297,6 +303,10 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     Configurable<bool> doPvRefit{"doPvRefit", false, "do PV refit excluding the considered track"};
     Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
     Configurable<bool> debugPvRefit{"debugPvRefit", false, "debug lines for primary vertex refit"};
+    Configurable<bool> doPvRefitDowndate{"doPvRefitDowndate", false, "do PV refit by removing the track from the PV fitted with all the contributors, instead of refitting from scratch"};
+    Configurable<float> pvRefitDowndateMaxChi2Track{"pvRefitDowndateMaxChi2Track", 25.f, "max. chi2 of the track to the PV for the PV refit by removal (full refit otherwise)"};
+    Configurable<float> pvRefitDowndateMinDetRatio{"pvRefitDowndateMinDetRatio", 1.e-3f, "min. ratio of the PV weight-matrix determinants without and with the track for the PV refit by removal (full refit otherwise)"};
+    Configurable<bool> validatePvRefitDowndate{"validatePvRefitDowndate", false, "also refit the PV from scratch for the PV refits by removal and fill the differences (validation only, slow)"};
     // Configurable<double> bz{"bz", 5., "bz field"};
     // quality cut
     Configurable<bool> doCutQuality{"doCutQuality", true, "apply quality cuts"};
@@ -478,6 +488,13 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
         registry.add("PvRefit/hPvRefitZChi2Minus1", "PV refit with #it{#chi}^{2}==#minus1", kTH2D, {axisCollisionZ, axisCollisionZOriginal});
         registry.add("PvRefit/hNContribPvRefitNotDoable", "N. contributors for PV refit not doable", kTH1D, {axisCollisionNContrib});
         registry.add("PvRefit/hNContribPvRefitChi2Minus1", "N. contributors original PV for PV refit #it{#chi}^{2}==#minus1", kTH1D, {axisCollisionNContrib});
+        registry.add("PvRefit/hNContribPvRefitDowndateFallback", "N. contributors original PV for PV refit by removal not reliable", kTH1D, {axisCollisionNContrib});
+        if (config.validatePvRefitDowndate) {
+          registry.add("PvRefit/hDowndatePullXvsNContrib", "PV refit by removal #minus full PV refit", kTH2D, {axisCollisionNContrib, {200, -2.f, 2.f, "#Delta x_{PV} / #sigma_{x} full refit"}});
+          registry.add("PvRefit/hDowndatePullYvsNContrib", "PV refit by removal #minus full PV refit", kTH2D, {axisCollisionNContrib, {200, -2.f, 2.f, "#Delta y_{PV} / #sigma_{y} full refit"}});
+          registry.add("PvRefit/hDowndatePullZvsNContrib", "PV refit by removal #minus full PV refit", kTH2D, {axisCollisionNContrib, {200, -2.f, 2.f, "#Delta z_{PV} / #sigma_{z} full refit"}});
+          registry.add("PvRefit/hDowndateSigmaRatioZvsNContrib", "PV refit by removal over full PV refit", kTH2D, {axisCollisionNContrib, {200, 0.5f, 1.5f, "#sigma_{z} removal / #sigma_{z} full refit"}});
+        }
       }
 
       ccdb->setURL(config.ccdbUrl);
@@ -935,27 +952,19 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     }
   }
 
-  /// Method for the PV refit and DCA recalculation for tracks with a collision assigned
+  /// Method to prepare the PV refits of the tracks of a collision
   /// \param collision is a collision
-  /// \param bcWithTimeStamps is a table of bunch crossing joined with timestamps used to query the CCDB for B and material budget
-  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the current collision
   /// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the current collision
-  /// \param trackToRemove is the track to be removed, if contributor, from the PV refit
-  /// \param pvCoord is an array containing the coordinates of the refitted PV
-  /// \param pvCovMatrix is an array containing the covariance matrix values of the refitted PV
-  /// \param dcaXYdcaZ is an array containing the dcaXY and dcaZ of trackToRemove with respect to the refitted PV
-  template <typename TTrack>
-  void performPvRefitTrack(aod::Collision const& collision,
-                           aod::BCsWithTimestamps const&,
-                           std::vector<int64_t> const& vecPvContributorGlobId,
-                           std::vector<o2::track::TrackParCov> const& vecPvContributorTrackParCov,
-                           TTrack const& trackToRemove,
-                           std::array<float, 3>& pvCoord,
-                           std::array<float, 6>& pvCovMatrix,
-                           std::array<float, 2>& dcaXYdcaZ)
+  /// \param primVtx is the vertex used to initialise the vertexer
+  /// \param vertexer is the vertexer to be prepared for the PV refits
+  /// \param pvRefitDowndate is the leave-one-out PV refit, prepared if doPvRefitDowndate is enabled
+  /// \return true if the PV refit is doable
+  bool preparePvRefit(aod::Collision const& collision,
+                      std::vector<o2::track::TrackParCov> const& vecPvContributorTrackParCov,
+                      o2::dataformats::VertexBase& primVtx,
+                      o2::vertexing::PVertexer& vertexer,
+                      o2::hf_pv_refit::PvRefitDowndate& pvRefitDowndate)
   {
-    std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
-
     /// Prepare the vertex refitting
     // set the magnetic field from CCDB
     const auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
@@ -986,25 +995,63 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     }*/
 
     // build the VertexBase to initialize the vertexer
-    o2::dataformats::VertexBase primVtx;
     primVtx.setX(collision.posX());
     primVtx.setY(collision.posY());
     primVtx.setZ(collision.posZ());
     primVtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
     // configure PVertexer
-    o2::vertexing::PVertexer vertexer;
     o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); /// remove diamond constraint (let's keep it at the moment...)
     vertexer.init();
     const bool pvRefitDoable = vertexer.prepareVertexRefit(vecPvContributorTrackParCov, primVtx);
+    if (config.debugPvRefit) {
+      LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib() << " Vtx= " << primVtx.asString();
+    }
+
+    /// fit the PV once with all the contributors, the PV refits are then obtained by removing each track from it
+    if (config.doPvRefitDowndate && pvRefitDoable) {
+      const std::vector<bool> vecPvRefitContributorAll(vecPvContributorTrackParCov.size(), true);
+      const auto primVtxRefitAll = vertexer.refitVertex(vecPvRefitContributorAll, primVtx);
+      // track weights as in the PVertexer fit
+      const auto& pvertexerParams = o2::vertexing::PVertexerParams::Instance();
+      const o2::hf_pv_refit::VertexerSettings vertexerSettings{pvertexerParams.sysErrY2, pvertexerParams.sysErrZ2, pvertexerParams.tukey};
+      if (!pvRefitDowndate.init(primVtxRefitAll, vecPvContributorTrackParCov, o2::base::Propagator::Instance()->getNominalBz(), vertexerSettings, config.pvRefitDowndateMaxChi2Track, config.pvRefitDowndateMinDetRatio) && config.debugPvRefit) {
+        LOG(info) << "---> PV refit with all the contributors not usable (chi2 = " << primVtxRefitAll.getChi2() << "), PV refits done from scratch";
+      }
+    }
+    return pvRefitDoable;
+  }
+
+  /// Method for the PV refit and DCA recalculation for tracks with a collision assigned
+  /// \param collision is a collision
+  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the current collision
+  /// \param vecPvRefitContributorUsed is a vector flagging the PV contributors used in the PV refit (all true on input and output)
+  /// \param primVtx is the vertex used to initialise the vertexer
+  /// \param vertexer is the vertexer prepared by preparePvRefit
+  /// \param pvRefitDoable is the outcome of preparePvRefit
+  /// \param pvRefitDowndate is the leave-one-out PV refit prepared by preparePvRefit
+  /// \param trackToRemove is the track to be removed, if contributor, from the PV refit
+  /// \param pvCoord is an array containing the coordinates of the refitted PV
+  /// \param pvCovMatrix is an array containing the covariance matrix values of the refitted PV
+  /// \param dcaXYdcaZ is an array containing the dcaXY and dcaZ of trackToRemove with respect to the refitted PV
+  template <typename TTrack>
+  void performPvRefitTrack(aod::Collision const& collision,
+                           std::vector<int64_t> const& vecPvContributorGlobId,
+                           std::vector<bool>& vecPvRefitContributorUsed,
+                           o2::dataformats::VertexBase const& primVtx,
+                           o2::vertexing::PVertexer& vertexer,
+                           const bool pvRefitDoable,
+                           o2::hf_pv_refit::PvRefitDowndate const& pvRefitDowndate,
+                           TTrack const& trackToRemove,
+                           std::array<float, 3>& pvCoord,
+                           std::array<float, 6>& pvCovMatrix,
+                           std::array<float, 2>& dcaXYdcaZ)
+  {
     if (!pvRefitDoable) {
       LOG(info) << "Not enough tracks accepted for the refit";
       if (config.doPvRefit && config.fillHistograms) {
         registry.fill(HIST("PvRefit/hNContribPvRefitNotDoable"), collision.numContrib());
       }
     }
-    if (config.debugPvRefit) {
-      LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib() << " Vtx= " << primVtx.asString();
-    }
 
     if (config.fillHistograms) {
       registry.fill(HIST("PvRefit/hVerticesPerTrack"), 1);
@@ -1025,7 +1072,21 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
 
         vecPvRefitContributorUsed[entry] = false; /// remove the track from the PV refitting
 
-        const auto primVtxRefitted = vertexer.refitVertex(vecPvRefitContributorUsed, primVtx); // vertex refit
+        o2::dataformats::PrimaryVertex primVtxRefitted;
+        if (!config.doPvRefitDowndate || !pvRefitDowndate.removeContributor(entry, primVtxRefitted)) {
+          if (config.doPvRefitDowndate && config.fillHistograms) {
+            registry.fill(HIST("PvRefit/hNContribPvRefitDowndateFallback"), collision.numContrib());
+          }
+          primVtxRefitted = vertexer.refitVertex(vecPvRefitContributorUsed, primVtx); // vertex refit
+        } else if (config.validatePvRefitDowndate && config.fillHistograms) {
+          const auto primVtxRefittedFull = vertexer.refitVertex(vecPvRefitContributorUsed, primVtx);
+          if (primVtxRefittedFull.getChi2() >= 0) {
+            registry.fill(HIST("PvRefit/hDowndatePullXvsNContrib"), collision.numContrib(), (primVtxRefitted.getX() - primVtxRefittedFull.getX()) / std::sqrt(primVtxRefittedFull.getSigmaX2()));
+            registry.fill(HIST("PvRefit/hDowndatePullYvsNContrib"), collision.numContrib(), (primVtxRefitted.getY() - primVtxRefittedFull.getY()) / std::sqrt(primVtxRefittedFull.getSigmaY2()));
+            registry.fill(HIST("PvRefit/hDowndatePullZvsNContrib"), collision.numContrib(), (primVtxRefitted.getZ() - primVtxRefittedFull.getZ()) / std::sqrt(primVtxRefittedFull.getSigmaZ2()));
+            registry.fill(HIST("PvRefit/hDowndateSigmaRatioZvsNContrib"), collision.numContrib(), std::sqrt(primVtxRefitted.getSigmaZ2() / primVtxRefittedFull.getSigmaZ2()));
+          }
+        }
         // LOG(info) << "refit " << cnt << "/" << ntr << " result = " << primVtxRefitted.asString();
         if (config.debugPvRefit) {
           LOG(info) << "refit for track with global index " << static_cast<int>(trackToRemove.globalIndex()) << " " << primVtxRefitted.asString();
@@ -1048,7 +1109,7 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
           registry.fill(HIST("PvRefit/hChi2vsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getChi2());
         }
 
-        vecPvRefitContributorUsed[entry] = true; /// restore the track for the next PV refitting (probably not necessary here)
+        vecPvRefitContributorUsed[entry] = true; /// restore the track for the next PV refitting
 
         if (recalcImpPar) {
           // fill the histograms for refitted PV with good Chi2
@@ -1131,7 +1192,7 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
                        TTracks const& tracks,
                        GroupedTrackIndices const& trackIndicesCollision,
                        GroupedPvContributors const& pvContrCollision,
-                       aod::BCsWithTimestamps const& bcWithTimeStamps,
+                       aod::BCsWithTimestamps const&,
                        std::vector<std::array<float, 2>>& pvRefitDcaPerTrack,
                        std::vector<std::array<float, 3>>& pvRefitPvCoordPerTrack,
                        std::vector<std::array<float, 6>>& pvRefitPvCovMatrixPerTrack)
@@ -1139,6 +1200,15 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     const auto thisCollId = collision.globalIndex();
     auto tracksWithItsPid = soa::Attach<TTracks, aod::pidits::ITSNSigmaDe, aod::pidits::ITSNSigmaTr, aod::pidits::ITSNSigmaHe, aod::pidits::ITSNSigmaAl>(tracks);
 
+    /// PV contributors and vertexer for the PV refit, prepared once per collision at the first contributor track
+    std::vector<int64_t> vecPvContributorGlobId{};
+    std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov{};
+    std::vector<bool> vecPvRefitContributorUsed{};
+    o2::dataformats::VertexBase primVtx;
+    std::unique_ptr<o2::vertexing::PVertexer> vertexer{};
+    o2::hf_pv_refit::PvRefitDowndate pvRefitDowndate;
+    bool pvRefitDoable{false};
+
     for (const auto& trackId : trackIndicesCollision) {
       int statusProng = BIT(CandidateType::NCandidateTypes) - 1; // all bits on
       const auto track = trackId.template track_as<TTracks>();
@@ -1156,20 +1226,24 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
         pvRefitPvCoord = {collision.posX(), collision.posY(), collision.posZ()};
         pvRefitPvCovMatrix = {collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ()};
 
-        /// retrieve PV contributors for the current collision
-        std::vector<int64_t> vecPvContributorGlobId{};
-        std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov{};
-
-        for (const auto& contributor : pvContrCollision) {
-          vecPvContributorGlobId.push_back(contributor.globalIndex());
-          vecPvContributorTrackParCov.push_back(getTrackParCov(contributor));
+        if (!vertexer) {
+          /// retrieve PV contributors for the current collision
+          for (const auto& contributor : pvContrCollision) {
+            vecPvContributorGlobId.push_back(contributor.globalIndex());
+            vecPvContributorTrackParCov.push_back(getTrackParCov(contributor));
+          }
+          vecPvRefitContributorUsed.assign(vecPvContributorGlobId.size(), true);
+          if (config.debugPvRefit) {
+            LOG(info) << "### vecPvContributorGlobId.size()=" << vecPvContributorGlobId.size() << ", vecPvContributorTrackParCov.size()=" << vecPvContributorTrackParCov.size() << ", N. original contributors=" << collision.numContrib();
+          }
+          vertexer = std::make_unique<o2::vertexing::PVertexer>();
+          pvRefitDoable = preparePvRefit(collision, vecPvContributorTrackParCov, primVtx, *vertexer, pvRefitDowndate);
         }
         if (config.debugPvRefit) {
-          LOG(info) << "### vecPvContributorGlobId.size()=" << vecPvContributorGlobId.size() << ", vecPvContributorTrackParCov.size()=" << vecPvContributorTrackParCov.size() << ", N. original contributors=" << collision.numContrib();
           /// Perform the PV refit only for tracks with an assigned collision
           LOG(info) << "[BEFORE performPvRefitTrack] track.collision().globalIndex(): " << collision.globalIndex();
         }
-        performPvRefitTrack(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, track, pvRefitPvCoord, pvRefitPvCovMatrix, pvRefitDcaXYDcaZ);
+        performPvRefitTrack(collision, vecPvContributorGlobId, vecPvRefitContributorUsed, primVtx, *vertexer, pvRefitDoable, pvRefitDowndate, track, pvRefitPvCoord, pvRefitPvCovMatrix, pvRefitDcaXYDcaZ);
         // we subtract the offset since trackIdx is the global index referred to the total track table
         const auto trackIdx = track.globalIndex();
         pvRefitDcaPerTrack[trackIdx] = pvRefitDcaXYDcaZ;
@@ -1413,6 +1487,10 @@ struct HfTrackIndexSkimCreator {
     Configurable<double> maxDZIni{"maxDZIni", 4., "reject (if>0) PCA candidate if tracks DZ exceeds threshold"};
     Configurable<double> minParamChange{"minParamChange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
     Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations if chi2/chi2old > this"};
+    // prefilter of the combinations that cannot give a vertex, applied before the vertex fit
+    Configurable<bool> applyVertexPrefilter{"applyVertexPrefilter", false, "skip the vertex fit of the combinations whose helices do not meet within maxR and maxDZIni"};
+    Configurable<double> prefilterMaxDXYIni{"prefilterMaxDXYIni", 10., "max. XY distance of the helices for the prefilter seeds (must not be smaller than the one of the DCA fitter)"};
+    Configurable<double> prefilterTolerance{"prefilterTolerance", 0.5, "tolerance (cm) added to maxR and maxDZIni in the prefilter"};
     // CCDB
     Configurable<std::string> ccdbUrl{"ccdbUrl", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
     Configurable<std::string> ccdbPathLut{"ccdbPathLut", "GLO/Param/MatLUT", "Path for LUT parametrization"};
@@ -1511,6 +1589,12 @@ struct HfTrackIndexSkimCreator {
   std::array<bool, kN3ProngDecays> hasMlModel3Prong{false};
   o2::ccdb::CcdbApi ccdbApi;
 
+  // starting points of the vertex fit of a pair of tracks, used by the prefilter
+  struct VertexSeeds {
+    int nSeeds{0};
+    std::array<std::array<float, 2>, 2> seedsXY{};
+  };
+
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HfSelCollision>>;
   using TracksWithPVRefitAndDCA = soa::Join<aod::TracksWCovDcaExtra, aod::HfPvRefitTrack>;
   using FilteredTrackAssocSel = soa::Filtered<soa::Join<aod::TrackAssoc, aod::HfSelTrack>>;
@@ -1633,6 +1717,14 @@ struct HfTrackIndexSkimCreator {
       registry.add("hMassCtToTrKPi", "C Triton candidates;inv. mass (Tr K #pi) (GeV/#it{c}^{2});entries", {HistType::kTH1D, {{500, 0., 5.}}});
       registry.add("hMassChToHeKPi", "C Helium3 candidates;inv. mass (He3 K #pi) (GeV/#it{c}^{2});entries", {HistType::kTH1D, {{500, 0., 5.}}});
       registry.add("hMassCaToAlKPi", "C Alpha candidates;inv. mass (Alpha K #pi) (GeV/#it{c}^{2});entries", {HistType::kTH1D, {{500, 2., 7.}}});
+      // vertex prefilter counters
+      if (config.applyVertexPrefilter) {
+        registry.add("hVertexPrefilter", "vertex fits;;entries", {HistType::kTH1D, {{4, 0.5, 4.5}}});
+        registry.get<TH1>(HIST("hVertexPrefilter"))->GetXaxis()->SetBinLabel(1, "2-prong fits");
+        registry.get<TH1>(HIST("hVertexPrefilter"))->GetXaxis()->SetBinLabel(2, "2-prong fits skipped");
+        registry.get<TH1>(HIST("hVertexPrefilter"))->GetXaxis()->SetBinLabel(3, "3-prong fits");
+        registry.get<TH1>(HIST("hVertexPrefilter"))->GetXaxis()->SetBinLabel(4, "3-prong fits skipped");
+      }
 
       // needed for PV refitting
       if (doprocess2And3ProngsWithPvRefit || doprocess2And3ProngsWithPvRefitWithPidForHfFiltersBdt) {
@@ -1993,6 +2085,53 @@ struct HfTrackIndexSkimCreator {
     return static_cast<bool>(decLen >= config.minTwoTrackDecayLengthFor3Prongs);
   }
 
+  /// Method to compute the starting points of the vertex fit of two tracks, as done by the DCA fitter
+  /// \param trackParFirst is the first track
+  /// \param trackParSecond is the second track
+  /// \param bz is the magnetic field
+  /// \returns the crossing points of the two helices in the transverse plane within maxR (with tolerance)
+  template <typename T>
+  VertexSeeds getVertexSeeds(const T& trackParFirst, const T& trackParSecond, const float bz)
+  {
+    VertexSeeds seeds{};
+    const o2::track::TrackAuxPar helixFirst(trackParFirst, bz);
+    const o2::track::TrackAuxPar helixSecond(trackParSecond, bz);
+    o2::track::CrossInfo crossing{};
+    if (!crossing.set(helixFirst, trackParFirst, helixSecond, trackParSecond, config.prefilterMaxDXYIni)) {
+      return seeds;
+    }
+    const float maxR = config.maxR + config.prefilterTolerance;
+    for (int iCross = 0; iCross < crossing.nDCA; iCross++) {
+      if (crossing.xDCA[iCross] * crossing.xDCA[iCross] + crossing.yDCA[iCross] * crossing.yDCA[iCross] <= maxR * maxR) {
+        seeds.seedsXY[seeds.nSeeds++] = {crossing.xDCA[iCross], crossing.yDCA[iCross]};
+      }
+    }
+    return seeds;
+  }
+
+  /// Method to check if tracks can give a vertex, applied before the vertex fit
+  /// The tracks are propagated to the X of each seed in their frame and their Z are compared, as in the initial DZ check of the DCA fitter
+  /// \param seeds are the starting points of the vertex fit, computed with the first two tracks
+  /// \param bz is the magnetic field
+  /// \param trackPars are the tracks of the candidate
+  /// \returns false if no seed can pass the maxR and maxDZIni conditions of the DCA fitter
+  template <typename... T>
+  bool isCompatibleWithVertex(const VertexSeeds& seeds, const float bz, const T&... trackPars)
+  {
+    if (config.maxDZIni <= 0.) {
+      return seeds.nSeeds > 0;
+    }
+    for (int iSeed = 0; iSeed < seeds.nSeeds; iSeed++) {
+      const auto& seed = seeds.seedsXY[iSeed];
+      const std::array zAtSeed{trackPars.getZAt(std::cos(trackPars.getAlpha()) * seed[0] + std::sin(trackPars.getAlpha()) * seed[1], bz)...};
+      const auto [zMin, zMax] = std::minmax_element(zAtSeed.begin(), zAtSeed.end());
+      if (*zMax - *zMin <= config.maxDZIni + config.prefilterTolerance) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   /// Method to perform selections for 3-prong candidates after vertex reconstruction
   /// \param pVecCand is the array for the candidate momentum after reconstruction of secondary vertex
   /// \param secVtx is the secondary vertex
@@ -2364,8 +2503,9 @@ struct HfTrackIndexSkimCreator {
       // set the magnetic field from CCDB
       const auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
       initCCDB(bc, runNumber, ccdb, config.isRun2 ? config.ccdbPathGrp : config.ccdbPathGrpMag, lut, config.isRun2);
-      df2.setBz(o2::base::Propagator::Instance()->getNominalBz());
-      df3.setBz(o2::base::Propagator::Instance()->getNominalBz());
+      const float bz = o2::base::Propagator::Instance()->getNominalBz();
+      df2.setBz(bz);
+      df3.setBz(bz);
 
       // used to calculate number of candidiates per event
       auto nCand2 = rowTrackIndexProng2.lastIndex();
@@ -2415,6 +2555,12 @@ struct HfTrackIndexSkimCreator {
             getPxPyPz(trackParVarNeg1, pVecTrackNeg1);
           }
 
+          // starting points of the vertex fits with the first two tracks, used by the prefilter
+          VertexSeeds seedsPos1Neg1{};
+          if (config.applyVertexPrefilter) {
+            seedsPos1Neg1 = getVertexSeeds(trackParVarPos1, trackParVarNeg1, bz);
+          }
+
           uint isSelected2ProngCand = n2ProngBit; // bitmap for checking status of two-prong candidates (1 is true, 0 is rejected)
 
           if (config.debug) {
@@ -2441,9 +2587,16 @@ struct HfTrackIndexSkimCreator {
 
             if (isSelected2ProngCand > 0) {
               // secondary vertex reconstruction and further 2-prong selections
-              try {
-                nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
-              } catch (...) {
+              if (!config.applyVertexPrefilter || isCompatibleWithVertex(seedsPos1Neg1, bz, trackParVarPos1, trackParVarNeg1)) {
+                try {
+                  nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
+                } catch (...) {
+                }
+              } else if (config.fillHistograms) {
+                registry.fill(HIST("hVertexPrefilter"), 2);
+              }
+              if (config.applyVertexPrefilter && config.fillHistograms) {
+                registry.fill(HIST("hVertexPrefilter"), 1);
               }
 
               if (nVtxFrom2ProngFitter > 0) { // should it be this or > 0 or are they equivalent
@@ -2607,9 +2760,16 @@ struct HfTrackIndexSkimCreator {
 
           // if the cut on the decay length of 3-prongs computed with the first two tracks is enabled and the vertex was not computed for the D0, we compute it now
           if (config.do3Prong && is2ProngCandidateGoodFor3Prong && (config.minTwoTrackDecayLengthFor3Prongs > 0.f || config.maxTwoTrackChi2PcaFor3Prongs < 1.e9f) && nVtxFrom2ProngFitter == 0) { // o2-linter: disable="magic-number" (default maxTwoTrackChi2PcaFor3Prongs is 1.e10)
-            try {
-              nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
-            } catch (...) {
+            if (!config.applyVertexPrefilter || isCompatibleWithVertex(seedsPos1Neg1, bz, trackParVarPos1, trackParVarNeg1)) {
+              try {
+                nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
+              } catch (...) {
+              }
+            } else if (config.fillHistograms) {
+              registry.fill(HIST("hVertexPrefilter"), 2);
+            }
+            if (config.applyVertexPrefilter && config.fillHistograms) {
+              registry.fill(HIST("hVertexPrefilter"), 1);
             }
             if (nVtxFrom2ProngFitter > 0) {
               const auto& secondaryVertex2 = df2.getPCACandidate();
@@ -2669,6 +2829,20 @@ struct HfTrackIndexSkimCreator {
                 }
               }
 
+              // skip the vertex fit (and the PV refit) if the tracks cannot give a vertex
+              if (config.applyVertexPrefilter) {
+                const bool isCompatible = isCompatibleWithVertex(seedsPos1Neg1, bz, trackParVarPos1, trackParVarNeg1, trackParVarPos2);
+                if (config.fillHistograms) {
+                  registry.fill(HIST("hVertexPrefilter"), 3);
+                  if (!isCompatible) {
+                    registry.fill(HIST("hVertexPrefilter"), 4);
+                  }
+                }
+                if (!isCompatible) {
+                  continue;
+                }
+              }
+
               /// PV refit excluding the candidate daughters, if contributors
               std::array pvRefitCoord3Prong2Pos1Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
               std::array pvRefitCovMatrix3Prong2Pos1Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
@@ -2943,6 +3117,20 @@ struct HfTrackIndexSkimCreator {
                 }
               }
 
+              // skip the vertex fit (and the PV refit) if the tracks cannot give a vertex
+              if (config.applyVertexPrefilter) {
+                const bool isCompatible = isCompatibleWithVertex(seedsPos1Neg1, bz, trackParVarNeg1, trackParVarPos1, trackParVarNeg2);
+                if (config.fillHistograms) {
+                  registry.fill(HIST("hVertexPrefilter"), 3);
+                  if (!isCompatible) {
+                    registry.fill(HIST("hVertexPrefilter"), 4);
+                  }
+                }
+                if (!isCompatible) {
+                  continue;
+                }
+              }
+
               /// PV refit excluding the candidate daughters, if contributors
               std::array pvRefitCoord3Prong1Pos2Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
               std::array pvRefitCovMatrix3Prong1Pos2Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
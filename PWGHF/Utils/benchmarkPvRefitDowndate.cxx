@@ -0,0 +1,144 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file benchmarkPvRefitDowndate.cxx
+/// \brief Benchmark of the leave-one-out PV refits versus the number of PV contributors:
+///        PVertexer::refitVertex for each track versus PvRefitDowndate::removeContributor
+///
+/// Usage: o2-hf-benchmark-pv-refit-downdate [number of collisions per number of contributors]
+/// The tracks are generated at a common vertex, with the resolution of ITS-TPC tracks. Only the leave-one-out
+/// refits are timed: prepareVertexRefit is done once per collision by trackIndexSkimCreator in both cases.
+/// The maximum differences of the PV refits by removal to the full refits are printed as well.
+
+#include "PWGHF/Utils/utilsPvRefitHf.h"
+
+#include <CommonUtils/ConfigurableParam.h>
+#include <DetectorsBase/Propagator.h>
+#include <DetectorsVertexing/PVertexer.h>
+#include <DetectorsVertexing/PVertexerParams.h>
+#include <Framework/Logger.h>
+#include <ReconstructionDataFormats/PrimaryVertex.h>
+#include <ReconstructionDataFormats/Track.h>
+#include <ReconstructionDataFormats/Vertex.h>
+
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+constexpr float Bz = 5.f;                                    // magnetic field (kG)
+constexpr std::array<float, 3> PosVertex{0.01f, 0.02f, 1.f}; // position of the generated vertex (cm)
+constexpr float SigmaY = 30.e-4f;                            // resolution of the track Y at the vertex (cm)
+constexpr float SigmaZ = 40.e-4f;                            // resolution of the track Z at the vertex (cm)
+constexpr std::array<int, 9> NContributors{2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+/// Generates a track from the vertex, smeared with its covariance, in the frame rotated by its azimuth
+o2::track::TrackParCov generateTrack(TRandom3& random)
+{
+  const float alpha = random.Uniform(-M_PI, M_PI);
+  const float xVtx = PosVertex[0] * std::cos(alpha) + PosVertex[1] * std::sin(alpha);
+  const float yVtx = -PosVertex[0] * std::sin(alpha) + PosVertex[1] * std::cos(alpha);
+  const float pt = 0.2f + random.Exp(1.f);
+  const int charge = random.Rndm() < 0.5 ? -1 : 1;
+  const std::array<float, 5> params{yVtx + random.Gaus(0., SigmaY), PosVertex[2] + random.Gaus(0., SigmaZ), 0.f, static_cast<float>(random.Uniform(-1., 1.)), charge / pt};
+  const std::array<float, 15> cov{SigmaY * SigmaY,
+                                  0.f, SigmaZ * SigmaZ,
+                                  0.f, 0.f, 1.e-5f,
+                                  0.f, 0.f, 0.f, 1.e-5f,
+                                  0.f, 0.f, 0.f, 0.f, 1.e-3f / (pt * pt)};
+  return o2::track::TrackParCov(xVtx, alpha, params, cov);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const int nCollisions = argc > 1 ? std::atoi(argv[1]) : 100;
+  o2::base::Propagator::Instance(true); // no field map needed: the tracks are propagated with the nominal field set below
+  o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false");
+  o2::vertexing::PVertexer vertexer;
+  vertexer.init();
+  vertexer.setBz(Bz);
+  const auto& pvertexerParams = o2::vertexing::PVertexerParams::Instance();
+  const o2::hf_pv_refit::VertexerSettings vertexerSettings{pvertexerParams.sysErrY2, pvertexerParams.sysErrZ2, pvertexerParams.tukey};
+
+  TRandom3 random(1);
+  LOGF(info, "%8s %12s %12s %12s %10s %14s %14s", "N contr.", "refit (us)", "init (us)", "remove (us)", "fallbacks", "max |dz|/sz", "max |dx|/sx");
+  for (const auto nContributors : NContributors) {
+    double timeRefit{0.}, timeInit{0.}, timeRemove{0.};
+    double maxPullZ{0.}, maxPullX{0.};
+    long nFallbacks{0};
+    for (int iCollision = 0; iCollision < nCollisions; ++iCollision) {
+      std::vector<o2::track::TrackParCov> tracks;
+      tracks.reserve(nContributors);
+      for (int iTrack = 0; iTrack < nContributors; ++iTrack) {
+        tracks.push_back(generateTrack(random));
+      }
+      o2::dataformats::VertexBase primVtx;
+      primVtx.setXYZ(PosVertex[0], PosVertex[1], PosVertex[2]);
+      primVtx.setCov(1.e-4f, 0.f, 1.e-4f, 0.f, 0.f, 1.e-4f);
+      if (!vertexer.prepareVertexRefit(tracks, primVtx)) {
+        continue;
+      }
+
+      // leave-one-out refits from scratch
+      std::vector<bool> contributorUsed(nContributors, true);
+      std::vector<o2::dataformats::PrimaryVertex> verticesRefit(nContributors);
+      auto start = std::chrono::steady_clock::now();
+      for (int iTrack = 0; iTrack < nContributors; ++iTrack) {
+        contributorUsed[iTrack] = false;
+        verticesRefit[iTrack] = vertexer.refitVertex(contributorUsed, primVtx);
+        contributorUsed[iTrack] = true;
+      }
+      timeRefit += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+      // leave-one-out refits by removal from the vertex fitted with all the contributors
+      start = std::chrono::steady_clock::now();
+      const auto vertexAll = vertexer.refitVertex(contributorUsed, primVtx);
+      o2::hf_pv_refit::PvRefitDowndate pvRefitDowndate;
+      const bool isDowndateValid = pvRefitDowndate.init(vertexAll, tracks, Bz, vertexerSettings, 25.f, 1.e-3f);
+      timeInit += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      if (!isDowndateValid) {
+        nFallbacks += nContributors;
+        continue;
+      }
+      std::vector<o2::dataformats::PrimaryVertex> verticesRemove(nContributors);
+      std::vector<bool> isRemoved(nContributors, false);
+      start = std::chrono::steady_clock::now();
+      for (int iTrack = 0; iTrack < nContributors; ++iTrack) {
+        isRemoved[iTrack] = pvRefitDowndate.removeContributor(iTrack, verticesRemove[iTrack]);
+      }
+      timeRemove += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+      for (int iTrack = 0; iTrack < nContributors; ++iTrack) {
+        if (!isRemoved[iTrack]) {
+          ++nFallbacks;
+          continue;
+        }
+        const auto& vertexRefit = verticesRefit[iTrack];
+        if (vertexRefit.getChi2() < 0.f) {
+          continue;
+        }
+        maxPullZ = std::max(maxPullZ, std::abs(verticesRemove[iTrack].getZ() - vertexRefit.getZ()) / std::sqrt(static_cast<double>(vertexRefit.getSigmaZ2())));
+        maxPullX = std::max(maxPullX, std::abs(verticesRemove[iTrack].getX() - vertexRefit.getX()) / std::sqrt(static_cast<double>(vertexRefit.getSigmaX2())));
+      }
+    }
+    // times per collision
+    LOGF(info, "%8d %12.1f %12.1f %12.2f %10ld %14.3g %14.3g", nContributors, timeRefit / nCollisions, timeInit / nCollisions, timeRemove / nCollisions, nFallbacks, maxPullZ, maxPullX);
+  }
+  return 0;
+}
@@ -0,0 +1,255 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file utilsPvRefitHf.h
+/// \brief Leave-one-out primary-vertex refit by downdate of the full vertex fit
+
+#ifndef PWGHF_UTILS_UTILSPVREFITHF_H_
+#define PWGHF_UTILS_UTILSPVREFITHF_H_
+
+#include <ReconstructionDataFormats/PrimaryVertex.h>
+#include <ReconstructionDataFormats/Track.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace o2::hf_pv_refit
+{
+// symmetric 3x3 matrix, stored as XX, XY, YY, XZ, YZ, ZZ (as the vertex covariance matrix)
+using SymMatrix3 = std::array<double, 6>;
+
+/// \brief Function to compute the determinant of a symmetric 3x3 matrix
+inline double determinant(SymMatrix3 const& m)
+{
+  return m[0] * (m[2] * m[5] - m[4] * m[4]) - m[1] * (m[1] * m[5] - m[4] * m[3]) + m[3] * (m[1] * m[4] - m[2] * m[3]);
+}
+
+/// \brief Function to invert a symmetric 3x3 matrix
+/// \param m is the matrix
+/// \param det is its determinant, which must be non-zero
+inline SymMatrix3 invert(SymMatrix3 const& m, double det)
+{
+  const double detInv = 1. / det;
+  return {(m[2] * m[5] - m[4] * m[4]) * detInv,
+          (m[3] * m[4] - m[1] * m[5]) * detInv,
+          (m[0] * m[5] - m[3] * m[3]) * detInv,
+          (m[1] * m[4] - m[2] * m[3]) * detInv,
+          (m[1] * m[3] - m[0] * m[4]) * detInv,
+          (m[0] * m[2] - m[1] * m[1]) * detInv};
+}
+
+/// \brief Function to compute the trace of the product of two symmetric 3x3 matrices
+inline double traceProduct(SymMatrix3 const& a, SymMatrix3 const& b)
+{
+  return a[0] * b[0] + a[2] * b[2] + a[5] * b[5] + 2. * (a[1] * b[1] + a[3] * b[3] + a[4] * b[4]);
+}
+
+/// Settings of the PVertexer fit entering the weights of the tracks (from PVertexerParams)
+struct VertexerSettings {
+  double sysErrY2{0.}; // systematic error added to the track Y error^2
+  double sysErrZ2{0.}; // systematic error added to the track Z error^2
+  double tukey{0.};    // Tukey constant of the robust track weights (no robust weights if not positive)
+};
+
+/// Refit of the primary vertex without one of its contributors, obtained by removing the contribution of the track
+///   from the weight matrix of the vertex fitted with all the contributors (Kalman downdate), instead of refitting the vertex
+///   with the remaining tracks. Each track is linearised around the full vertex as a straight line in its local frame, as in PVertexer.
+/// The contribution of each track is built as in the PVertexer fit: systematic errors added to the track covariance and Tukey weight
+///   w = (1 - chi2 / (tukey^2 sigma^2))^2. The scale sigma^2 of the final fit iteration and the overall error scaling are not stored
+///   in the vertex: they are recovered by requiring the weighted contributions to sum up to the weight matrix of the fitted vertex.
+/// The Tukey weights of the remaining tracks are not updated after the removal: the downdate is refused for tracks far from the vertex
+///   or when the remaining weight matrix is ill-conditioned
+class PvRefitDowndate
+{
+ public:
+  PvRefitDowndate() = default;
+  ~PvRefitDowndate() = default;
+
+  /// Prepares the downdates of the vertex, with a cost linear in the number of contributors
+  /// \param vertex is the vertex fitted with all the contributors
+  /// \param contributors are the contributor tracks, in the order used to remove them
+  /// \param bz is the magnetic field
+  /// \param settings are the settings of the PVertexer fit of the vertex
+  /// \param maxChi2Track is the maximum chi2 of a track to the vertex for its contribution to be removed
+  /// \param minDetRatio is the minimum ratio of the determinants of the weight matrices without and with the track
+  /// \return false if the vertex fit is not valid, in which case no downdate is possible
+  bool init(o2::dataformats::PrimaryVertex const& vertex, std::vector<o2::track::TrackParCov> const& contributors, float bz, VertexerSettings const& settings, float maxChi2Track, float minDetRatio)
+  {
+    mIsValid = false;
+    mMaxChi2Track = maxChi2Track;
+    mMinDetRatio = minDetRatio;
+    mTracks.assign(contributors.size(), {});
+    if (vertex.getChi2() < 0.f) {
+      return false;
+    }
+    const auto& cov = vertex.getCov();
+    const SymMatrix3 covVertex{cov[0], cov[1], cov[2], cov[3], cov[4], cov[5]};
+    const double detCov = determinant(covVertex);
+    if (!(detCov > 0.)) {
+      return false;
+    }
+    mWeightVertex = invert(covVertex, detCov);
+    mDetWeightVertex = 1. / detCov;
+    mPosVertex = {vertex.getX(), vertex.getY(), vertex.getZ()};
+    mChi2Vertex = vertex.getChi2();
+    mNContributors = vertex.getNContributors();
+    for (std::size_t iTrack = 0; iTrack < contributors.size(); ++iTrack) {
+      linearise(contributors[iTrack], bz, settings, mTracks[iTrack]);
+    }
+
+    // scale of the fit: the weight matrix of the vertex is the sum of the weighted contributions divided by sigma^2,
+    // with the Tukey weights themselves depending on sigma^2
+    constexpr int NIterationsScale = 5;
+    const double tukey2 = settings.tukey * settings.tukey;
+    double scale2{1.};
+    for (int iIteration = 0; iIteration < NIterationsScale; ++iIteration) {
+      SymMatrix3 weightSum{};
+      for (auto& track : mTracks) {
+        if (!track.isValid) {
+          continue;
+        }
+        track.tukeyWeight = 1.;
+        if (tukey2 > 0.) {
+          const double chi2Tukey = track.chi2 / (tukey2 * scale2);
+          track.tukeyWeight = chi2Tukey < 1. ? (1. - chi2Tukey) * (1. - chi2Tukey) : 0.;
+        }
+        for (std::size_t i = 0; i < weightSum.size(); ++i) {
+          weightSum[i] += track.tukeyWeight * track.weight[i];
+        }
+      }
+      const double detWeightSum = determinant(weightSum);
+      if (!(detWeightSum > 0.)) {
+        return false;
+      }
+      mScale = traceProduct(mWeightVertex, invert(weightSum, detWeightSum)) / 3.;
+      if (!(mScale > 0.)) {
+        return false;
+      }
+      scale2 = 1. / mScale;
+    }
+    mIsValid = true;
+    return true;
+  }
+
+  /// Computes the vertex without one contributor
+  /// \param iContributor is the index of the contributor in the vector passed to init()
+  /// \param vertexRefit is the vertex without the contributor
+  /// \return false if the downdate is not reliable, in which case a full refit is needed
+  bool removeContributor(std::size_t iContributor, o2::dataformats::PrimaryVertex& vertexRefit) const
+  {
+    if (!mIsValid || iContributor >= mTracks.size()) {
+      return false;
+    }
+    const auto& track = mTracks[iContributor];
+    if (!track.isValid || track.chi2 > mMaxChi2Track) {
+      return false;
+    }
+    // contribution of the track to the weight matrix of the vertex, and to the chi2 and its gradient in the units of the fit
+    const double weightChi2 = track.tukeyWeight;
+    const double weightMatrix = mScale * track.tukeyWeight;
+    SymMatrix3 weightRefit{};
+    for (std::size_t i = 0; i < weightRefit.size(); ++i) {
+      weightRefit[i] = mWeightVertex[i] - weightMatrix * track.weight[i];
+    }
+    const double detWeightRefit = determinant(weightRefit);
+    if (!(detWeightRefit > mMinDetRatio * mDetWeightVertex)) {
+      return false;
+    }
+    const auto covRefit = invert(weightRefit, detWeightRefit);
+    // Gauss-Newton step from the full vertex, where the gradient of the chi2 of the remaining tracks is minus the one of the removed track
+    const std::array<double, 3> g{weightChi2 * track.gradient[0], weightChi2 * track.gradient[1], weightChi2 * track.gradient[2]};
+    const std::array<double, 3> shift{mScale * (covRefit[0] * g[0] + covRefit[1] * g[1] + covRefit[3] * g[2]),
+                                      mScale * (covRefit[1] * g[0] + covRefit[2] * g[1] + covRefit[4] * g[2]),
+                                      mScale * (covRefit[3] * g[0] + covRefit[4] * g[1] + covRefit[5] * g[2])};
+    const double chi2Refit = mChi2Vertex - weightChi2 * track.chi2 - (g[0] * shift[0] + g[1] * shift[1] + g[2] * shift[2]);
+    vertexRefit.setXYZ(mPosVertex[0] + shift[0], mPosVertex[1] + shift[1], mPosVertex[2] + shift[2]);
+    vertexRefit.setCov(covRefit[0], covRefit[1], covRefit[2], covRefit[3], covRefit[4], covRefit[5]);
+    vertexRefit.setChi2(chi2Refit > 0. ? chi2Refit : 0.);
+    vertexRefit.setNContributors(mNContributors > 0 ? mNContributors - 1 : 0);
+    return true;
+  }
+
+ private:
+  // contribution of a track to the vertex fit, at the full vertex
+  struct TrackContribution {
+    SymMatrix3 weight{};              // J^T W J, with J the derivatives of the residuals w.r.t. the vertex position
+    std::array<double, 3> gradient{}; // J^T W r, with r the residuals
+    double chi2{0.};                  // r^T W r
+    double tukeyWeight{0.};           // Tukey weight of the track in the fit
+    bool isValid{false};              // whether the track could be propagated to the vertex
+  };
+
+  void linearise(o2::track::TrackParCov track, float bz, VertexerSettings const& settings, TrackContribution& contribution) const
+  {
+    o2::dataformats::VertexBase vertex;
+    vertex.setXYZ(mPosVertex[0], mPosVertex[1], mPosVertex[2]);
+    if (!track.propagateToDCA(vertex, bz)) {
+      return;
+    }
+    const double sig2Y = track.getSigmaY2() + settings.sysErrY2;
+    const double sigZY = track.getSigmaZY();
+    const double sig2Z = track.getSigmaZ2() + settings.sysErrZ2;
+    const double detCovTrack = sig2Y * sig2Z - sigZY * sigZY;
+    if (!(detCovTrack > 0.)) {
+      return;
+    }
+    // inverse of the covariance matrix of the track position
+    const double w00 = sig2Z / detCovTrack;
+    const double w01 = -sigZY / detCovTrack;
+    const double w11 = sig2Y / detCovTrack;
+
+    // straight-line extrapolation of the track to the vertex, in the track frame
+    const double cosAlp = std::cos(track.getAlpha());
+    const double sinAlp = std::sin(track.getAlpha());
+    const double snp = track.getSnp();
+    const double csp = std::sqrt((1. - snp) * (1. + snp));
+    const double tgP = snp / csp;
+    const double tgL = track.getTgl() / csp;
+    const double dx = mPosVertex[0] * cosAlp + mPosVertex[1] * sinAlp - track.getX();
+    const std::array<double, 2> residuals{track.getY() + tgP * dx - (-mPosVertex[0] * sinAlp + mPosVertex[1] * cosAlp),
+                                          track.getZ() + tgL * dx - mPosVertex[2]};
+    // derivatives of the residuals w.r.t. the vertex coordinates
+    const std::array<std::array<double, 3>, 2> jacobian{{{tgP * cosAlp + sinAlp, tgP * sinAlp - cosAlp, 0.},
+                                                         {tgL * cosAlp, tgL * sinAlp, -1.}}};
+    // W J
+    std::array<std::array<double, 3>, 2> weightedJacobian{};
+    for (int k = 0; k < 3; ++k) {
+      weightedJacobian[0][k] = w00 * jacobian[0][k] + w01 * jacobian[1][k];
+      weightedJacobian[1][k] = w01 * jacobian[0][k] + w11 * jacobian[1][k];
+    }
+    constexpr std::array<std::array<int, 2>, 6> IndicesSym{{{0, 0}, {0, 1}, {1, 1}, {0, 2}, {1, 2}, {2, 2}}};
+    for (std::size_t i = 0; i < IndicesSym.size(); ++i) {
+      const auto [row, col] = IndicesSym[i];
+      contribution.weight[i] = jacobian[0][row] * weightedJacobian[0][col] + jacobian[1][row] * weightedJacobian[1][col];
+    }
+    for (int k = 0; k < 3; ++k) {
+      contribution.gradient[k] = weightedJacobian[0][k] * residuals[0] + weightedJacobian[1][k] * residuals[1];
+    }
+    contribution.chi2 = residuals[0] * (w00 * residuals[0] + w01 * residuals[1]) + residuals[1] * (w01 * residuals[0] + w11 * residuals[1]);
+    contribution.isValid = true;
+  }
+
+  std::vector<TrackContribution> mTracks{}; // contributions of the tracks to the vertex fit
+  SymMatrix3 mWeightVertex{};               // inverse of the covariance matrix of the full vertex
+  std::array<double, 3> mPosVertex{};       // position of the full vertex
+  double mDetWeightVertex{0.};              // determinant of mWeightVertex
+  double mChi2Vertex{0.};                   // chi2 of the full vertex
+  double mScale{1.};                        // scale of the weighted track contributions to the weight matrix of the vertex
+  int mNContributors{0};                    // number of contributors of the full vertex
+  float mMaxChi2Track{0.f};                 // maximum chi2 of a removed track to the vertex
+  float mMinDetRatio{0.f};                  // minimum ratio of the determinants of the weight matrices without and with the track
+  bool mIsValid{false};                     // whether the full vertex can be downdated
+};
+} // namespace o2::hf_pv_refit
+
+#endif // PWGHF_UTILS_UTILSPVREFITHF_H_
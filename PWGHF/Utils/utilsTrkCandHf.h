@@ -19,11 +19,22 @@
 #include "PWGHF/Utils/utilsAnalysis.h"
 
 #include <Framework/HistogramSpec.h>
+#include <ReconstructionDataFormats/Track.h>
 
 #include <Rtypes.h>
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 namespace o2::hf_trkcandsel
 {
@@ -48,6 +59,178 @@ void setLabelHistoCands(THisto& hCandidates)
   hCandidates->GetXaxis()->SetBinLabel(SVFitting::Fail + 1, "Run-time error in secondary vertexing");
 }
 
+/// \brief Input and output of the secondary-vertex fit of a candidate
+template <int NProngs>
+struct SVFitResult {
+  std::array<o2::track::TrackParCov, NProngs> tracks{}; // prong tracks, replaced by the tracks at the PCA after the fit
+  std::array<double, 3> secondaryVertex{};              // position of the PCA
+  std::array<float, 6> covMatrixPCA{};                  // flattened covariance matrix of the PCA
+  float chi2PCA{0.f};                                   // chi2 at the PCA
+  double bz{0.};                                        // magnetic field of the collision
+  int nVertices{0};                                     // number of vertices found, -1 in case of run-time error
+  bool isSelected{false};                               // whether the candidate has to be fitted
+  std::string error{};                                  // message of the run-time error
+};
+
+/// \brief Pool of worker threads kept alive across the calls, running the blocks of a task in parallel with the calling thread
+class WorkerPool
+{
+ public:
+  WorkerPool() = default;
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+  ~WorkerPool() { stop(); }
+
+  /// \brief Function to start the worker threads
+  /// \param nWorkers is the number of worker threads, in addition to the calling thread (none if <= 0)
+  void start(int nWorkers)
+  {
+    stop();
+    mStop = false;
+    for (int iWorker = 0; iWorker < nWorkers; ++iWorker) {
+      mWorkers.emplace_back([this]() { work(); });
+    }
+  }
+
+  /// \brief Function to stop and join the worker threads
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mConditionTask.notify_all();
+    for (auto& worker : mWorkers) {
+      worker.join();
+    }
+    mWorkers.clear();
+  }
+
+  /// \brief Number of threads running the tasks, including the calling thread
+  std::size_t nThreads() const { return mWorkers.size() + 1; }
+
+  /// \brief Function to run a task on all its blocks and wait for their completion
+  /// \param nBlocks is the number of blocks
+  /// \param task is called with the index of each block, it must not throw
+  void run(std::size_t nBlocks, std::function<void(std::size_t)> const& task)
+  {
+    if (mWorkers.empty() || nBlocks < 2) {
+      for (std::size_t iBlock = 0; iBlock < nBlocks; ++iBlock) {
+        task(iBlock);
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTask = &task;
+      mNBlocks = nBlocks;
+      mNextBlock = 0;
+      mNBlocksDone = 0;
+      ++mGeneration;
+    }
+    mConditionTask.notify_all();
+    runBlocks();
+    std::unique_lock<std::mutex> lock(mMutex);
+    mConditionDone.wait(lock, [this]() { return mNBlocksDone == mNBlocks; });
+    mTask = nullptr;
+  }
+
+ private:
+  // runs the blocks of the current task not taken yet by the other threads
+  void runBlocks()
+  {
+    while (true) {
+      std::function<void(std::size_t)> const* task{nullptr};
+      std::size_t iBlock{0};
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mNextBlock >= mNBlocks) {
+          return;
+        }
+        task = mTask;
+        iBlock = mNextBlock++;
+      }
+      (*task)(iBlock);
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (++mNBlocksDone == mNBlocks) {
+        mConditionDone.notify_one();
+      }
+    }
+  }
+
+  // loop of the worker threads, waiting for the tasks
+  void work()
+  {
+    uint64_t generation{0};
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionTask.wait(lock, [this, &generation]() { return mStop || mGeneration != generation; });
+        if (mStop) {
+          return;
+        }
+        generation = mGeneration;
+      }
+      runBlocks();
+    }
+  }
+
+  std::vector<std::thread> mWorkers{};                     // worker threads
+  std::mutex mMutex{};                                     // protection of the state of the current task
+  std::condition_variable mConditionTask{};                // notification of a new task or of the stop to the workers
+  std::condition_variable mConditionDone{};                // notification of the completion of the task to the calling thread
+  std::function<void(std::size_t)> const* mTask{nullptr}; // current task
+  std::size_t mNBlocks{0};                                 // number of blocks of the current task
+  std::size_t mNextBlock{0};                               // next block of the current task to be run
+  std::size_t mNBlocksDone{0};                             // number of blocks of the current task completed
+  uint64_t mGeneration{0};                                 // counter of the tasks
+  bool mStop{false};                                       // whether the workers have to stop
+};
+
+/// \brief Function to fit the secondary vertices of a set of candidates, optionally on several threads
+/// \param fitter is the configured DCAFitterN, copied for each block of candidates
+/// \param fitResults are the candidates to fit, where the outputs of the fits are stored
+/// \param workers is the pool of threads running the fits (sequential fits if it has no workers)
+/// \note Each thread fits a contiguous block of candidates with its own fitter, so the outputs do not depend on the number of threads
+template <typename TFitter, int NProngs>
+void fitSecondaryVertices(TFitter const& fitter, std::vector<SVFitResult<NProngs>>& fitResults, WorkerPool& workers)
+{
+  const std::size_t nCands = fitResults.size();
+  const std::size_t nCandsPerBlock = (nCands + workers.nThreads() - 1) / workers.nThreads();
+  auto fitBlock = [&fitter, &fitResults, nCands, nCandsPerBlock](std::size_t iBlock) {
+    auto fitterThread = fitter;
+    const std::size_t last = std::min((iBlock + 1) * nCandsPerBlock, nCands);
+    for (std::size_t iCand = iBlock * nCandsPerBlock; iCand < last; ++iCand) {
+      auto& fitResult = fitResults[iCand];
+      if (!fitResult.isSelected) {
+        continue;
+      }
+      // an exception escaping the thread would terminate the program, the candidate is flagged instead
+      try {
+        fitterThread.setBz(fitResult.bz);
+        fitResult.nVertices = std::apply([&fitterThread](auto const&... tracks) { return fitterThread.process(tracks...); }, fitResult.tracks);
+        if (fitResult.nVertices == 0) {
+          continue;
+        }
+        const auto& secondaryVertex = fitterThread.getPCACandidate();
+        fitResult.secondaryVertex = {secondaryVertex[0], secondaryVertex[1], secondaryVertex[2]};
+        fitResult.chi2PCA = fitterThread.getChi2AtPCACandidate();
+        fitResult.covMatrixPCA = fitterThread.calcPCACovMatrixFlat();
+        // the fitter keeps pointers to the input tracks, overwrite them only once all the outputs are retrieved
+        std::array<o2::track::TrackParCov, NProngs> tracksAtPCA{};
+        for (int iProng = 0; iProng < NProngs; ++iProng) {
+          tracksAtPCA[iProng] = fitterThread.getTrack(iProng);
+        }
+        fitResult.tracks = tracksAtPCA;
+      } catch (const std::exception& error) {
+        fitResult.nVertices = -1;
+        fitResult.error = error.what();
+      }
+    }
+  };
+  workers.run(nCands > 0 ? (nCands + nCandsPerBlock - 1) / nCandsPerBlock : 0, fitBlock);
+}
+
 /// \brief Function to evaluate number of ones in a binary representation of the argument
 /// \param num is the input argument
 inline int countOnesInBinary(const uint8_t num)
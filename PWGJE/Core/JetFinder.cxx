@@ -21,11 +21,23 @@
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/Selector.hh>
 
+#include <memory>
 #include <vector>
 
 /// Sets the jet finding parameters
 void JetFinder::setParams()
 {
+  selGhosts = fastjet::SelectorRapRange(etaMin, etaMax) && fastjet::SelectorPhiRange(phiMin, phiMax); // note that this is rapidity not eta but since ghosts are effectively massless this is ok
+  // ghostAreaSpec=fastjet::GhostedAreaSpec(selGhosts,ghostRepeatN,ghostArea,gridScatter,ktScatter,ghostktMean);
+  ghostAreaSpec = fastjet::GhostedAreaSpec(selGhosts, ghostRepeatN, ghostArea, gridScatter, ktScatter, ghostktMean);
+  areaDef = fastjet::AreaDefinition(areaType, ghostAreaSpec);
+  setJetRadius(jetR);
+}
+
+/// Sets the jet finding parameters which depend on the jet radius
+void JetFinder::setJetRadius(float R)
+{
+  jetR = R;
   if (jetEtaDefault) {
 
     jetEtaMin = etaMin + jetR; // in aliphysics this was (-etaMax + 0.95*jetR)
@@ -38,15 +50,11 @@ void JetFinder::setParams()
   }
   float jetRForClustering = isReclustering ? 5.0 * jetR : jetR;
 
-  selGhosts = fastjet::SelectorRapRange(etaMin, etaMax) && fastjet::SelectorPhiRange(phiMin, phiMax); // note that this is rapidity not eta but since ghosts are effectively massless this is ok
-  // ghostAreaSpec=fastjet::GhostedAreaSpec(selGhosts,ghostRepeatN,ghostArea,gridScatter,ktScatter,ghostktMean);
-  ghostAreaSpec = fastjet::GhostedAreaSpec(selGhosts, ghostRepeatN, ghostArea, gridScatter, ktScatter, ghostktMean);
   jetDef = fastjet::JetDefinition(fastjet::antikt_algorithm, jetRForClustering, recombScheme, strategy);
   if (fastjetExtraParam > -98.0) {
     jetDef.set_extra_param(fastjetExtraParam);
   }
   jetDef.set_jet_algorithm(algorithm);
-  areaDef = fastjet::AreaDefinition(areaType, ghostAreaSpec);
   selJets = fastjet::SelectorPtRange(jetPtMin, jetPtMax) && fastjet::SelectorEtaRange(jetEtaMin, jetEtaMax) && fastjet::SelectorPhiRange(jetPhiMin, jetPhiMax);
 }
 
@@ -65,3 +73,15 @@ fastjet::ClusterSequenceArea JetFinder::findJets(std::vector<fastjet::PseudoJet>
   jets = fastjet::sorted_by_pt(jets);
   return clusterSeq;
 }
+
+/// Performs jet finding with the parameters of the last calls of setParams and setJetRadius
+/// \param inputParticles vector of input particles/tracks
+/// \param jets vector of jets to be filled
+/// \param clusterSeq ClusterSequenceArea object needed to access constituents, replaced by the one of this call
+void JetFinder::findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets, std::unique_ptr<fastjet::ClusterSequenceArea>& clusterSeq)
+{
+  jets.clear();
+  clusterSeq.reset();
+  clusterSeq = std::make_unique<fastjet::ClusterSequenceArea>(inputParticles, jetDef, areaDef);
+  jets = fastjet::sorted_by_pt(selJets(clusterSeq->inclusive_jets()));
+}
@@ -27,6 +27,7 @@
 
 #include <Rtypes.h>
 
+#include <memory>
 #include <vector>
 
 #include <math.h>
@@ -85,6 +86,11 @@ class JetFinder
   /// Sets the jet finding parameters
   void setParams();
 
+  /// Sets the jet finding parameters which depend on the jet radius (jet definition and jet selection)
+  /// \note the ghost and area definitions of the last call of setParams are kept, so that they can be shared by several radii
+  /// \param R jet radius
+  void setJetRadius(float R);
+
   /// Performs jet finding
   /// \note the input particle and jet lists are passed by reference
   /// \param inputParticles vector of input particles/tracks
@@ -92,6 +98,13 @@ class JetFinder
   /// \return ClusterSequenceArea object needed to access constituents
   fastjet::ClusterSequenceArea findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets); // ideally find a way of passing the cluster sequence as a reeference
 
+  /// Performs jet finding with the parameters of the last calls of setParams and setJetRadius
+  /// \note the cluster sequence is created in place instead of being returned by value, and the input particles can be shared by several radii
+  /// \param inputParticles vector of input particles/tracks
+  /// \param jets vector of jets to be filled
+  /// \param clusterSeq ClusterSequenceArea object needed to access constituents, replaced by the one of this call
+  void findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets, std::unique_ptr<fastjet::ClusterSequenceArea>& clusterSeq);
+
  private:
   ClassDefNV(JetFinder, 1);
 };
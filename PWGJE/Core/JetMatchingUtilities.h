@@ -28,16 +28,15 @@
 
 #include <Framework/Logger.h>
 
-#include <TKDTree.h>
-
-#include <RtypesCore.h>
-
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <numeric>
 #include <ostream>
 #include <stdexcept>
 #include <tuple>
+#include <unordered_set>
 #include <vector>
 
 #include <math.h>
@@ -56,8 +55,8 @@ namespace jetmatchingutilities
  */
 template <typename T>
 std::tuple<std::vector<std::size_t>, std::vector<T>, std::vector<T>> DuplicateJetsAroundPhiBoundary(
-  std::vector<T>& jetsPhi,
-  std::vector<T>& jetsEta,
+  const std::vector<T>& jetsPhi,
+  const std::vector<T>& jetsEta,
   double maxMatchingDistance,
   // TODO: Remove additional margin after additional testing.
   double additionalMargin = 0.05)
@@ -96,6 +95,128 @@ std::tuple<std::vector<std::size_t>, std::vector<T>, std::vector<T>> DuplicateJe
   return {jetsMapToJetIndex, jetsPhiComparison, jetsEtaComparison};
 }
 
+/**
+ * Uniform (eta, phi) grid of jets, to find the closest jet to a point within the matching distance.
+ *
+ * The cells are at least as large as the matching distance in both directions, so only the 3x3 cells
+ * around a point have to be searched. The jets are stored cell by cell in one array.
+ * The distance is computed as in TKDTree::FindNearestNeighbors.
+ */
+template <typename T>
+class JetMatchingGrid
+{
+ public:
+  /**
+   * @param jetsEta Jets eta, which must outlive the grid.
+   * @param jetsPhi Jets phi, which must outlive the grid.
+   * @param maxMatchingDistance Maximum matching distance.
+   */
+  JetMatchingGrid(const std::vector<T>& jetsEta, const std::vector<T>& jetsPhi, double maxMatchingDistance)
+    : mJetsEta(jetsEta), mJetsPhi(jetsPhi), mMaxMatchingDistance(maxMatchingDistance)
+  {
+    bool isEmpty = true;
+    for (std::size_t i = 0; i < mJetsEta.size(); i++) {
+      if (!std::isfinite(mJetsEta[i]) || !std::isfinite(mJetsPhi[i])) {
+        continue;
+      }
+      mEtaMin = isEmpty ? mJetsEta[i] : std::min<double>(mEtaMin, mJetsEta[i]);
+      mPhiMin = isEmpty ? mJetsPhi[i] : std::min<double>(mPhiMin, mJetsPhi[i]);
+      mEtaMax = isEmpty ? mJetsEta[i] : std::max<double>(mEtaMax, mJetsEta[i]);
+      mPhiMax = isEmpty ? mJetsPhi[i] : std::max<double>(mPhiMax, mJetsPhi[i]);
+      isEmpty = false;
+    }
+    if (isEmpty || !(mMaxMatchingDistance > 0.)) {
+      return; // no jet can be matched
+    }
+    mCellSizeEta = std::max(mMaxMatchingDistance, (mEtaMax - mEtaMin) / (MaxCellsPerAxis - 1));
+    mCellSizePhi = std::max(mMaxMatchingDistance, (mPhiMax - mPhiMin) / (MaxCellsPerAxis - 1));
+    mNCellsEta = static_cast<int>((mEtaMax - mEtaMin) / mCellSizeEta) + 1;
+    mNCellsPhi = static_cast<int>((mPhiMax - mPhiMin) / mCellSizePhi) + 1;
+
+    // counting sort of the jets by cell
+    std::vector<int> jetCells(mJetsEta.size(), -1);
+    mCellOffsets.assign(mNCellsEta * mNCellsPhi + 1, 0);
+    for (std::size_t i = 0; i < mJetsEta.size(); i++) {
+      if (!std::isfinite(mJetsEta[i]) || !std::isfinite(mJetsPhi[i])) {
+        continue;
+      }
+      jetCells[i] = cell(static_cast<int>((mJetsEta[i] - mEtaMin) / mCellSizeEta), static_cast<int>((mJetsPhi[i] - mPhiMin) / mCellSizePhi));
+      mCellOffsets[jetCells[i] + 1]++;
+    }
+    std::partial_sum(mCellOffsets.begin(), mCellOffsets.end(), mCellOffsets.begin());
+    mCellJets.resize(mCellOffsets.back());
+    std::vector<int> cellFill(mCellOffsets.begin(), mCellOffsets.end() - 1);
+    for (std::size_t i = 0; i < mJetsEta.size(); i++) {
+      if (jetCells[i] >= 0) {
+        mCellJets[cellFill[jetCells[i]]++] = i;
+      }
+    }
+  }
+
+  /**
+   * Finds the closest jet to a point.
+   *
+   * @param eta Eta of the point.
+   * @param phi Phi of the point.
+   * @param distance Distance to the closest jet, if found within the matching distance.
+   *
+   * @returns Index of the closest jet, or -1 if there is no jet within the matching distance.
+   */
+  int findClosest(double eta, double phi, double& distance) const
+  {
+    int index = -1;
+    distance = -1.;
+    if (mCellJets.empty() || !std::isfinite(eta) || !std::isfinite(phi)) {
+      return index;
+    }
+    const double cellEta = std::floor((eta - mEtaMin) / mCellSizeEta);
+    const double cellPhi = std::floor((phi - mPhiMin) / mCellSizePhi);
+    const int cellEtaLow = static_cast<int>(std::max(cellEta - 1., 0.));
+    const int cellEtaHigh = static_cast<int>(std::min(cellEta + 1., mNCellsEta - 1.));
+    const int cellPhiLow = static_cast<int>(std::max(cellPhi - 1., 0.));
+    const int cellPhiHigh = static_cast<int>(std::min(cellPhi + 1., mNCellsPhi - 1.));
+    double closestDistance = mMaxMatchingDistance;
+    for (int iEta = cellEtaLow; iEta <= cellEtaHigh; iEta++) {
+      for (int iPhi = cellPhiLow; iPhi <= cellPhiHigh; iPhi++) {
+        const int iCell = cell(iEta, iPhi);
+        for (int iJet = mCellOffsets[iCell]; iJet < mCellOffsets[iCell + 1]; iJet++) {
+          const int jet = mCellJets[iJet];
+          const double dEta = eta - mJetsEta[jet];
+          const double dPhi = phi - mJetsPhi[jet];
+          const double jetDistance = std::sqrt(dEta * dEta + dPhi * dPhi);
+          if (jetDistance < closestDistance) {
+            closestDistance = jetDistance;
+            index = jet;
+          }
+        }
+      }
+    }
+    if (index >= 0) {
+      distance = closestDistance;
+    }
+    return index;
+  }
+
+ private:
+  static constexpr int MaxCellsPerAxis = 256; // limits the memory of the grid for small matching distances
+
+  int cell(int iEta, int iPhi) const { return iEta * mNCellsPhi + iPhi; }
+
+  const std::vector<T>& mJetsEta;
+  const std::vector<T>& mJetsPhi;
+  double mMaxMatchingDistance = 0.;
+  double mEtaMin = 0.;
+  double mEtaMax = 0.;
+  double mPhiMin = 0.;
+  double mPhiMax = 0.;
+  double mCellSizeEta = 1.;
+  double mCellSizePhi = 1.;
+  int mNCellsEta = 0;
+  int mNCellsPhi = 0;
+  std::vector<int> mCellOffsets; // index in mCellJets of the first jet of each cell, plus the total number of jets
+  std::vector<int> mCellJets;    // jet indices, cell by cell
+};
+
 /**
  * Implementation of geometrical jet matching.
  *
@@ -103,8 +224,6 @@ std::tuple<std::vector<std::size_t>, std::vector<T>, std::vector<T>> DuplicateJe
  * Unless special conditions are required, it's better to use `MatchJetsGeometrically`, which has an
  * easier to use interface.
  *
- * NOTE: The vectors for matching could all be const, except that SetData() doesn't take a const.
- *
  * @param jetsBasePhi Base jet collection phi.
  * @param jetsBaseEta Base jet collection eta.
  * @param jetsBasePhiForMatching Base jet collection phi to use for matching.
@@ -123,13 +242,13 @@ template <typename T>
 std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
   const std::vector<T>& jetsBasePhi,
   const std::vector<T>& jetsBaseEta,
-  std::vector<T> jetsBasePhiForMatching,
-  std::vector<T> jetsBaseEtaForMatching,
+  const std::vector<T>& jetsBasePhiForMatching,
+  const std::vector<T>& jetsBaseEtaForMatching,
   const std::vector<std::size_t>& jetMapBaseToJetIndex,
   const std::vector<T>& jetsTagPhi,
   const std::vector<T>& jetsTagEta,
-  std::vector<T> jetsTagPhiForMatching,
-  std::vector<T> jetsTagEtaForMatching,
+  const std::vector<T>& jetsTagPhiForMatching,
+  const std::vector<T>& jetsTagEtaForMatching,
   const std::vector<std::size_t>& jetMapTagToJetIndex,
   const double maxMatchingDistance)
 {
@@ -154,19 +273,12 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
     throw std::invalid_argument("Tag collection eta for matching is smaller than the input tag collection.");
   }
 
-  // Build the KD-trees using vectors
-  // We build two trees:
-  // treeBase, which contains the base collection.
-  // treeTag, which contains the tag collection.
-  // The trees are built to match in two dimensions (eta, phi)
-  TKDTree<int, T> treeBase(jetsBaseEtaForMatching.size(), 2, 1), treeTag(jetsTagEtaForMatching.size(), 2, 1);
-  // By utilizing SetData, we can avoid having to copy the data again.
-  treeBase.SetData(0, jetsBaseEtaForMatching.data());
-  treeBase.SetData(1, jetsBasePhiForMatching.data());
-  treeBase.Build();
-  treeTag.SetData(0, jetsTagEtaForMatching.data());
-  treeTag.SetData(1, jetsTagPhiForMatching.data());
-  treeTag.Build();
+  // Build the (eta, phi) grids
+  // We build two grids:
+  // gridBase, which contains the base collection.
+  // gridTag, which contains the tag collection.
+  const JetMatchingGrid<T> gridBase(jetsBaseEtaForMatching, jetsBasePhiForMatching, maxMatchingDistance);
+  const JetMatchingGrid<T> gridTag(jetsTagEtaForMatching, jetsTagPhiForMatching, maxMatchingDistance);
 
   // Storage for the jet matching indices.
   // matchIndexTag maps from the base index to the tag index.
@@ -175,30 +287,26 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
 
   // Find the tag jet closest to each base jet.
   for (std::size_t iBase = 0; iBase < nJetsBase; iBase++) {
-    Double_t point[2] = {jetsBaseEta[iBase], jetsBasePhi[iBase]};
-    Int_t index(-1);
-    Double_t distance(-1);
-    treeTag.FindNearestNeighbors(point, 1, &index, &distance);
+    double distance(-1);
+    int index = gridTag.findClosest(jetsBaseEta[iBase], jetsBasePhi[iBase], distance);
     // test whether indices are matching:
-    if (index >= 0 && distance < maxMatchingDistance) {
+    if (index >= 0) {
       LOG(debug) << "Found closest tag jet for " << iBase << " with match index " << index << " and distance " << distance << "\n";
       matchIndexTag[iBase] = index;
     } else {
-      LOG(debug) << "Closest tag jet not found for " << iBase << ", distance to closest " << distance << "\n";
+      LOG(debug) << "Closest tag jet not found for " << iBase << " within the matching distance\n";
     }
   }
 
   // Find the base jet closest to each tag jet
   for (std::size_t iTag = 0; iTag < nJetsTag; iTag++) {
-    Double_t point[2] = {jetsTagEta[iTag], jetsTagPhi[iTag]};
-    Int_t index(-1);
-    Double_t distance(-1);
-    treeBase.FindNearestNeighbors(point, 1, &index, &distance);
-    if (index >= 0 && distance < maxMatchingDistance) {
+    double distance(-1);
+    int index = gridBase.findClosest(jetsTagEta[iTag], jetsTagPhi[iTag], distance);
+    if (index >= 0) {
       LOG(debug) << "Found closest base jet for " << iTag << " with match index " << index << " and distance " << distance << std::endl;
       matchIndexBase[iTag] = index;
     } else {
-      LOG(debug) << "Closest tag jet not found for " << iTag << ", distance to closest " << distance << "\n";
+      LOG(debug) << "Closest base jet not found for " << iTag << " within the matching distance\n";
     }
   }
 
@@ -258,10 +366,10 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
  */
 template <typename T>
 std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometrically(
-  std::vector<T> jetsBasePhi,
-  std::vector<T> jetsBaseEta,
-  std::vector<T> jetsTagPhi,
-  std::vector<T> jetsTagEta,
+  const std::vector<T>& jetsBasePhi,
+  const std::vector<T>& jetsBaseEta,
+  const std::vector<T>& jetsTagPhi,
+  const std::vector<T>& jetsTagEta,
   double maxMatchingDistance)
 {
   // Validation
@@ -279,9 +387,8 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometrically(
     throw std::invalid_argument("Tag collection eta and phi sizes don't match. Check the inputs.");
   }
 
-  // To perform matching with periodic boundary conditions (ie. phi) with a KDTree, we need
+  // To perform matching with periodic boundary conditions (ie. phi) with a grid, we need
   // to duplicate data up to maxMatchingDistance in phi because phi is periodic.
-  // NOTE: vectors are modified in place to avoid copies.
   auto&& [jetMapBaseToJetIndex, jetsBasePhiComparison, jetsBaseEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsBasePhi, jetsBaseEta, maxMatchingDistance);
   auto&& [jetMapTagToJetIndex, jetsTagPhiComparison, jetsTagEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsTagPhi, jetsTagEta, maxMatchingDistance);
 
@@ -294,21 +401,52 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometrically(
   return std::make_tuple(baseToTagMap, tagToBaseMap);
 }
 
+/**
+ * Jets of one collision grouped by jet radius.
+ *
+ * Built once per collision and shared by the geometric, HF and pt matching, which only compare jets with the same radius.
+ */
 template <typename T, typename U>
-void MatchGeo(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::vector<std::vector<int>>& baseToTagMatchingGeo, std::vector<std::vector<int>>& tagToBaseMatchingGeo, std::vector<double> const& jetRadiiForMatchingDistance, std::vector<double> const& maxMatchingDistancePerJetR)
+struct JetsPerRadius {
+  std::vector<double> radii;                              // rounded jet radius of each group, in order of appearance in the base and then the tag jets
+  std::vector<std::vector<typename T::iterator>> jetsBase; // base jets of each group
+  std::vector<std::vector<typename U::iterator>> jetsTag;  // tag jets of each group
+};
+
+template <typename T, typename U>
+JetsPerRadius<T, U> groupJetsByRadius(T const& jetsBasePerCollision, U const& jetsTagPerCollision)
 {
-  std::vector<double> jetsR;
-  for (const auto& jetBase : jetsBasePerCollision) {
-    if (std::find(jetsR.begin(), jetsR.end(), std::round(jetBase.r())) == jetsR.end()) {
-      jetsR.push_back(std::round(jetBase.r()));
+  JetsPerRadius<T, U> jetsPerRadius;
+  auto getGroup = [&jetsPerRadius](double jetR) -> std::size_t {
+    auto it = std::find(jetsPerRadius.radii.begin(), jetsPerRadius.radii.end(), jetR);
+    if (it != jetsPerRadius.radii.end()) {
+      return it - jetsPerRadius.radii.begin();
     }
+    jetsPerRadius.radii.push_back(jetR);
+    jetsPerRadius.jetsBase.emplace_back();
+    jetsPerRadius.jetsTag.emplace_back();
+    return jetsPerRadius.radii.size() - 1;
+  };
+  for (const auto& jetBase : jetsBasePerCollision) {
+    jetsPerRadius.jetsBase[getGroup(std::round(jetBase.r()))].push_back(jetBase);
   }
   for (const auto& jetTag : jetsTagPerCollision) {
-    if (std::find(jetsR.begin(), jetsR.end(), std::round(jetTag.r())) == jetsR.end()) {
-      jetsR.push_back(std::round(jetTag.r()));
-    }
+    jetsPerRadius.jetsTag[getGroup(std::round(jetTag.r()))].push_back(jetTag);
   }
-  for (auto jetR : jetsR) {
+  return jetsPerRadius;
+}
+
+template <typename T, typename U>
+void MatchGeo(JetsPerRadius<T, U> const& jetsPerRadius, std::vector<std::vector<int>>& baseToTagMatchingGeo, std::vector<std::vector<int>>& tagToBaseMatchingGeo, std::vector<double> const& jetRadiiForMatchingDistance, std::vector<double> const& maxMatchingDistancePerJetR)
+{
+  std::vector<double> jetsBasePhi;
+  std::vector<double> jetsBaseEta;
+  std::vector<double> jetsTagPhi;
+  std::vector<double> jetsTagEta;
+  std::vector<int> baseToTagMatchingGeoIndex;
+  std::vector<int> tagToBaseMatchingGeoIndex;
+  for (std::size_t iR = 0; iR < jetsPerRadius.radii.size(); iR++) {
+    const double jetR = jetsPerRadius.radii[iR];
     float effectiveMatchingDistance = -1.0f;
     for (std::size_t i = 0; i < jetRadiiForMatchingDistance.size(); i++) {
       if (std::round(jetRadiiForMatchingDistance[i] * 100.0) == std::round(jetR)) {
@@ -319,99 +457,74 @@ void MatchGeo(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::
     if (effectiveMatchingDistance < 0.0f) {
       LOGP(fatal, "No matching distance configured for jet R={:.2f}. Add it to jetRadiiForMatchingDistance and maxMatchingDistancePerJetR.", jetR / 100.0);
     }
-    std::vector<double> jetsBasePhi;
-    std::vector<double> jetsBaseEta;
-    std::vector<int> jetsBaseGlobalIndex;
-    std::vector<int> baseToTagMatchingGeoIndex;
-    std::vector<int> tagToBaseMatchingGeoIndex;
-
-    for (const auto& jetBase : jetsBasePerCollision) {
-      if (std::round(jetBase.r()) != std::round(jetR)) {
-        continue;
-      }
+    const auto& jetsBase = jetsPerRadius.jetsBase[iR];
+    const auto& jetsTag = jetsPerRadius.jetsTag[iR];
+    jetsBasePhi.clear();
+    jetsBaseEta.clear();
+    for (const auto& jetBase : jetsBase) {
       jetsBasePhi.emplace_back(RecoDecay::constrainAngle(jetBase.phi(), 0.0));
       jetsBaseEta.emplace_back(jetBase.eta());
-      jetsBaseGlobalIndex.emplace_back(jetBase.globalIndex());
     }
-    std::vector<double> jetsTagPhi;
-    std::vector<double> jetsTagEta;
-    std::vector<int> jetsTagGlobalIndex;
-    for (const auto& jetTag : jetsTagPerCollision) {
-      if (std::round(jetTag.r()) != std::round(jetR)) {
-        continue;
-      }
+    jetsTagPhi.clear();
+    jetsTagEta.clear();
+    for (const auto& jetTag : jetsTag) {
       jetsTagPhi.emplace_back(RecoDecay::constrainAngle(jetTag.phi(), 0.0));
       jetsTagEta.emplace_back(jetTag.eta());
-      jetsTagGlobalIndex.emplace_back(jetTag.globalIndex());
     }
     std::tie(baseToTagMatchingGeoIndex, tagToBaseMatchingGeoIndex) = MatchJetsGeometrically(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, effectiveMatchingDistance);
-    int jetBaseIndex = 0;
-    int jetTagIndex = 0;
-    for (const auto& jetBase : jetsBasePerCollision) {
-      if (std::round(jetBase.r()) != std::round(jetR)) {
-        continue;
+    for (std::size_t jetBaseIndex = 0; jetBaseIndex < jetsBase.size(); jetBaseIndex++) {
+      int jetTagIndex = baseToTagMatchingGeoIndex[jetBaseIndex];
+      if (jetTagIndex > -1 && jetTagIndex < std::ssize(jetsTag)) {
+        baseToTagMatchingGeo[jetsBase[jetBaseIndex].globalIndex()].push_back(jetsTag[jetTagIndex].globalIndex());
       }
-      jetTagIndex = baseToTagMatchingGeoIndex[jetBaseIndex];
-      if (jetTagIndex > -1 && jetTagIndex < std::ssize(jetsTagPhi)) {
-        int jetTagGlobalIndex = jetsTagGlobalIndex[jetTagIndex];
-        baseToTagMatchingGeo[jetBase.globalIndex()].push_back(jetTagGlobalIndex);
-      }
-      jetBaseIndex++;
     }
-    jetTagIndex = 0;
-    for (const auto& jetTag : jetsTagPerCollision) {
-      if (std::round(jetTag.r()) != std::round(jetR)) {
-        continue;
+    for (std::size_t jetTagIndex = 0; jetTagIndex < jetsTag.size(); jetTagIndex++) {
+      int jetBaseIndex = tagToBaseMatchingGeoIndex[jetTagIndex];
+      if (jetBaseIndex > -1 && jetBaseIndex < std::ssize(jetsBase)) {
+        tagToBaseMatchingGeo[jetsTag[jetTagIndex].globalIndex()].push_back(jetsBase[jetBaseIndex].globalIndex());
       }
-      jetBaseIndex = tagToBaseMatchingGeoIndex[jetTagIndex];
-      if (jetBaseIndex > -1 && jetBaseIndex < std::ssize(jetsBasePhi)) {
-        int jetBaseGlobalIndex = jetsBaseGlobalIndex[jetBaseIndex];
-        tagToBaseMatchingGeo[jetTag.globalIndex()].push_back(jetBaseGlobalIndex);
-      }
-      jetTagIndex++;
     }
   }
 }
 
 // function that does the HF matching of jets from jetsBasePerColl and jets from jetsTagPerColl; assumes both jetsBasePerColl and jetsTagPerColl have access to Mc information
 template <bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename M, typename N, typename O>
-void MatchHF(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::vector<std::vector<int>>& baseToTagMatchingHF, std::vector<std::vector<int>>& tagToBaseMatchingHF, V const& /*candidatesBase*/, M const& /*candidatesTag*/, N const& tracksBase, O const& tracksTag)
+void MatchHF(JetsPerRadius<T, U> const& jetsPerRadius, std::vector<std::vector<int>>& baseToTagMatchingHF, std::vector<std::vector<int>>& tagToBaseMatchingHF, V const& /*candidatesBase*/, M const& /*candidatesTag*/, N const& tracksBase, O const& tracksTag)
 {
-  for (const auto& jetBase : jetsBasePerCollision) {
-    if (jetBase.candidatesIds().size() == 0) {
-      continue;
-    }
-    for (const auto& jetTag : jetsTagPerCollision) {
-      if (jetTag.candidatesIds().size() == 0) {
+  for (std::size_t iR = 0; iR < jetsPerRadius.radii.size(); iR++) {
+    for (const auto& jetBase : jetsPerRadius.jetsBase[iR]) {
+      if (jetBase.candidatesIds().size() == 0) {
         continue;
       }
-      if (std::round(jetBase.r()) != std::round(jetTag.r())) {
-        continue;
-      }
-      auto const& candidatesBase = jetBase.template candidates_as<V>();
-      std::size_t iCandidateBaseMatched = 0;
-      for (auto const& candidateBase : candidatesBase) {
-        if constexpr (jetsBaseIsMc || jetsTagIsMc) {
-          if (jetcandidateutilities::isMatchedCandidate(candidateBase)) {
-            const auto candidateBaseMcId = jetcandidateutilities::matchedParticleId(candidateBase, tracksBase, tracksTag);
+      for (const auto& jetTag : jetsPerRadius.jetsTag[iR]) {
+        if (jetTag.candidatesIds().size() == 0) {
+          continue;
+        }
+        auto const& candidatesBase = jetBase.template candidates_as<V>();
+        std::size_t iCandidateBaseMatched = 0;
+        for (auto const& candidateBase : candidatesBase) {
+          if constexpr (jetsBaseIsMc || jetsTagIsMc) {
+            if (jetcandidateutilities::isMatchedCandidate(candidateBase)) {
+              const auto candidateBaseMcId = jetcandidateutilities::matchedParticleId(candidateBase, tracksBase, tracksTag);
+              for (auto const& candidateTag : jetTag.template candidates_as<M>()) {
+                const auto candidateTagId = candidateTag.mcParticleId();
+                if (candidateBaseMcId == candidateTagId) {
+                  iCandidateBaseMatched++;
+                }
+              }
+            }
+          } else {
             for (auto const& candidateTag : jetTag.template candidates_as<M>()) {
-              const auto candidateTagId = candidateTag.mcParticleId();
-              if (candidateBaseMcId == candidateTagId) {
+              if (candidateBase.globalIndex() == candidateTag.globalIndex()) {
                 iCandidateBaseMatched++;
               }
             }
           }
-        } else {
-          for (auto const& candidateTag : jetTag.template candidates_as<M>()) {
-            if (candidateBase.globalIndex() == candidateTag.globalIndex()) {
-              iCandidateBaseMatched++;
-            }
-          }
         }
-      }
-      if (iCandidateBaseMatched == candidatesBase.size()) {
-        baseToTagMatchingHF[jetBase.globalIndex()].push_back(jetTag.globalIndex());
-        tagToBaseMatchingHF[jetTag.globalIndex()].push_back(jetBase.globalIndex());
+        if (iCandidateBaseMatched == candidatesBase.size()) {
+          baseToTagMatchingHF[jetBase.globalIndex()].push_back(jetTag.globalIndex());
+          tagToBaseMatchingHF[jetTag.globalIndex()].push_back(jetBase.globalIndex());
+        }
       }
     }
   }
@@ -433,37 +546,47 @@ auto constexpr getConstituentId(T const& track)
   }
 }
 
-template <bool isEMCAL, bool isCandidate, bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename O, typename P, typename Q, typename R, typename S>
-float getPtSum(T const& tracksBase, U const& candidatesBase, V const& clustersBase, O const& tracksTag, P const& candidatesTag, Q const& clustersTag, R const& fullTracksBase, S const& fullTracksTag)
+/**
+ * Constituent ids of a jet, looked up when computing the pt it shares with the jets of the other collection.
+ */
+struct JetConstituentIds {
+  std::unordered_set<int64_t> tracks;           // ids of the tracks, as returned by getConstituentId for the other collection
+  std::unordered_set<int64_t> clusterParticles; // ids of the mc particles of the clusters
+};
+
+template <bool otherJetsAreMc, bool withClusters, typename T, typename U>
+void fillConstituentIds(JetConstituentIds& ids, T const& tracks, U const& clusters)
+{
+  ids.tracks.clear();
+  ids.clusterParticles.clear();
+  for (const auto& track : tracks) {
+    ids.tracks.insert(getConstituentId<otherJetsAreMc>(track));
+  }
+  if constexpr (withClusters) {
+    for (const auto& cluster : clusters) {
+      for (const auto& clusterParticleId : cluster.mcParticlesIds()) {
+        ids.clusterParticles.insert(clusterParticleId);
+      }
+    }
+  }
+}
+
+template <bool isEMCAL, bool isCandidate, bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename P, typename R, typename S>
+float getPtSum(T const& tracksBase, U const& candidatesBase, V const& clustersBase, JetConstituentIds const& constituentIdsTag, P const& candidatesTag, R const& fullTracksBase, S const& fullTracksTag)
 {
-  std::vector<int> particleTracker;
   float ptSum = 0.;
   for (const auto& trackBase : tracksBase) {
     auto trackBaseId = getConstituentId<jetsTagIsMc>(trackBase);
-    for (const auto& trackTag : tracksTag) {
-      auto trackTagId = getConstituentId<jetsBaseIsMc>(trackTag);
-      if (trackBaseId != -1 && trackBaseId == trackTagId) {
-        ptSum += trackBase.pt();
-        if constexpr (jetsBaseIsMc) {
-          particleTracker.push_back(trackBaseId);
-        }
-        break;
-      }
+    if (trackBaseId != -1 && constituentIdsTag.tracks.contains(trackBaseId)) {
+      ptSum += trackBase.pt();
     }
   }
   if constexpr (isEMCAL) {
     if constexpr (jetsTagIsMc) {
       for (const auto& clusterBase : clustersBase) {
         for (const auto& clusterBaseParticleId : clusterBase.mcParticlesIds()) {
-          bool isClusterMatched = false;
-          for (const auto& trackTag : tracksTag) {
-            if (clusterBaseParticleId != -1 && clusterBaseParticleId == trackTag.globalIndex()) {
-              ptSum += clusterBase.energy() / std::cosh(clusterBase.eta());
-              isClusterMatched = true;
-              break;
-            }
-          }
-          if (isClusterMatched) {
+          if (clusterBaseParticleId != -1 && constituentIdsTag.tracks.contains(clusterBaseParticleId)) {
+            ptSum += clusterBase.energy() / std::cosh(clusterBase.eta());
             break;
           }
         }
@@ -471,22 +594,12 @@ float getPtSum(T const& tracksBase, U const& candidatesBase, V const& clustersBa
     }
     if constexpr (jetsBaseIsMc) {
       for (const auto& trackBase : tracksBase) {
-        if (std::find(particleTracker.begin(), particleTracker.end(), trackBase.globalIndex()) != particleTracker.end()) {
-          continue;
-        }
         auto trackBaseId = trackBase.globalIndex();
-        for (const auto& clusterTag : clustersTag) {
-          bool isClusterMatched = false;
-          for (const auto& clusterTagParticleId : clusterTag.mcParticlesIds()) {
-            if (trackBaseId != -1 && trackBaseId == clusterTagParticleId) {
-              ptSum += trackBase.pt();
-              isClusterMatched = true;
-              break;
-            }
-          }
-          if (isClusterMatched) {
-            break;
-          }
+        if (constituentIdsTag.tracks.contains(trackBaseId)) {
+          continue; // particle already matched to a track
+        }
+        if (trackBaseId != -1 && constituentIdsTag.clusterParticles.contains(trackBaseId)) {
+          ptSum += trackBase.pt();
         }
       }
     }
@@ -544,31 +657,48 @@ auto getConstituents(T const& jet, U const& /*constituents*/)
 }
 
 template <bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename M, typename N, typename O, typename P, typename Q>
-void MatchPt(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::vector<std::vector<int>>& baseToTagMatchingPt, std::vector<std::vector<int>>& tagToBaseMatchingPt, V const& tracksBase, M const& candidatesBase, N const& clustersBase, O const& tracksTag, P const& candidatesTag, Q const& clustersTag, float minPtFraction)
+void MatchPt(JetsPerRadius<T, U> const& jetsPerRadius, std::vector<std::vector<int>>& baseToTagMatchingPt, std::vector<std::vector<int>>& tagToBaseMatchingPt, V const& tracksBase, M const& candidatesBase, N const& clustersBase, O const& tracksTag, P const& candidatesTag, Q const& clustersTag, float minPtFraction)
 {
+  constexpr bool IsEMCAL{jetfindingutilities::isEMCALClusterTable<N>() || jetfindingutilities::isEMCALClusterTable<Q>()};
+  constexpr bool IsCandidate{(jetcandidateutilities::isCandidateTable<M>() || jetcandidateutilities::isCandidateMcTable<M>()) && (jetcandidateutilities::isCandidateTable<P>() || jetcandidateutilities::isCandidateMcTable<P>())};
+  // the constituent ids of each jet are hashed once, and looked up for each pair
+  std::vector<JetConstituentIds> constituentIdsBase;
+  std::vector<JetConstituentIds> constituentIdsTag;
   float ptSumBase;
   float ptSumTag;
-  for (const auto& jetBase : jetsBasePerCollision) {
-    auto jetBaseTracks = getConstituents(jetBase, tracksBase);
-    auto jetBaseClusters = getConstituents(jetBase, clustersBase);
-    auto jetBaseCandidates = getConstituents(jetBase, candidatesBase);
-    for (const auto& jetTag : jetsTagPerCollision) {
-      if (std::round(jetBase.r()) != std::round(jetTag.r())) {
-        continue;
-      }
-      auto jetTagTracks = getConstituents(jetTag, tracksTag);
-      auto jetTagClusters = getConstituents(jetTag, clustersTag);
-      auto jetTagCandidates = getConstituents(jetTag, candidatesTag);
-
-      constexpr bool IsEMCAL{jetfindingutilities::isEMCALClusterTable<N>() || jetfindingutilities::isEMCALClusterTable<Q>()};
-      constexpr bool IsCandidate{(jetcandidateutilities::isCandidateTable<M>() || jetcandidateutilities::isCandidateMcTable<M>()) && (jetcandidateutilities::isCandidateTable<P>() || jetcandidateutilities::isCandidateMcTable<P>())};
-      ptSumBase = getPtSum<IsEMCAL, IsCandidate, jetsBaseIsMc, jetsTagIsMc>(jetBaseTracks, jetBaseCandidates, jetBaseClusters, jetTagTracks, jetTagCandidates, jetTagClusters, tracksBase, tracksTag);
-      ptSumTag = getPtSum<IsEMCAL, IsCandidate, jetsTagIsMc, jetsBaseIsMc>(jetTagTracks, jetTagCandidates, jetTagClusters, jetBaseTracks, jetBaseCandidates, jetBaseClusters, tracksTag, tracksBase);
-      if (ptSumBase > jetBase.pt() * minPtFraction) {
-        baseToTagMatchingPt[jetBase.globalIndex()].push_back(jetTag.globalIndex());
-      }
-      if (ptSumTag > jetTag.pt() * minPtFraction) {
-        tagToBaseMatchingPt[jetTag.globalIndex()].push_back(jetBase.globalIndex());
+  for (std::size_t iR = 0; iR < jetsPerRadius.radii.size(); iR++) {
+    const auto& jetsBase = jetsPerRadius.jetsBase[iR];
+    const auto& jetsTag = jetsPerRadius.jetsTag[iR];
+    if (jetsBase.empty() || jetsTag.empty()) {
+      continue;
+    }
+    constituentIdsBase.resize(jetsBase.size());
+    for (std::size_t iBase = 0; iBase < jetsBase.size(); iBase++) {
+      fillConstituentIds<jetsTagIsMc, IsEMCAL && jetsTagIsMc>(constituentIdsBase[iBase], getConstituents(jetsBase[iBase], tracksBase), getConstituents(jetsBase[iBase], clustersBase));
+    }
+    constituentIdsTag.resize(jetsTag.size());
+    for (std::size_t iTag = 0; iTag < jetsTag.size(); iTag++) {
+      fillConstituentIds<jetsBaseIsMc, IsEMCAL && jetsBaseIsMc>(constituentIdsTag[iTag], getConstituents(jetsTag[iTag], tracksTag), getConstituents(jetsTag[iTag], clustersTag));
+    }
+    for (std::size_t iBase = 0; iBase < jetsBase.size(); iBase++) {
+      const auto& jetBase = jetsBase[iBase];
+      auto jetBaseTracks = getConstituents(jetBase, tracksBase);
+      auto jetBaseClusters = getConstituents(jetBase, clustersBase);
+      auto jetBaseCandidates = getConstituents(jetBase, candidatesBase);
+      for (std::size_t iTag = 0; iTag < jetsTag.size(); iTag++) {
+        const auto& jetTag = jetsTag[iTag];
+        auto jetTagTracks = getConstituents(jetTag, tracksTag);
+        auto jetTagClusters = getConstituents(jetTag, clustersTag);
+        auto jetTagCandidates = getConstituents(jetTag, candidatesTag);
+
+        ptSumBase = getPtSum<IsEMCAL, IsCandidate, jetsBaseIsMc, jetsTagIsMc>(jetBaseTracks, jetBaseCandidates, jetBaseClusters, constituentIdsTag[iTag], jetTagCandidates, tracksBase, tracksTag);
+        ptSumTag = getPtSum<IsEMCAL, IsCandidate, jetsTagIsMc, jetsBaseIsMc>(jetTagTracks, jetTagCandidates, jetTagClusters, constituentIdsBase[iBase], jetBaseCandidates, tracksTag, tracksBase);
+        if (ptSumBase > jetBase.pt() * minPtFraction) {
+          baseToTagMatchingPt[jetBase.globalIndex()].push_back(jetTag.globalIndex());
+        }
+        if (ptSumTag > jetTag.pt() * minPtFraction) {
+          tagToBaseMatchingPt[jetTag.globalIndex()].push_back(jetBase.globalIndex());
+        }
       }
     }
   }
@@ -578,18 +708,20 @@ void MatchPt(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::v
 template <bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename M, typename N, typename O, typename P, typename R>
 void doAllMatching(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::vector<std::vector<int>>& baseToTagMatchingGeo, std::vector<std::vector<int>>& baseToTagMatchingPt, std::vector<std::vector<int>>& baseToTagMatchingHF, std::vector<std::vector<int>>& tagToBaseMatchingGeo, std::vector<std::vector<int>>& tagToBaseMatchingPt, std::vector<std::vector<int>>& tagToBaseMatchingHF, V const& candidatesBase, M const& tracksBase, N const& clustersBase, O const& candidatesTag, P const& tracksTag, R const& clustersTag, bool doMatchingGeo, bool doMatchingHf, bool doMatchingPt, float minPtFraction, std::vector<double> const& jetRadiiForMatchingDistance, std::vector<double> const& maxMatchingDistancePerJetR)
 {
+  // jets grouped by radius, shared by all the matchings
+  const auto jetsPerRadius = groupJetsByRadius(jetsBasePerCollision, jetsTagPerCollision);
   // geometric matching
   if (doMatchingGeo) {
-    MatchGeo(jetsBasePerCollision, jetsTagPerCollision, baseToTagMatchingGeo, tagToBaseMatchingGeo, jetRadiiForMatchingDistance, maxMatchingDistancePerJetR);
+    MatchGeo(jetsPerRadius, baseToTagMatchingGeo, tagToBaseMatchingGeo, jetRadiiForMatchingDistance, maxMatchingDistancePerJetR);
   }
   // pt matching
   if (doMatchingPt) {
-    MatchPt<jetsBaseIsMc, jetsTagIsMc>(jetsBasePerCollision, jetsTagPerCollision, baseToTagMatchingPt, tagToBaseMatchingPt, tracksBase, candidatesBase, clustersBase, tracksTag, candidatesTag, clustersTag, minPtFraction);
+    MatchPt<jetsBaseIsMc, jetsTagIsMc>(jetsPerRadius, baseToTagMatchingPt, tagToBaseMatchingPt, tracksBase, candidatesBase, clustersBase, tracksTag, candidatesTag, clustersTag, minPtFraction);
   }
   // HF matching
   if constexpr (jetcandidateutilities::isCandidateTable<V>() || jetcandidateutilities::isCandidateMcTable<V>()) {
     if (doMatchingHf) {
-      MatchHF<jetsBaseIsMc, jetsTagIsMc>(jetsBasePerCollision, jetsTagPerCollision, baseToTagMatchingHF, tagToBaseMatchingHF, candidatesBase, candidatesTag, tracksBase, tracksTag);
+      MatchHF<jetsBaseIsMc, jetsTagIsMc>(jetsPerRadius, baseToTagMatchingHF, tagToBaseMatchingHF, candidatesBase, candidatesTag, tracksBase, tracksTag);
     }
   }
 }
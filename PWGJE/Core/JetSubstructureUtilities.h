@@ -25,31 +25,33 @@
 #include <Framework/ASoA.h>
 
 #include <fastjet/ClusterSequenceArea.hh>
+#include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/contrib/MeasureDefinition.hh>
 #include <fastjet/contrib/Nsubjettiness.hh>
 #include <fastjet/contrib/SoftDrop.hh>
 
 #include <cmath>
+#include <memory>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace jetsubstructureutilities
 {
 
 /**
- * convert an O2Physics jet to a fastjet pseudojet object, returning its clusterSequence
+ * fill the constituents of an O2Physics jet as fastjet pseudojets
  *
- * @param jet jet to be converted
+ * @param jet jet whose constituents are filled
  * @param tracks vector of constituent tracks
  * @param clusters vector of constituent clusters
  * @param candidates vector of constituent candidates
- * @param pseudoJet converted pseudoJet object which is passed by reference
+ * @param jetConstituents vector of pseudojets to which the constituents are added
  */
 template <typename T, typename U, typename V, typename O>
-fastjet::ClusterSequenceArea jetToPseudoJet(T const& jet, U const& /*tracks*/, V const& /*clusters*/, O const& /*candidates*/, fastjet::PseudoJet& pseudoJet, int hadronicCorrectionType = 0)
+void fillJetConstituents(T const& jet, U const& /*tracks*/, V const& /*clusters*/, O const& /*candidates*/, std::vector<fastjet::PseudoJet>& jetConstituents, int hadronicCorrectionType = 0)
 {
-  std::vector<fastjet::PseudoJet> jetConstituents;
   for (auto& jetConstituent : jet.template tracks_as<U>()) {
     fastjetutilities::fillTracks(jetConstituent, jetConstituents, jetConstituent.globalIndex());
   }
@@ -63,6 +65,22 @@ fastjet::ClusterSequenceArea jetToPseudoJet(T const& jet, U const& /*tracks*/, V
       fastjetutilities::fillTracks(jetHFConstituent, jetConstituents, jetHFConstituent.globalIndex(), JetConstituentStatus::candidate, jetcandidateutilities::getTablePDGMass<O>());
     }
   }
+}
+
+/**
+ * convert an O2Physics jet to a fastjet pseudojet object, returning its clusterSequence
+ *
+ * @param jet jet to be converted
+ * @param tracks vector of constituent tracks
+ * @param clusters vector of constituent clusters
+ * @param candidates vector of constituent candidates
+ * @param pseudoJet converted pseudoJet object which is passed by reference
+ */
+template <typename T, typename U, typename V, typename O>
+fastjet::ClusterSequenceArea jetToPseudoJet(T const& jet, U const& tracks, V const& clusters, O const& candidates, fastjet::PseudoJet& pseudoJet, int hadronicCorrectionType = 0)
+{
+  std::vector<fastjet::PseudoJet> jetConstituents;
+  fillJetConstituents(jet, tracks, clusters, candidates, jetConstituents, hadronicCorrectionType);
   std::vector<fastjet::PseudoJet> jetReclustered;
 
   JetFinder jetReclusterer;
@@ -74,6 +92,171 @@ fastjet::ClusterSequenceArea jetToPseudoJet(T const& jet, U const& /*tracks*/, V
   return clusterSeq;
 }
 
+/**
+ * reclustering history of one jet, built once per jet and shared by its substructure observables
+ * (primary declusterings and Lund-plane emissions, soft drop and N-subjettiness)
+ *
+ * the constituents are reclustered with C/A (or another algorithm, e.g. kT) in a single jet of radius 5R without ghosts,
+ * as done by the substructure tasks. The soft drop grooming and N-subjettiness follow the definitions of getNSubjettiness
+ */
+class JetReclusteringCache
+{
+ public:
+  // primary declustering of the history, following the harder branch
+  struct Splitting {
+    fastjet::PseudoJet mother;
+    fastjet::PseudoJet harder; // branch with the larger pt, which is declustered further
+    fastjet::PseudoJet softer;
+  };
+
+  explicit JetReclusteringCache(fastjet::JetAlgorithm algorithm = fastjet::cambridge_algorithm)
+  {
+    mReclusterer.isReclustering = true;
+    mReclusterer.algorithm = algorithm;
+    mReclusterer.ghostRepeatN = 0;
+  }
+
+  /**
+   * reclusters the constituents of an O2Physics jet
+   *
+   * @param jet jet to be reclustered
+   * @param tracks vector of constituent tracks
+   * @param clusters vector of constituent clusters
+   * @param candidates vector of constituent candidates
+   */
+  template <typename T, typename U, typename V, typename O>
+  void fill(T const& jet, U const& tracks, V const& clusters, O const& candidates, int hadronicCorrectionType = 0)
+  {
+    mConstituents.clear();
+    fillJetConstituents(jet, tracks, clusters, candidates, mConstituents, hadronicCorrectionType);
+    recluster(jet.r() / 100.0);
+  }
+
+  /**
+   * reclusters constituents which are already converted to pseudojets (e.g. with the PDG masses of MC particles)
+   *
+   * @param jetConstituents constituents of the jet
+   * @param jetR radius of the jet
+   */
+  void fill(std::vector<fastjet::PseudoJet> const& jetConstituents, double jetR)
+  {
+    mConstituents = jetConstituents;
+    recluster(jetR);
+  }
+
+  bool isValid() const { return !mJets.empty(); }
+
+  // leading jet of the reclustering, whose history is exposed
+  fastjet::PseudoJet const& getJet() const { return mJets[0]; }
+
+  std::vector<fastjet::PseudoJet> const& getConstituents() const { return mConstituents; }
+
+  // primary declusterings, computed at the first call for the jet
+  std::vector<Splitting> const& getPrimarySplittings()
+  {
+    if (!mHasPrimarySplittings && isValid()) {
+      fastjet::PseudoJet daughterSubJet = getJet();
+      fastjet::PseudoJet parentSubJet1;
+      fastjet::PseudoJet parentSubJet2;
+      while (daughterSubJet.has_parents(parentSubJet1, parentSubJet2)) {
+        if (parentSubJet1.perp() < parentSubJet2.perp()) {
+          std::swap(parentSubJet1, parentSubJet2);
+        }
+        mPrimarySplittings.push_back({daughterSubJet, parentSubJet1, parentSubJet2});
+        daughterSubJet = parentSubJet1;
+      }
+      mHasPrimarySplittings = true;
+    }
+    return mPrimarySplittings;
+  }
+
+  /**
+   * returns the soft drop groomed jet, computed at the first call for the jet and each set of parameters
+   *
+   * @param zCut minimim momentum sharing fraction needed to satisfy the SoftDrop condition
+   * @param beta angular exponent in the SoftDrop condition
+   */
+  fastjet::PseudoJet const& getSoftDropJet(float zCut, float beta)
+  {
+    for (auto const& softDropJet : mSoftDropJets) {
+      if (softDropJet.zCut == zCut && softDropJet.beta == beta) {
+        return softDropJet.jet;
+      }
+    }
+    fastjet::contrib::SoftDrop softDrop(beta, zCut);
+    mSoftDropJets.push_back({zCut, beta, softDrop(getJet())});
+    return mSoftDropJets.back().jet;
+  }
+
+  /**
+   * returns a vector with Nsubjettiness variables, as getNSubjettiness
+   *
+   * @param nMax returns a vector filled with TauN values upto N (the first entry is the distance between axes in tau2)
+   * @param reclusteringAlgorithm type of reclustering algorithm used to find Nsubjettiness axes
+   * @param doSoftDrop apply SoftDrop
+   * @param zCut minimim momentum sharing fraction needed to satisfy the SoftDrop condition
+   * @param beta angular exponent in the SoftDrop condition
+   */
+  template <typename M>
+  std::vector<float> getNSubjettiness(std::vector<fastjet::PseudoJet>::size_type nMax, M const& reclusteringAlgorithm, bool doSoftDrop = false, float zCut = 0.1, float beta = 0.0)
+  {
+    std::vector<float> result;
+    for (std::vector<fastjet::PseudoJet>::size_type n = 0; n < nMax + 1; n++) {
+      result.push_back(-1.0 * (n + 1));
+    }
+    if (!isValid()) {
+      return result;
+    }
+    fastjet::PseudoJet const& pseudoJet = doSoftDrop ? getSoftDropJet(zCut, beta) : getJet();
+
+    for (std::vector<fastjet::PseudoJet>::size_type n = 1; n <= nMax; n++) {
+      if (pseudoJet.constituents().size() < n) { // Tau_N needs at least N tracks
+        return result;
+      }
+      fastjet::contrib::Nsubjettiness nSub(n, reclusteringAlgorithm, fastjet::contrib::NormalizedMeasure(1.0, mJetR));
+      result[n] = nSub.result(pseudoJet);
+      if (n == 2) {
+        std::vector<fastjet::PseudoJet> nSubAxes = nSub.currentAxes(); // gets the two axes used in the 2-subjettiness calculation
+        result[0] = nSubAxes[0].delta_R(nSubAxes[1]);                  // distance between axes for 2-subjettiness
+      }
+    }
+    return result;
+  }
+
+ private:
+  struct SoftDropJet {
+    float zCut;
+    float beta;
+    fastjet::PseudoJet jet;
+  };
+
+  void recluster(double jetR)
+  {
+    mPrimarySplittings.clear();
+    mHasPrimarySplittings = false;
+    mSoftDropJets.clear();
+    mJetR = jetR;
+    if (!mIsInitialised) {
+      mReclusterer.jetR = jetR;
+      mReclusterer.setParams();
+      mIsInitialised = true;
+    } else if (mReclusterer.jetR != static_cast<float>(jetR)) {
+      mReclusterer.setJetRadius(jetR);
+    }
+    mReclusterer.findJets(mConstituents, mJets, mClusterSeq);
+  }
+
+  JetFinder mReclusterer;
+  bool mIsInitialised = false;
+  double mJetR = 0.;
+  std::vector<fastjet::PseudoJet> mConstituents;
+  std::vector<fastjet::PseudoJet> mJets;
+  std::unique_ptr<fastjet::ClusterSequenceArea> mClusterSeq; // owns the history of the pseudojets below
+  std::vector<Splitting> mPrimarySplittings;
+  bool mHasPrimarySplittings = false;
+  std::vector<SoftDropJet> mSoftDropJets;
+};
+
 /**
  * returns a vector with Nsubjettiness variables
  *
@@ -92,30 +275,9 @@ fastjet::ClusterSequenceArea jetToPseudoJet(T const& jet, U const& /*tracks*/, V
 template <typename T, typename U, typename V, typename O, typename M>
 std::vector<float> getNSubjettiness(T const& jet, U const& tracks, V const& clusters, O const& candidates, std::vector<fastjet::PseudoJet>::size_type nMax, M const& reclusteringAlgorithm, bool doSoftDrop = false, float zCut = 0.1, float beta = 0.0, int hadronicCorrectionType = 0)
 {
-  std::vector<float> result;
-  fastjet::PseudoJet pseudoJet;
-  fastjet::ClusterSequenceArea clusterSeq(jetToPseudoJet(jet, tracks, clusters, candidates, pseudoJet, hadronicCorrectionType));
-  if (doSoftDrop) {
-    fastjet::contrib::SoftDrop softDrop(beta, zCut);
-    pseudoJet = softDrop(pseudoJet);
-  }
-
-  for (std::vector<fastjet::PseudoJet>::size_type n = 0; n < nMax + 1; n++) {
-    result.push_back(-1.0 * (n + 1));
-  }
-
-  for (std::vector<fastjet::PseudoJet>::size_type n = 1; n <= nMax; n++) {
-    if (pseudoJet.constituents().size() < n) { // Tau_N needs at least N tracks
-      return result;
-    }
-    fastjet::contrib::Nsubjettiness nSub(n, reclusteringAlgorithm, fastjet::contrib::NormalizedMeasure(1.0, jet.r() / 100.0));
-    result[n] = nSub.result(pseudoJet);
-    if (n == 2) {
-      std::vector<fastjet::PseudoJet> nSubAxes = nSub.currentAxes(); // gets the two axes used in the 2-subjettiness calculation
-      result[0] = nSubAxes[0].delta_R(nSubAxes[1]);                  // distance between axes for 2-subjettiness
-    }
-  }
-  return result;
+  JetReclusteringCache jetReclusteringCache;
+  jetReclusteringCache.fill(jet, tracks, clusters, candidates, hadronicCorrectionType);
+  return jetReclusteringCache.getNSubjettiness(nMax, reclusteringAlgorithm, doSoftDrop, zCut, beta);
 }
 
 }; // namespace jetsubstructureutilities
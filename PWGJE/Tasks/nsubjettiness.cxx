@@ -109,6 +109,7 @@ struct NSubjettinessTask {
   ConfigurableAxis NSubRatioBinning{"NSub-Ratio-binning", {50, 0.0f, 1.2f}, ""};
 
   JetFinder jetReclusterer;
+  jetsubstructureutilities::JetReclusteringCache jetReclusteringCache;
   std::vector<float> nSub_Kt_results;
   std::vector<float> nSub_CA_results;
   std::vector<float> nSub_CASD_results;
@@ -186,9 +187,10 @@ struct NSubjettinessTask {
   template <bool isMCP, typename T, typename U>
   void processJet(T const& jet, U const& tracks, float weight = 1.0)
   {
-    nSub_Kt_results = jetsubstructureutilities::getNSubjettiness(jet, tracks, tracks, tracks, 2, fastjet::contrib::KT_Axes());
-    nSub_CA_results = jetsubstructureutilities::getNSubjettiness(jet, tracks, tracks, tracks, 2, fastjet::contrib::CA_Axes());
-    nSub_CASD_results = jetsubstructureutilities::getNSubjettiness(jet, tracks, tracks, tracks, 2, fastjet::contrib::CA_Axes(), true, SD_z_cut, SD_beta);
+    jetReclusteringCache.fill(jet, tracks, tracks, tracks);
+    nSub_Kt_results = jetReclusteringCache.getNSubjettiness(2, fastjet::contrib::KT_Axes());
+    nSub_CA_results = jetReclusteringCache.getNSubjettiness(2, fastjet::contrib::CA_Axes());
+    nSub_CASD_results = jetReclusteringCache.getNSubjettiness(2, fastjet::contrib::CA_Axes(), true, SD_z_cut, SD_beta);
 
     if (jet.tracksIds().size() > 1) {
       if constexpr (isMCP) {
@@ -38,6 +38,7 @@
 #include <cstdint>
 #include <numeric>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 // namespace with helpers for UD framework
@@ -111,65 +112,110 @@ float rPVtrwTOF(TCs tracks, int nPVTracks)
 template <typename T>
 T compatibleBCs(uint64_t const& meanBC, int const& deltaBC, T const& bcs);
 
+// The BCs table is sorted in globalBC. This returns the first row with globalBC >= value
+// (globalBC > value if upper is true), or bcs.size(). The search starts at the row hint and is
+// exponential, followed by a binary search, which needs O(log(distance to the hint)) steps
+template <bool upper, typename T>
+int64_t bcBound(T const& bcs, uint64_t value, int64_t hint)
+{
+  const int64_t nBCs = bcs.size();
+  if (nBCs == 0) {
+    return 0;
+  }
+  auto isBelow = [&bcs, value](int64_t id) {
+    const uint64_t globalBC = bcs.iteratorAt(id).globalBC();
+    return upper ? globalBC <= value : globalBC < value;
+  };
+
+  // bracket the bound in (low, high], with isBelow(low) (or low = -1) and !isBelow(high) (or high = nBCs)
+  hint = std::clamp<int64_t>(hint, 0, nBCs - 1);
+  int64_t low = hint;
+  int64_t high = hint;
+  int64_t step = 1;
+  if (isBelow(hint)) {
+    high = hint + step;
+    while (high < nBCs && isBelow(high)) {
+      low = high;
+      step *= 2;
+      high = low + step;
+    }
+    high = std::min(high, nBCs);
+  } else {
+    low = hint - step;
+    while (low >= 0 && !isBelow(low)) {
+      high = low;
+      step *= 2;
+      low = high - step;
+    }
+    low = std::max<int64_t>(low, -1);
+  }
+  while (high - low > 1) {
+    const int64_t mid = low + (high - low) / 2;
+    if (isBelow(mid)) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return high;
+}
+
+// slice of the BCs table with the rows [range.first, range.second)
+template <typename T>
+T bcSlice(std::pair<int64_t, int64_t> const& range, T const& bcs)
+{
+  T bcslice{{bcs.asArrowTable()->Slice(range.first, range.second - range.first)}, static_cast<uint64_t>(range.first)};
+  bcs.copyIndexBindings(bcslice);
+  return bcslice;
+}
+
 template <typename B, typename T>
 T compatibleBCs(B const& bc, uint64_t const& meanBC, int const& deltaBC, T const& bcs);
 
 // In this variant of compatibleBCs the bcIter is ideally placed within
-// [minBC, maxBC], but it does not need to be. The range is given by meanBC +- delatBC.
+// [minBC, maxBC], but it does not need to be: it is the starting point of the search,
+// which is faster the closer it is to the range. The range is given by meanBC +- delatBC.
 template <typename B, typename T>
 T compatibleBCs(B const& bc, uint64_t const& meanBC, int const& deltaBC, T const& bcs)
 {
-  // get BCs iterator
-  auto bcIter = bcs.iteratorAt(bc.globalIndex());
-
   // range of BCs to consider
   uint64_t minBC = static_cast<uint64_t>(deltaBC) < meanBC ? meanBC - static_cast<uint64_t>(deltaBC) : 0;
   uint64_t maxBC = meanBC + static_cast<uint64_t>(deltaBC);
-  LOGF(debug, "  minBC %d maxBC %d bcIterator %d (%d) #BCs %d", minBC, maxBC, bcIter.globalBC(), bcIter.globalIndex(), bcs.size());
+  LOGF(debug, "  minBC %d maxBC %d bcIterator %d #BCs %d", minBC, maxBC, bc.globalIndex(), bcs.size());
 
   // check [min,max]BC to overlap with [bcs.iteratorAt([0,bcs.size() - 1])
-  if (maxBC < bcs.iteratorAt(0).globalBC() || minBC > bcs.iteratorAt(bcs.size() - 1).globalBC()) {
-    LOGF(debug, "<compatibleBCs> No overlap of [%d, %d] and [%d, %d]", minBC, maxBC, bcs.iteratorAt(0).globalBC(), bcs.iteratorAt(bcs.size() - 1).globalBC());
+  if (bcs.size() == 0 || maxBC < bcs.iteratorAt(0).globalBC() || minBC > bcs.iteratorAt(bcs.size() - 1).globalBC()) {
+    LOGF(debug, "<compatibleBCs> No overlap of [%d, %d] with the BCs table", minBC, maxBC);
     return T{{bcs.asArrowTable()->Slice(0, 0)}, static_cast<uint64_t>(0)};
   }
 
-  // find slice of BCs table with BC in [minBC, maxBC]
-  int64_t minBCId = bcIter.globalIndex();
-  int64_t maxBCId = bcIter.globalIndex();
-
-  // lower limit
-  if (bcIter.globalBC() < minBC) {
-    while (bcIter != bcs.end() && bcIter.globalBC() < minBC) {
-      ++bcIter;
-      minBCId = bcIter.globalIndex();
-    }
-  } else {
-    while (bcIter.globalIndex() > 0 && bcIter.globalBC() >= minBC) {
-      minBCId = bcIter.globalIndex();
-      --bcIter;
-    }
-  }
-
-  // upper limit limit
-  if (bcIter.globalBC() < maxBC) {
-    while (bcIter != bcs.end() && bcIter.globalBC() <= maxBC) {
-      maxBCId = bcIter.globalIndex();
-      ++bcIter;
-    }
-  } else {
-    while (bcIter.globalIndex() > 0 && bcIter.globalBC() > maxBC) {
-      --bcIter;
-      maxBCId = bcIter.globalIndex();
-    }
-  }
+  // find slice of BCs table with BC in [minBC, maxBC], searching from bc for the lower limit
+  // and from the lower limit for the upper limit
+  int64_t minBCId = bcBound<false>(bcs, minBC, bc.globalIndex());
+  int64_t maxBCId = std::max(bcBound<true>(bcs, maxBC, minBCId), minBCId);
 
   // create bc slice
-  T bcslice{{bcs.asArrowTable()->Slice(minBCId, maxBCId - minBCId + 1)}, static_cast<uint64_t>(minBCId)};
-  bcs.copyIndexBindings(bcslice);
+  T bcslice = bcSlice(std::make_pair(minBCId, maxBCId), bcs);
   LOGF(debug, "  size of slice %d", bcslice.size());
   return bcslice;
 }
 
+// window meanBC +- deltaBC of the BCs compatible with a collision, calculated from the BC associated with the
+// collision, the collision time and the time resolution dt. Typically the range is +- 4*dt.
+template <typename C, typename B>
+void compatibleBCWindow(C const& collision, B const& bc, int ndt, int nMinBCs, uint64_t& meanBC, int& deltaBC)
+{
+  // due to the filling scheme the most probable BC may not be the one estimated from the collision time
+  uint64_t mostProbableBC = bc.globalBC();
+  meanBC = mostProbableBC + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+
+  // enforce minimum number for deltaBC
+  deltaBC = std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * ndt);
+  if (deltaBC < nMinBCs) {
+    deltaBC = nMinBCs;
+  }
+}
+
 // In this variant of compatibleBCs the range of compatible BCs is calculated from the
 // collision time and the time resolution dt. Typically the range is +- 4*dt.
 template <typename C, typename T>
@@ -185,15 +231,9 @@ T compatibleBCs(C const& collision, int ndt, T const& bcs, int nMinBCs = 7)
   // get associated BC
   auto bcIter = collision.template foundBC_as<T>();
 
-  // due to the filling scheme the most probable BC may not be the one estimated from the collision time
-  uint64_t mostProbableBC = bcIter.globalBC();
-  uint64_t meanBC = mostProbableBC + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
-
-  // enforce minimum number for deltaBC
-  int deltaBC = std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * ndt);
-  if (deltaBC < nMinBCs) {
-    deltaBC = nMinBCs;
-  }
+  uint64_t meanBC = 0;
+  int deltaBC = 0;
+  compatibleBCWindow(collision, bcIter, ndt, nMinBCs, meanBC, deltaBC);
   LOGF(debug, "BC %d,  deltaBC %d", bcIter.globalIndex(), deltaBC);
 
   return compatibleBCs(bcIter, meanBC, deltaBC, bcs);
@@ -226,17 +266,62 @@ T MCcompatibleBCs(F const& collision, int const& ndt, T const& bcs, int const& n
   // get associated BC
   auto bcIter = collision.template foundBC_as<T>();
 
-  // due to the filling scheme the most probable BC may not be the one estimated from the collision time
-  uint64_t mostProbableBC = bcIter.globalBC();
-  uint64_t meanBC = mostProbableBC + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+  uint64_t meanBC = 0;
+  int deltaBC = 0;
+  compatibleBCWindow(collision, bcIter, ndt, nMinBCs, meanBC, deltaBC);
 
-  // enforce minimum number for deltaBC
-  int deltaBC = std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * ndt);
-  if (deltaBC < nMinBCs) {
-    deltaBC = nMinBCs;
+  return compatibleBCs(bcIter, meanBC, deltaBC, bcs);
+}
+
+// -----------------------------------------------------------------------------
+// Batch variant of compatibleBCs(collision, ndt, bcs, nMinBCs) for all the collisions of a table.
+// The globalBCs of the BCs table are copied once and swept in one pass by the BC windows of the
+// collisions, sorted in minBC and in maxBC. ranges[i] is the range of rows of the BCs compatible with
+// the i-th collision (empty if it has no associated BC), the slice being bcSlice(ranges[i], bcs)
+template <typename C, typename T>
+void compatibleBCRanges(C const& collisions, int ndt, T const& bcs, int nMinBCs, std::vector<std::pair<int64_t, int64_t>>& ranges)
+{
+  std::vector<uint64_t> globalBCs;
+  globalBCs.reserve(bcs.size());
+  for (auto const& bc : bcs) {
+    globalBCs.push_back(bc.globalBC());
   }
 
-  return compatibleBCs(bcIter, meanBC, deltaBC, bcs);
+  // BC windows of the collisions with an associated BC
+  std::vector<std::pair<uint64_t, uint64_t>> windows(collisions.size());
+  std::vector<int64_t> ids;
+  int64_t iCollision = 0;
+  for (auto const& collision : collisions) {
+    if (collision.has_foundBC() && ndt >= 0) {
+      uint64_t meanBC = 0;
+      int deltaBC = 0;
+      compatibleBCWindow(collision, collision.template foundBC_as<T>(), ndt, nMinBCs, meanBC, deltaBC);
+      windows[iCollision] = {static_cast<uint64_t>(deltaBC) < meanBC ? meanBC - static_cast<uint64_t>(deltaBC) : 0, meanBC + static_cast<uint64_t>(deltaBC)};
+      ids.push_back(iCollision);
+    }
+    iCollision++;
+  }
+  ranges.assign(collisions.size(), {0, 0});
+
+  // lower limits, with the windows in increasing minBC
+  std::sort(ids.begin(), ids.end(), [&windows](int64_t a, int64_t b) { return windows[a].first < windows[b].first; });
+  std::size_t iBC = 0;
+  for (const auto id : ids) {
+    while (iBC < globalBCs.size() && globalBCs[iBC] < windows[id].first) {
+      iBC++;
+    }
+    ranges[id].first = iBC;
+  }
+
+  // upper limits, with the windows in increasing maxBC
+  std::sort(ids.begin(), ids.end(), [&windows](int64_t a, int64_t b) { return windows[a].second < windows[b].second; });
+  iBC = 0;
+  for (const auto id : ids) {
+    while (iBC < globalBCs.size() && globalBCs[iBC] <= windows[id].second) {
+      iBC++;
+    }
+    ranges[id].second = std::max<int64_t>(iBC, ranges[id].first);
+  }
 }
 
 // -----------------------------------------------------------------------------
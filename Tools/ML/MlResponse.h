@@ -18,13 +18,17 @@
 #define TOOLS_ML_MLRESPONSE_H_
 
 #include "Tools/ML/model.h"
+#include "Tools/ML/treeEnsemble.h"
 
 #include <CCDB/CcdbApi.h>
 #include <Framework/Array2D.h>
 #include <Framework/Logger.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <map>
 #include <string>
 #include <vector>
@@ -70,6 +74,7 @@ class MlResponse
     mNClasses = nClasses;
     mNModels = binsLimits.size() - 1;
     mModels = std::vector<o2::ml::OnnxModel>(mNModels);
+    mTreeModels = std::vector<o2::ml::TreeEnsembleModel>(mNModels);
     mPaths = std::vector<std::string>(mNModels);
   }
 
@@ -95,6 +100,7 @@ class MlResponse
     mNVar2Bins = binsLimitsVar2.size() - 1;
     mNModels = mNVar1Bins * mNVar2Bins;
     mModels = std::vector<o2::ml::OnnxModel>(mNModels);
+    mTreeModels = std::vector<o2::ml::TreeEnsembleModel>(mNModels);
     mPaths = std::vector<std::string>(mNModels);
 
     mUse2DBinning = true;
@@ -145,14 +151,41 @@ class MlResponse
     mPaths = onnxFiles;
   }
 
-  /// Initialize class instance (initialize OnnxModels)
+  /// Select the inference backend of each model (to be called before init)
+  /// \param backends is a vector with the o2::ml::InferenceBackend of each model, ONNX Runtime is used for all the models if empty
+  /// \param validationPeriod is the period (in candidates) of the cross-check against ONNX Runtime for the NativeTreeEnsembleValidated backend
+  /// \param validationTolerance is the maximum absolute difference between the scores of the two backends
+  void setBackends(const std::vector<int>& backends, int validationPeriod = 100, float validationTolerance = 1.e-4f)
+  {
+    if (!backends.empty() && backends.size() != mNModels) {
+      LOG(fatal) << "Number of expected models (" << mNModels << ") different from the number of backends (" << backends.size() << ")! Please check your configurables.";
+    }
+    mBackends = backends;
+    mValidationPeriod = validationPeriod > 0 ? validationPeriod : 1;
+    mValidationTolerance = validationTolerance;
+  }
+
+  /// Initialize class instance (initialize OnnxModels and/or TreeEnsembleModels)
   /// \param enableOptimizations is a switch to enable optimizations
   /// \param threads is the number of active threads
+  /// \note Models that cannot be evaluated by the native tree-ensemble evaluator fall back to ONNX Runtime
   void init(bool enableOptimizations = false, int threads = 0)
   {
+    mUseNativeModel.assign(mNModels, false);
+    mValidateNativeModel.assign(mNModels, false);
     uint8_t counterModel{0};
     for (const auto& path : mPaths) {
-      mModels[counterModel].initModel(path, enableOptimizations, threads);
+      const int backend = mBackends.empty() ? o2::ml::InferenceBackend::OnnxRuntime : mBackends[counterModel];
+      if (backend != o2::ml::InferenceBackend::OnnxRuntime) {
+        mUseNativeModel[counterModel] = mTreeModels[counterModel].initModel(path);
+        if (!mUseNativeModel[counterModel]) {
+          LOG(warn) << "Model " << path << " cannot be evaluated by the native tree-ensemble evaluator, falling back to ONNX Runtime";
+        }
+      }
+      mValidateNativeModel[counterModel] = mUseNativeModel[counterModel] && backend == o2::ml::InferenceBackend::NativeTreeEnsembleValidated;
+      if (!mUseNativeModel[counterModel] || mValidateNativeModel[counterModel]) {
+        mModels[counterModel].initModel(path, enableOptimizations, threads);
+      }
       ++counterModel;
     }
   }
@@ -182,6 +215,16 @@ class MlResponse
       LOG(fatal) << "Model index " << nModel << " is out of range! The number of initialised models is " << mModels.size() << ". Please check your configurables.";
     }
 
+    if (mUseNativeModel[nModel]) {
+      std::vector<TypeOutputScore> output;
+      mTreeModels[nModel].evalModelBatch(input, output);
+      if (mValidateNativeModel[nModel]) {
+        validateNativeOutput(input, output, nModel);
+      }
+      output.resize(mNClasses);
+      return output;
+    }
+
     TypeOutputScore* outputPtr = mModels[nModel].template evalModel<TypeOutputScore>(input);
     return std::vector<TypeOutputScore>{outputPtr, outputPtr + mNClasses};
   }
@@ -237,6 +280,98 @@ class MlResponse
     return true;
   }
 
+  /// Batched inference
+  /// The features of all the candidates of a dataframe are first collected with addToBatch(), grouped by model (e.g. pT bin),
+  /// then evalBatch() runs a single Session::Run per model and the scores are stored in buffers owned by this class
+  /// Example:
+  ///   mlResponse.clearBatch();
+  ///   for (const auto& cand : candidates) { indices.push_back(mlResponse.addToBatch(features(cand), cand.pt())); }
+  ///   mlResponse.evalBatch();
+  ///   for (...) { bool isSel = mlResponse.isSelectedMlBatch(indices[i]); const float* scores = mlResponse.getBatchOutput(indices[i]); }
+
+  /// Remove all the candidates from the batch (the allocated buffers are kept for the next dataframe)
+  void clearBatch()
+  {
+    mBatchInputs.resize(mNModels);
+    mBatchOutputs.resize(mNModels);
+    for (auto iModel{0}; iModel < mNModels; ++iModel) {
+      mBatchInputs[iModel].clear();
+    }
+    mBatchCandModel.clear();
+    mBatchCandRow.clear();
+  }
+
+  /// Add a candidate to the batch
+  /// \param input is the input features
+  /// \param candVar is the variable value (e.g. pT) used to select which model to use
+  /// \return index of the candidate in the batch, to be used with getBatchOutput() and isSelectedMlBatch()
+  template <typename T1, typename T2>
+  int addToBatch(const T1& input, const T2& candVar)
+  {
+    return addToBatchModel(input, findBin(candVar));
+  }
+
+  /// Add a candidate to the batch
+  /// \param input is the input features
+  /// \param candVar1 is the first variable value (e.g. pT) used to select which model to use
+  /// \param candVar2 is the second variable value (e.g. multiplicity) used to select which model to use
+  /// \return index of the candidate in the batch, to be used with getBatchOutput() and isSelectedMlBatch()
+  template <typename T1, typename T2, typename T3>
+  int addToBatch(const T1& input, const T2& candVar1, const T3& candVar2)
+  {
+    return addToBatchModel(input, findBin2D(candVar1, candVar2));
+  }
+
+  /// Evaluate the models on all the candidates added to the batch, with one Session::Run per model
+  void evalBatch()
+  {
+    for (auto iModel{0}; iModel < mNModels; ++iModel) {
+      if (mBatchInputs[iModel].empty()) {
+        mBatchOutputs[iModel].clear();
+        continue;
+      }
+      if (mUseNativeModel[iModel]) {
+        mTreeModels[iModel].evalModelBatch(mBatchInputs[iModel], mBatchOutputs[iModel]);
+        if (mValidateNativeModel[iModel]) {
+          validateNativeOutput(mBatchInputs[iModel], mBatchOutputs[iModel], iModel);
+        }
+        continue;
+      }
+      if (!mModels[iModel].template evalModelBatch<TypeOutputScore>(mBatchInputs[iModel], mBatchOutputs[iModel])) {
+        LOG(fatal) << "Batched inference failed for model " << iModel << "!";
+      }
+    }
+  }
+
+  /// Get the model prediction of a candidate in the batch
+  /// \param iCand is the index returned by addToBatch()
+  /// \return pointer to the mNClasses scores of the candidate (valid until the next evalBatch()), nullptr if the candidate is outside the model bins
+  const TypeOutputScore* getBatchOutput(int iCand) const
+  {
+    int nModel = mBatchCandModel[iCand];
+    if (nModel < 0) {
+      return nullptr;
+    }
+    const auto nValues = mUseNativeModel[nModel] ? mTreeModels[nModel].getNumOutputValues() : mModels[nModel].getNumOutputValues();
+    return mBatchOutputs[nModel].data() + mBatchCandRow[iCand] * nValues;
+  }
+
+  /// ML selection of a candidate in the batch
+  /// \param iCand is the index returned by addToBatch()
+  /// \return boolean telling if model predictions pass the cuts (false if the candidate is outside the model bins)
+  bool isSelectedMlBatch(int iCand) const
+  {
+    const TypeOutputScore* output = getBatchOutput(iCand);
+    if (output == nullptr) {
+      return false;
+    }
+    return isSelectedScores(output, mBatchCandModel[iCand]);
+  }
+
+  /// Get the number of candidates for which the native tree-ensemble evaluator and ONNX Runtime disagree
+  /// \return number of mismatches found by the NativeTreeEnsembleValidated backend
+  uint64_t getNumValidationMismatches() const { return mNValidationMismatches; }
+
   /// ML selections
   /// \param input is the input features
   /// \param candVar1 is the first variable value (e.g. pT) used to select which model to use
@@ -282,9 +417,93 @@ class MlResponse
   uint8_t mNVar2Bins = 1;                                 // number of bins of the second variable (e.g. multiplicity) used to select which model to use
   bool mUse2DBinning = false;                             // switch to enable/disable 2D binning
 
+  // buffers for the batched inference
+  std::vector<std::vector<TypeOutputScore>> mBatchInputs;  // features of the candidates in the batch, one contiguous buffer per model
+  std::vector<std::vector<TypeOutputScore>> mBatchOutputs; // scores of the candidates in the batch, one contiguous buffer per model
+  std::vector<int> mBatchCandModel;                        // model used for each candidate in the batch (-1 if outside the bins)
+  std::vector<int> mBatchCandRow;                          // row of each candidate in the buffers of its model
+
+  // native tree-ensemble backend
+  std::vector<o2::ml::TreeEnsembleModel> mTreeModels; // TreeEnsembleModel objects, one for each bin
+  std::vector<int> mBackends = {};                    // o2::ml::InferenceBackend of each model (ONNX Runtime if empty)
+  std::vector<bool> mUseNativeModel = {};             // whether each model is evaluated by the native evaluator
+  std::vector<bool> mValidateNativeModel = {};        // whether the native scores of each model are cross-checked against ONNX Runtime
+  int mValidationPeriod = 100;                        // period (in candidates) of the cross-check
+  float mValidationTolerance = 1.e-4f;                // maximum absolute difference of the scores in the cross-check
+  uint64_t mNValidationCandidates = 0;                // number of candidates seen by the cross-check
+  uint64_t mNValidationMismatches = 0;                // number of candidates with different scores
+
   virtual void setAvailableInputFeatures() { return; } // method to fill the map of available input features
 
  private:
+  /// Adds a candidate to the batch of a given model
+  /// \param input is the input features
+  /// \param nModel is the model index (-1 if the candidate is outside the model bins)
+  /// \return index of the candidate in the batch
+  template <typename T>
+  int addToBatchModel(const T& input, int nModel)
+  {
+    if (mBatchInputs.size() != mNModels) {
+      clearBatch();
+    }
+    int row = -1;
+    if (nModel >= 0) {
+      auto& batchInput = mBatchInputs[nModel];
+      row = batchInput.size() / input.size();
+      batchInput.insert(batchInput.end(), std::begin(input), std::end(input));
+    }
+    mBatchCandModel.push_back(nModel);
+    mBatchCandRow.push_back(row);
+    return mBatchCandModel.size() - 1;
+  }
+
+  /// Cross-checks the scores of the native tree-ensemble evaluator against ONNX Runtime for one candidate every mValidationPeriod
+  /// \param input contains the feature rows of the candidates stored contiguously
+  /// \param output contains the native scores of the candidates
+  /// \param nModel is the model index
+  template <typename T>
+  void validateNativeOutput(const T& input, const std::vector<TypeOutputScore>& output, int nModel)
+  {
+    const std::size_t nFeatures = mTreeModels[nModel].getNumInputNodes();
+    const std::size_t nValues = mTreeModels[nModel].getNumOutputValues();
+    const std::size_t nRows = std::size(input) / nFeatures;
+    std::vector<TypeOutputScore> row(nFeatures);
+    for (std::size_t iRow = 0; iRow < nRows; ++iRow) {
+      if (mNValidationCandidates++ % mValidationPeriod != 0) {
+        continue;
+      }
+      std::copy_n(std::begin(input) + iRow * nFeatures, nFeatures, row.begin());
+      const TypeOutputScore* reference = mModels[nModel].template evalModel<TypeOutputScore>(row);
+      for (std::size_t iValue = 0; iValue < nValues; ++iValue) {
+        const auto difference = std::abs(reference[iValue] - output[iRow * nValues + iValue]);
+        if (!(difference <= mValidationTolerance)) {
+          if (++mNValidationMismatches <= 10) {
+            LOG(warn) << "Native tree-ensemble score " << output[iRow * nValues + iValue] << " different from the ONNX Runtime one " << reference[iValue] << " for class " << iValue << " of model " << nModel;
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  /// Applies the cuts on the model scores
+  /// \param output is a pointer to the mNClasses model scores
+  /// \param nModel is the model index
+  /// \return boolean telling if model predictions pass the cuts
+  bool isSelectedScores(const TypeOutputScore* output, int nModel) const
+  {
+    for (uint8_t iClass{0}; iClass < mNClasses; ++iClass) {
+      uint8_t dir = mCutDir.at(iClass);
+      if (dir == o2::cuts_ml::CutDirection::CutGreater && output[iClass] > mCuts.get(nModel, iClass)) {
+        return false;
+      }
+      if (dir == o2::cuts_ml::CutDirection::CutSmaller && output[iClass] < mCuts.get(nModel, iClass)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   /// Finds matching bin in mBinsLimits
   /// \param value e.g. pT
   /// \return index of the matching bin, used to access mModels
@@ -26,6 +26,7 @@
 #include <onnxruntime_cxx_api.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -58,26 +59,19 @@ class OnnxModel
     // assert(input[0].GetTensorTypeAndShapeInfo().GetShape() == getNumInputNodes()); --> Fails build in debug mode, TODO: assertion should be checked somehow
 
     try {
-      const Ort::RunOptions runOptions;
-      std::vector<const char*> inputNamesChar(mInputNames.size(), nullptr);
-      std::transform(std::begin(mInputNames), std::end(mInputNames), std::begin(inputNamesChar),
-                     [&](const std::string& str) { return str.c_str(); });
-
-      std::vector<const char*> outputNamesChar(mOutputNames.size(), nullptr);
-      std::transform(std::begin(mOutputNames), std::end(mOutputNames), std::begin(outputNamesChar),
-                     [&](const std::string& str) { return str.c_str(); });
-      auto outputTensors = mSession->Run(runOptions, inputNamesChar.data(), input.data(), input.size(), outputNamesChar.data(), outputNamesChar.size());
-      LOG(debug) << "Number of output tensors: " << outputTensors.size();
-      if (outputTensors.size() != mOutputNames.size()) {
-        LOG(fatal) << "Number of output tensors: " << outputTensors.size() << " does not agree with the model specified size: " << mOutputNames.size();
+      // the output tensors are kept until the next evaluation, so that the returned pointer stays valid
+      mOutputTensors = mSession->Run(mRunOptions, mInputNamesChar.data(), input.data(), input.size(), mOutputNamesChar.data(), mOutputNamesChar.size());
+      LOG(debug) << "Number of output tensors: " << mOutputTensors.size();
+      if (mOutputTensors.size() != mOutputNames.size()) {
+        LOG(fatal) << "Number of output tensors: " << mOutputTensors.size() << " does not agree with the model specified size: " << mOutputNames.size();
       }
-      for (std::size_t i = 0; i < outputTensors.size(); i++) {
-        LOG(debug) << "Output tensor shape: " << printShape(outputTensors[i].GetTensorTypeAndShapeInfo().GetShape());
-        if ((outputTensors[i].GetTensorTypeAndShapeInfo().GetShape() != mOutputShapes[i]) && (mOutputShapes[i][0] != -1)) {
-          LOG(fatal) << "Shape of tensor " << i << " does not agree with model specification! Output: " << printShape(outputTensors[i].GetTensorTypeAndShapeInfo().GetShape()) << " model: " << printShape(mOutputShapes[i]);
+      for (std::size_t i = 0; i < mOutputTensors.size(); i++) {
+        LOG(debug) << "Output tensor shape: " << printShape(mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape());
+        if ((mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape() != mOutputShapes[i]) && (mOutputShapes[i][0] != -1)) {
+          LOG(fatal) << "Shape of tensor " << i << " does not agree with model specification! Output: " << printShape(mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape()) << " model: " << printShape(mOutputShapes[i]);
         }
       }
-      T* outputValues = outputTensors.back().GetTensorMutableData<T>();
+      T* outputValues = mOutputTensors.back().GetTensorMutableData<T>();
       return outputValues;
     } catch (const Ort::Exception& exception) {
       LOG(error) << "Error running model inference: " << exception.what();
@@ -92,9 +86,7 @@ class OnnxModel
     assert(size % mInputShapes[0][1] == 0);
     std::vector<int64_t> inputShape{size / mInputShapes[0][1], mInputShapes[0][1]};
     std::vector<Ort::Value> inputTensors;
-    Ort::MemoryInfo memInfo =
-      Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-    inputTensors.emplace_back(Ort::Value::CreateTensor<T>(memInfo, input.data(), size, inputShape.data(), inputShape.size()));
+    inputTensors.emplace_back(Ort::Value::CreateTensor<T>(mMemoryInfo, input.data(), size, inputShape.data(), inputShape.size()));
     LOG(debug) << "Input shape calculated from vector: " << printShape(inputShape);
     return evalModel<T>(inputTensors);
   }
@@ -105,8 +97,6 @@ class OnnxModel
   {
     std::vector<Ort::Value> inputTensors;
 
-    Ort::MemoryInfo memInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-
     for (std::size_t iinput = 0; iinput < input.size(); iinput++) {
       [[maybe_unused]] int totalSize = 1;
       int64_t size = input[iinput].size();
@@ -120,15 +110,55 @@ class OnnxModel
         inputShape.push_back(mInputShapes[iinput][idim]);
       }
 
-      inputTensors.emplace_back(Ort::Value::CreateTensor<T>(memInfo, input[iinput].data(), size, inputShape.data(), inputShape.size()));
+      inputTensors.emplace_back(Ort::Value::CreateTensor<T>(mMemoryInfo, input[iinput].data(), size, inputShape.data(), inputShape.size()));
     }
 
     return evalModel<T>(inputTensors);
   }
 
+  // Batched inference: evaluate nRows = input.size() / getNumInputNodes() candidates with a single Session::Run
+  // The feature rows are stored contiguously in input, and the values of the last output node (nRows x getNumOutputValues())
+  //   are written to output, which is resized if needed. The I/O binding is created once and reused for all the calls
+  template <typename T>
+  bool evalModelBatch(std::vector<T>& input, std::vector<T>& output)
+  {
+    const int64_t nFeatures = mInputShapes[0][1];
+    const int64_t nRows = static_cast<int64_t>(input.size()) / nFeatures;
+    assert(static_cast<int64_t>(input.size()) % nFeatures == 0);
+    const int64_t nValues = getNumOutputValues();
+    output.resize(nRows * nValues);
+    if (nRows == 0) {
+      return true;
+    }
+
+    try {
+      if (!mIoBinding) {
+        mIoBinding = std::make_unique<Ort::IoBinding>(*mSession);
+      }
+      mIoBinding->ClearBoundInputs();
+      mIoBinding->ClearBoundOutputs();
+      std::array<int64_t, 2> inputShape{nRows, nFeatures};
+      Ort::Value inputTensor = Ort::Value::CreateTensor<T>(mMemoryInfo, input.data(), input.size(), inputShape.data(), inputShape.size());
+      mIoBinding->BindInput(mInputNamesChar[0], inputTensor);
+      // the outputs other than the last one (e.g. the predicted labels) are allocated by ONNX Runtime
+      for (std::size_t i = 0; i + 1 < mOutputNamesChar.size(); i++) {
+        mIoBinding->BindOutput(mOutputNamesChar[i], mMemoryInfo);
+      }
+      std::array<int64_t, 2> outputShape{nRows, nValues};
+      Ort::Value outputTensor = Ort::Value::CreateTensor<T>(mMemoryInfo, output.data(), output.size(), outputShape.data(), mOutputShapes.back().size() > 1 ? 2 : 1);
+      mIoBinding->BindOutput(mOutputNamesChar.back(), outputTensor);
+      mSession->Run(mRunOptions, *mIoBinding);
+    } catch (const Ort::Exception& exception) {
+      LOG(error) << "Error running batched model inference: " << exception.what();
+      return false;
+    }
+    return true;
+  }
+
   // Reset session
   void resetSession()
   {
+    mIoBinding.reset();
     mSession.reset(new Ort::Session{*mEnv, modelPath.c_str(), sessionOptions});
   }
 
@@ -141,6 +171,8 @@ class OnnxModel
   int getNumInputNodes() const { return mInputShapes[0][1]; }
   std::vector<std::vector<int64_t>> getInputShapes() const { return mInputShapes; }
   int getNumOutputNodes() const { return mOutputShapes[0][1]; }
+  // number of values per candidate in the last output node (the one returned by evalModel)
+  int64_t getNumOutputValues() const { return mOutputShapes.back().size() > 1 ? mOutputShapes.back()[1] : 1; }
   uint64_t getValidityFrom() const { return validFrom; }
   uint64_t getValidityUntil() const { return validUntil; }
   void setActiveThreads(const int);
@@ -157,6 +189,14 @@ class OnnxModel
   std::vector<std::string> mOutputNames;
   std::vector<std::vector<int64_t>> mOutputShapes;
 
+  // Objects reused in all the evaluations
+  std::vector<const char*> mInputNamesChar;             // pointers to mInputNames, as needed by Session::Run
+  std::vector<const char*> mOutputNamesChar;            // pointers to mOutputNames, as needed by Session::Run
+  Ort::MemoryInfo mMemoryInfo{nullptr};                 // CPU memory info used to create the tensors
+  Ort::RunOptions mRunOptions;                          // run options
+  std::vector<Ort::Value> mOutputTensors;               // output tensors of the last evaluation, owning the values returned by evalModel
+  std::unique_ptr<Ort::IoBinding> mIoBinding = nullptr; // I/O binding used for the batched inference
+
   // Environment settings
   std::string modelPath;
   int activeThreads = 0;
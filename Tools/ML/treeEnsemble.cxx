@@ -0,0 +1,659 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file     treeEnsemble.cxx
+///
+/// \brief    Native evaluator of ONNX TreeEnsembleClassifier models (BDTs), alternative to ONNX Runtime
+///
+
+#include "Tools/ML/treeEnsemble.h"
+
+#include <Framework/Logger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace o2
+{
+
+namespace ml
+{
+
+namespace
+{
+
+// Minimal reader of the protobuf wire format, enough to extract the fields of onnx.proto used below
+class ProtoReader
+{
+ public:
+  enum WireType : uint32_t {
+    Varint = 0,
+    Fixed64 = 1,
+    LengthDelimited = 2,
+    Fixed32 = 5
+  };
+
+  ProtoReader(const char* data, std::size_t size) : mData(data), mEnd(data + size) {}
+
+  bool next(uint32_t& field, uint32_t& wireType)
+  {
+    if (mError || mData >= mEnd) {
+      return false;
+    }
+    const uint64_t tag = readVarint();
+    field = tag >> 3;
+    wireType = tag & 0x7;
+    return !mError;
+  }
+
+  uint64_t readVarint()
+  {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (mData >= mEnd) {
+        mError = true;
+        return 0;
+      }
+      const auto byte = static_cast<uint8_t>(*mData++);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    mError = true;
+    return 0;
+  }
+
+  float readFloat()
+  {
+    float value = 0.f;
+    if (mEnd - mData < 4) {
+      mError = true;
+      return value;
+    }
+    std::memcpy(&value, mData, 4);
+    mData += 4;
+    return value;
+  }
+
+  double readDouble()
+  {
+    double value = 0.;
+    if (mEnd - mData < 8) {
+      mError = true;
+      return value;
+    }
+    std::memcpy(&value, mData, 8);
+    mData += 8;
+    return value;
+  }
+
+  std::string_view readBytes()
+  {
+    const uint64_t size = readVarint();
+    if (mError || static_cast<uint64_t>(mEnd - mData) < size) {
+      mError = true;
+      return {};
+    }
+    std::string_view bytes(mData, size);
+    mData += size;
+    return bytes;
+  }
+
+  ProtoReader readMessage()
+  {
+    const auto bytes = readBytes();
+    return ProtoReader(bytes.data(), bytes.size());
+  }
+
+  void skip(uint32_t wireType)
+  {
+    switch (wireType) {
+      case Varint:
+        readVarint();
+        break;
+      case Fixed64:
+        readDouble();
+        break;
+      case LengthDelimited:
+        readBytes();
+        break;
+      case Fixed32:
+        readFloat();
+        break;
+      default: // groups are not used in onnx.proto
+        mError = true;
+        break;
+    }
+  }
+
+  // repeated float, packed or not
+  void readFloats(uint32_t wireType, std::vector<float>& values)
+  {
+    if (wireType == LengthDelimited) {
+      auto packed = readMessage();
+      while (packed.mData < packed.mEnd && !packed.mError) {
+        values.push_back(packed.readFloat());
+      }
+      mError |= packed.mError;
+    } else {
+      values.push_back(readFloat());
+    }
+  }
+
+  // repeated double, packed or not
+  void readDoubles(uint32_t wireType, std::vector<float>& values)
+  {
+    if (wireType == LengthDelimited) {
+      auto packed = readMessage();
+      while (packed.mData < packed.mEnd && !packed.mError) {
+        values.push_back(static_cast<float>(packed.readDouble()));
+      }
+      mError |= packed.mError;
+    } else {
+      values.push_back(static_cast<float>(readDouble()));
+    }
+  }
+
+  // repeated int64, packed or not
+  void readInts(uint32_t wireType, std::vector<int64_t>& values)
+  {
+    if (wireType == LengthDelimited) {
+      auto packed = readMessage();
+      while (packed.mData < packed.mEnd && !packed.mError) {
+        values.push_back(static_cast<int64_t>(packed.readVarint()));
+      }
+      mError |= packed.mError;
+    } else {
+      values.push_back(static_cast<int64_t>(readVarint()));
+    }
+  }
+
+  bool hasError() const { return mError; }
+
+ private:
+  const char* mData = nullptr;
+  const char* mEnd = nullptr;
+  bool mError = false;
+};
+
+// Attribute of a node (AttributeProto), only the fields needed by the tree ensembles
+struct Attribute {
+  int64_t i = 0;
+  std::string s;
+  std::vector<float> floats;
+  std::vector<int64_t> ints;
+  std::vector<std::string> strings;
+};
+
+struct Node {
+  std::string opType;
+  std::map<std::string, Attribute, std::less<>> attributes;
+};
+
+// Reads the values of a TensorProto (e.g. nodes_values_as_tensor) as floats
+bool readTensor(ProtoReader tensor, std::vector<float>& values)
+{
+  enum TensorField : uint32_t {
+    DataType = 2,
+    FloatData = 4,
+    RawData = 9,
+    DoubleData = 10
+  };
+  int64_t dataType = 0;
+  std::string_view rawData;
+  uint32_t field = 0, wireType = 0;
+  while (tensor.next(field, wireType)) {
+    if (field == DataType) {
+      dataType = tensor.readVarint();
+    } else if (field == FloatData) {
+      tensor.readFloats(wireType, values);
+    } else if (field == DoubleData) {
+      tensor.readDoubles(wireType, values);
+    } else if (field == RawData) {
+      rawData = tensor.readBytes();
+    } else {
+      tensor.skip(wireType);
+    }
+  }
+  if (!rawData.empty()) {
+    ProtoReader raw(rawData.data(), rawData.size());
+    constexpr int64_t kFloat = 1, kDouble = 11; // TensorProto::DataType
+    if (dataType == kFloat) {
+      for (std::size_t i = 0; i < rawData.size() / 4; ++i) {
+        values.push_back(raw.readFloat());
+      }
+    } else if (dataType == kDouble) {
+      for (std::size_t i = 0; i < rawData.size() / 8; ++i) {
+        values.push_back(static_cast<float>(raw.readDouble()));
+      }
+    } else {
+      return false;
+    }
+  }
+  return !tensor.hasError();
+}
+
+bool readAttribute(ProtoReader attribute, std::string& name, Attribute& value)
+{
+  enum AttributeField : uint32_t {
+    Name = 1,
+    F = 2,
+    I = 3,
+    S = 4,
+    T = 5,
+    Floats = 7,
+    Ints = 8,
+    Strings = 9
+  };
+  uint32_t field = 0, wireType = 0;
+  while (attribute.next(field, wireType)) {
+    switch (field) {
+      case Name:
+        name = attribute.readBytes();
+        break;
+      case F:
+        value.floats.push_back(attribute.readFloat());
+        break;
+      case I:
+        value.i = static_cast<int64_t>(attribute.readVarint());
+        break;
+      case S:
+        value.s = attribute.readBytes();
+        break;
+      case T:
+        if (!readTensor(attribute.readMessage(), value.floats)) {
+          return false;
+        }
+        break;
+      case Floats:
+        attribute.readFloats(wireType, value.floats);
+        break;
+      case Ints:
+        attribute.readInts(wireType, value.ints);
+        break;
+      case Strings:
+        value.strings.emplace_back(attribute.readBytes());
+        break;
+      default:
+        attribute.skip(wireType);
+        break;
+    }
+  }
+  return !attribute.hasError();
+}
+
+bool readNode(ProtoReader node, Node& value)
+{
+  enum NodeField : uint32_t {
+    OpType = 4,
+    AttributeList = 5
+  };
+  uint32_t field = 0, wireType = 0;
+  while (node.next(field, wireType)) {
+    if (field == OpType) {
+      value.opType = node.readBytes();
+    } else if (field == AttributeList) {
+      std::string name;
+      Attribute attribute;
+      if (!readAttribute(node.readMessage(), name, attribute)) {
+        return false;
+      }
+      value.attributes[name] = std::move(attribute);
+    } else {
+      node.skip(wireType);
+    }
+  }
+  return !node.hasError();
+}
+
+// Reads the number of features from the shape of the first graph input (ValueInfoProto), -1 if not found
+int64_t readNumFeatures(ProtoReader valueInfo)
+{
+  // ValueInfoProto.type -> TypeProto.tensor_type -> TypeProto.Tensor.shape -> TensorShapeProto.dim -> Dimension.dim_value
+  const std::vector<uint32_t> path{2, 1, 2};
+  uint32_t field = 0, wireType = 0;
+  for (const auto step : path) {
+    bool found = false;
+    while (valueInfo.next(field, wireType)) {
+      if (field == step && wireType == ProtoReader::LengthDelimited) {
+        valueInfo = valueInfo.readMessage();
+        found = true;
+        break;
+      }
+      valueInfo.skip(wireType);
+    }
+    if (!found) {
+      return -1;
+    }
+  }
+  int64_t nFeatures = -1;
+  int iDim = 0;
+  while (valueInfo.next(field, wireType)) {
+    if (field != 1 || wireType != ProtoReader::LengthDelimited) {
+      valueInfo.skip(wireType);
+      continue;
+    }
+    auto dim = valueInfo.readMessage();
+    if (iDim++ != 1) {
+      continue;
+    }
+    while (dim.next(field, wireType)) {
+      if (field == 1) {
+        nFeatures = static_cast<int64_t>(dim.readVarint());
+      } else {
+        dim.skip(wireType);
+      }
+    }
+  }
+  return nFeatures;
+}
+
+} // namespace
+
+bool TreeEnsembleModel::initModel(const std::string& localPath)
+{
+  LOG(info) << "--- Native tree-ensemble model ---";
+
+  std::ifstream file(localPath, std::ios::binary);
+  if (!file) {
+    LOG(error) << "Cannot open model file " << localPath;
+    return false;
+  }
+  const std::vector<char> buffer{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+  // ModelProto.graph -> GraphProto.node and GraphProto.input
+  enum ProtoField : uint32_t {
+    ModelGraph = 7,
+    GraphNode = 1,
+    GraphInput = 11
+  };
+  std::vector<Node> nodes;
+  int64_t nFeatures = -1;
+  bool parseError = false;
+  ProtoReader model(buffer.data(), buffer.size());
+  uint32_t field = 0, wireType = 0;
+  while (model.next(field, wireType)) {
+    if (field != ModelGraph) {
+      model.skip(wireType);
+      continue;
+    }
+    auto graph = model.readMessage();
+    while (graph.next(field, wireType)) {
+      if (field == GraphNode) {
+        nodes.emplace_back();
+        if (!readNode(graph.readMessage(), nodes.back())) {
+          LOG(error) << "Cannot parse the nodes of " << localPath;
+          return false;
+        }
+      } else if (field == GraphInput && nFeatures < 0) {
+        nFeatures = readNumFeatures(graph.readMessage());
+      } else {
+        graph.skip(wireType);
+      }
+    }
+    parseError |= graph.hasError();
+  }
+  if (parseError || model.hasError()) {
+    LOG(error) << "Cannot parse " << localPath << " as an ONNX model";
+    return false;
+  }
+
+  const Node* ensemble = nullptr;
+  for (const auto& node : nodes) {
+    if (node.opType == "TreeEnsembleClassifier") {
+      if (ensemble != nullptr) {
+        LOG(warn) << "More than one TreeEnsembleClassifier in " << localPath << ", not supported by the native tree-ensemble evaluator";
+        return false;
+      }
+      ensemble = &node;
+    } else if (node.opType != "Identity" && node.opType != "Cast") {
+      LOG(warn) << "Operator " << node.opType << " not supported by the native tree-ensemble evaluator";
+      return false;
+    }
+  }
+  if (ensemble == nullptr) {
+    LOG(warn) << "No TreeEnsembleClassifier found in " << localPath;
+    return false;
+  }
+
+  static const Attribute emptyAttribute;
+  auto getAttribute = [ensemble](std::string_view name) -> const Attribute& {
+    auto it = ensemble->attributes.find(name);
+    return it != ensemble->attributes.end() ? it->second : emptyAttribute;
+  };
+  auto getFloats = [&getAttribute](std::string_view name) -> const std::vector<float>& {
+    const auto& values = getAttribute(name).floats;
+    return values.empty() ? getAttribute(std::string(name) + "_as_tensor").floats : values;
+  };
+  const auto& treeIds = getAttribute("nodes_treeids").ints;
+  const auto& nodeIds = getAttribute("nodes_nodeids").ints;
+  const auto& featureIds = getAttribute("nodes_featureids").ints;
+  const auto& thresholds = getFloats("nodes_values");
+  const auto& modes = getAttribute("nodes_modes").strings;
+  const auto& trueIds = getAttribute("nodes_truenodeids").ints;
+  const auto& falseIds = getAttribute("nodes_falsenodeids").ints;
+  const auto& missingTrue = getAttribute("nodes_missing_value_tracks_true").ints;
+  const auto& leafTreeIds = getAttribute("class_treeids").ints;
+  const auto& leafNodeIds = getAttribute("class_nodeids").ints;
+  const auto& leafClassIds = getAttribute("class_ids").ints;
+  const auto& leafWeights = getFloats("class_weights");
+  const auto& baseValues = getFloats("base_values");
+  const std::size_t nLabels = std::max(getAttribute("classlabels_int64s").ints.size(), getAttribute("classlabels_strings").strings.size());
+  const std::string& postTransform = getAttribute("post_transform").s;
+
+  const std::size_t nNodes = nodeIds.size();
+  if (treeIds.size() != nNodes || featureIds.size() != nNodes || thresholds.size() != nNodes || modes.size() != nNodes || trueIds.size() != nNodes || falseIds.size() != nNodes ||
+      (!missingTrue.empty() && missingTrue.size() != nNodes) || leafNodeIds.size() != leafTreeIds.size() || leafClassIds.size() != leafTreeIds.size() || leafWeights.size() != leafTreeIds.size() || nLabels < 2) {
+    LOG(error) << "Inconsistent TreeEnsembleClassifier attributes in " << localPath;
+    return false;
+  }
+
+  if (postTransform.empty() || postTransform == "NONE") {
+    mPostTransform = None;
+  } else if (postTransform == "LOGISTIC") {
+    mPostTransform = Logistic;
+  } else if (postTransform == "SOFTMAX") {
+    mPostTransform = Softmax;
+  } else if (postTransform == "SOFTMAX_ZERO") {
+    mPostTransform = SoftmaxZero;
+  } else {
+    LOG(warn) << "Post transform " << postTransform << " not supported by the native tree-ensemble evaluator";
+    return false;
+  }
+
+  // node index from (tree id, node id)
+  std::map<std::pair<int64_t, int64_t>, int32_t> nodeIndices;
+  mRoots.clear();
+  for (std::size_t iNode = 0; iNode < nNodes; ++iNode) {
+    if (!nodeIndices.emplace(std::make_pair(treeIds[iNode], nodeIds[iNode]), iNode).second) {
+      LOG(error) << "Duplicated node " << nodeIds[iNode] << " in tree " << treeIds[iNode] << " of " << localPath;
+      return false;
+    }
+  }
+  auto findNode = [&nodeIndices](int64_t treeId, int64_t nodeId) -> int32_t {
+    auto it = nodeIndices.find(std::make_pair(treeId, nodeId));
+    return it != nodeIndices.end() ? it->second : -1;
+  };
+
+  mFeatures.assign(nNodes, 0);
+  mThresholds.assign(thresholds.begin(), thresholds.end());
+  mModes.assign(nNodes, Leaf);
+  mMissingTrue.assign(nNodes, 0);
+  mTrueChildren.assign(nNodes, 0);
+  mFalseChildren.assign(nNodes, 0);
+  int64_t maxFeature = -1;
+  const std::vector<std::string> modeNames{"BRANCH_LEQ", "BRANCH_LT", "BRANCH_GTE", "BRANCH_GT", "BRANCH_EQ", "BRANCH_NEQ", "LEAF"};
+  for (std::size_t iNode = 0; iNode < nNodes; ++iNode) {
+    const auto mode = std::find(modeNames.begin(), modeNames.end(), modes[iNode]);
+    if (mode == modeNames.end()) {
+      LOG(warn) << "Node mode " << modes[iNode] << " not supported by the native tree-ensemble evaluator";
+      return false;
+    }
+    mModes[iNode] = std::distance(modeNames.begin(), mode);
+    if (mModes[iNode] == Leaf) {
+      continue;
+    }
+    mFeatures[iNode] = featureIds[iNode];
+    maxFeature = std::max(maxFeature, featureIds[iNode]);
+    mMissingTrue[iNode] = missingTrue.empty() ? 0 : missingTrue[iNode] != 0;
+    mTrueChildren[iNode] = findNode(treeIds[iNode], trueIds[iNode]);
+    mFalseChildren[iNode] = findNode(treeIds[iNode], falseIds[iNode]);
+    if (mTrueChildren[iNode] < 0 || mFalseChildren[iNode] < 0 || featureIds[iNode] < 0) {
+      LOG(error) << "Invalid branch node " << nodeIds[iNode] << " in tree " << treeIds[iNode] << " of " << localPath;
+      return false;
+    }
+  }
+  mNFeatures = nFeatures > maxFeature ? nFeatures : maxFeature + 1;
+
+  // the root of each tree is the node that is not the child of any other node, trees are ordered by id
+  std::vector<bool> isChild(nNodes, false);
+  for (std::size_t iNode = 0; iNode < nNodes; ++iNode) {
+    if (mModes[iNode] != Leaf) {
+      isChild[mTrueChildren[iNode]] = true;
+      isChild[mFalseChildren[iNode]] = true;
+    }
+  }
+  int64_t lastTree = -1;
+  for (const auto& [key, iNode] : nodeIndices) {
+    if (isChild[iNode]) {
+      continue;
+    }
+    if (key.first == lastTree) {
+      LOG(error) << "More than one root in tree " << key.first << " of " << localPath;
+      return false;
+    }
+    mRoots.push_back(iNode);
+    lastTree = key.first;
+  }
+
+  // binary case as in ONNX Runtime: two labels and leaf weights for a single class, aggregated into one score
+  mNClasses = nLabels;
+  const bool binaryCase = nLabels == 2 && std::adjacent_find(leafClassIds.begin(), leafClassIds.end(), std::not_equal_to<>()) == leafClassIds.end();
+  mNScores = binaryCase ? 1 : mNClasses;
+  mWeightsAllPositive = std::all_of(leafWeights.begin(), leafWeights.end(), [](float weight) { return weight >= 0.f; });
+  mBaseValues.assign(mNScores, 0.f);
+  if (binaryCase) {
+    mBaseValues[0] = baseValues.empty() ? 0.f : baseValues.back(); // with two base values, ONNX Runtime uses the second one
+  } else if (nLabels == 2 && baseValues.size() == 2) {
+    LOG(warn) << "Binary classifier with two base values not supported by the native tree-ensemble evaluator";
+    return false;
+  } else {
+    std::copy_n(baseValues.begin(), std::min<std::size_t>(baseValues.size(), mNScores), mBaseValues.begin());
+  }
+
+  // leaf weights sorted by node, the range of each leaf is stored in the children indices
+  std::vector<std::size_t> weightOrder(leafTreeIds.size());
+  std::vector<int32_t> weightNodes(leafTreeIds.size());
+  for (std::size_t iWeight = 0; iWeight < leafTreeIds.size(); ++iWeight) {
+    weightOrder[iWeight] = iWeight;
+    weightNodes[iWeight] = findNode(leafTreeIds[iWeight], leafNodeIds[iWeight]);
+    if (weightNodes[iWeight] < 0 || mModes[weightNodes[iWeight]] != Leaf || leafClassIds[iWeight] < 0 || static_cast<std::size_t>(leafClassIds[iWeight]) >= nLabels) {
+      LOG(error) << "Invalid leaf weight " << iWeight << " in " << localPath;
+      return false;
+    }
+  }
+  std::stable_sort(weightOrder.begin(), weightOrder.end(), [&weightNodes](std::size_t a, std::size_t b) { return weightNodes[a] < weightNodes[b]; });
+  mLeafScoreIndices.clear();
+  mLeafWeights.clear();
+  for (std::size_t iNode = 0; iNode < nNodes; ++iNode) {
+    if (mModes[iNode] == Leaf) {
+      mTrueChildren[iNode] = mFalseChildren[iNode] = 0;
+    }
+  }
+  for (const auto iWeight : weightOrder) {
+    const int32_t node = weightNodes[iWeight];
+    if (mFalseChildren[node] == 0) {
+      mTrueChildren[node] = mFalseChildren[node] = mLeafWeights.size();
+    }
+    mLeafScoreIndices.push_back(binaryCase ? 0 : leafClassIds[iWeight]);
+    mLeafWeights.push_back(leafWeights[iWeight]);
+    ++mFalseChildren[node];
+  }
+  mProbabilities.resize(mNClasses);
+
+  LOG(info) << "Trees: " << mRoots.size() << ", nodes: " << nNodes << ", features: " << mNFeatures << ", classes: " << mNClasses << ", post transform: " << (postTransform.empty() ? "NONE" : postTransform);
+  LOG(info) << "--- Model initialized! ---";
+  return true;
+}
+
+void TreeEnsembleModel::finalizeScores(const float* scores, float* probabilities) const
+{
+  auto logistic = [](float value) { return 1.f / (1.f + std::exp(-value)); };
+
+  if (mNScores == 1) {
+    // binary case, following the conventions of ONNX Runtime for the score of the negative class
+    const float score = scores[0] + mBaseValues[0];
+    if (mWeightsAllPositive) {
+      probabilities[0] = 1.f - score;
+      probabilities[1] = score;
+    } else if (mPostTransform == Logistic) {
+      probabilities[0] = logistic(-score);
+      probabilities[1] = logistic(score);
+    } else if (score > 0.f) {
+      probabilities[0] = -score;
+      probabilities[1] = score;
+    } else {
+      probabilities[0] = score;
+      probabilities[1] = -score;
+    }
+    return;
+  }
+
+  for (int iClass = 0; iClass < mNClasses; ++iClass) {
+    probabilities[iClass] = scores[iClass] + mBaseValues[iClass];
+  }
+  switch (mPostTransform) {
+    case Logistic:
+      for (int iClass = 0; iClass < mNClasses; ++iClass) {
+        probabilities[iClass] = logistic(probabilities[iClass]);
+      }
+      break;
+    case Softmax:
+    case SoftmaxZero: {
+      // with SOFTMAX_ZERO, the classes with a null score keep a null probability
+      const bool skipZeros = mPostTransform == SoftmaxZero;
+      const float maxScore = *std::max_element(probabilities, probabilities + mNClasses);
+      float sum = 0.f;
+      for (int iClass = 0; iClass < mNClasses; ++iClass) {
+        if (skipZeros && probabilities[iClass] == 0.f) {
+          continue;
+        }
+        probabilities[iClass] = std::exp(probabilities[iClass] - maxScore);
+        sum += probabilities[iClass];
+      }
+      if (sum > 0.f) {
+        for (int iClass = 0; iClass < mNClasses; ++iClass) {
+          probabilities[iClass] /= sum;
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+} // namespace ml
+
+} // namespace o2
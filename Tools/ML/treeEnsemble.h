@@ -0,0 +1,180 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file     treeEnsemble.h
+///
+/// \brief    Native evaluator of ONNX TreeEnsembleClassifier models (BDTs), alternative to ONNX Runtime
+///
+
+#ifndef TOOLS_ML_TREEENSEMBLE_H_
+#define TOOLS_ML_TREEENSEMBLE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace o2
+{
+
+namespace ml
+{
+
+// inference backend of a model
+enum InferenceBackend {
+  OnnxRuntime = 0,            // ONNX Runtime session (default)
+  NativeTreeEnsemble,         // native tree-ensemble evaluator, falls back to ONNX Runtime for unsupported models
+  NativeTreeEnsembleValidated // native tree-ensemble evaluator, with scores cross-checked against ONNX Runtime
+};
+
+/// The ai.onnx.ml TreeEnsembleClassifier node of an .onnx file is read directly from the protobuf and
+///   compiled into flat node arrays, which are traversed tree by tree for blocks of candidates.
+/// The scores follow the conventions of the ONNX Runtime kernel (base values, binary case, post transform),
+///   so that the same cuts can be applied. Only graphs made of one TreeEnsembleClassifier node (plus Identity/Cast nodes)
+///   with post_transform NONE, LOGISTIC, SOFTMAX or SOFTMAX_ZERO are supported: initModel() returns false otherwise
+class TreeEnsembleModel
+{
+
+ public:
+  TreeEnsembleModel() = default;
+  ~TreeEnsembleModel() = default;
+
+  enum PostTransform : uint8_t {
+    None = 0,
+    Logistic,
+    Softmax,
+    SoftmaxZero
+  };
+
+  enum NodeMode : uint8_t {
+    BranchLeq = 0,
+    BranchLt,
+    BranchGte,
+    BranchGt,
+    BranchEq,
+    BranchNeq,
+    Leaf
+  };
+
+  /// Reads and compiles the model
+  /// \param localPath is the path of the .onnx file
+  /// \return false if the file cannot be read or the model is not supported
+  bool initModel(const std::string& localPath);
+
+  /// Evaluates nRows = input.size() / getNumInputNodes() candidates
+  /// \param input contains the feature rows of the candidates stored contiguously
+  /// \param output is filled with the nRows x getNumOutputValues() scores (resized if needed)
+  template <typename TIn, typename TOut>
+  void evalModelBatch(const std::vector<TIn>& input, std::vector<TOut>& output)
+  {
+    assert(input.size() % mNFeatures == 0);
+    const std::size_t nRows = input.size() / mNFeatures;
+    output.resize(nRows * mNClasses);
+    mScores.resize(kBlockSize * mNScores);
+
+    for (std::size_t firstRow = 0; firstRow < nRows; firstRow += kBlockSize) {
+      const std::size_t nBlockRows = std::min(kBlockSize, nRows - firstRow);
+      std::fill(mScores.begin(), mScores.begin() + nBlockRows * mNScores, 0.f);
+      // tree-major traversal: the nodes of a tree stay in cache while all the rows of the block go through it
+      for (const auto root : mRoots) {
+        for (std::size_t iRow = 0; iRow < nBlockRows; ++iRow) {
+          const TIn* features = input.data() + (firstRow + iRow) * mNFeatures;
+          int32_t node = root;
+          while (mModes[node] != Leaf) {
+            const float value = static_cast<float>(features[mFeatures[node]]);
+            node = isTrueBranch(node, value) ? mTrueChildren[node] : mFalseChildren[node];
+          }
+          float* scores = mScores.data() + iRow * mNScores;
+          for (int32_t iWeight = mTrueChildren[node]; iWeight < mFalseChildren[node]; ++iWeight) {
+            scores[mLeafScoreIndices[iWeight]] += mLeafWeights[iWeight];
+          }
+        }
+      }
+      for (std::size_t iRow = 0; iRow < nBlockRows; ++iRow) {
+        finalizeScores(mScores.data() + iRow * mNScores, mProbabilities.data());
+        for (int iClass = 0; iClass < mNClasses; ++iClass) {
+          output[(firstRow + iRow) * mNClasses + iClass] = static_cast<TOut>(mProbabilities[iClass]);
+        }
+      }
+    }
+  }
+
+  // Getters
+  int getNumInputNodes() const { return mNFeatures; }
+  int64_t getNumOutputValues() const { return mNClasses; }
+  std::size_t getNumTrees() const { return mRoots.size(); }
+  std::size_t getNumNodes() const { return mModes.size(); }
+
+ private:
+  static constexpr std::size_t kBlockSize = 256; // number of candidates traversing the trees together
+
+  // flattened nodes of all the trees
+  std::vector<int32_t> mFeatures;      // feature index of the split
+  std::vector<float> mThresholds;      // threshold of the split
+  std::vector<uint8_t> mModes;         // NodeMode of the split
+  std::vector<uint8_t> mMissingTrue;   // whether NaN features follow the true branch
+  std::vector<int32_t> mTrueChildren;  // true branch, or first weight of the leaf
+  std::vector<int32_t> mFalseChildren; // false branch, or end of the weights of the leaf
+  std::vector<int32_t> mRoots;         // index of the root node of each tree
+
+  // leaf weights, accessed through the indices stored in the leaf nodes
+  std::vector<int32_t> mLeafScoreIndices; // score to which the weight is added
+  std::vector<float> mLeafWeights;        // weight
+
+  // score conventions
+  std::vector<float> mBaseValues;      // base values added to the scores
+  int mNFeatures = 0;                  // number of input features
+  int mNClasses = 0;                   // number of output probabilities
+  int mNScores = 0;                    // number of aggregated scores (1 in the binary case, mNClasses otherwise)
+  bool mWeightsAllPositive = true;     // binary case with only positive leaf weights (e.g. random forests)
+  PostTransform mPostTransform = None; // transformation of the aggregated scores
+  std::vector<float> mScores;          // aggregated scores of a block of candidates
+  std::vector<float> mProbabilities;   // output of finalizeScores
+
+  bool isTrueBranch(int32_t node, float value) const
+  {
+    const float threshold = mThresholds[node];
+    bool isTrue = false;
+    switch (mModes[node]) {
+      case BranchLeq:
+        isTrue = value <= threshold;
+        break;
+      case BranchLt:
+        isTrue = value < threshold;
+        break;
+      case BranchGte:
+        isTrue = value >= threshold;
+        break;
+      case BranchGt:
+        isTrue = value > threshold;
+        break;
+      case BranchEq:
+        isTrue = value == threshold;
+        break;
+      default:
+        isTrue = value != threshold;
+        break;
+    }
+    return isTrue || (mMissingTrue[node] && std::isnan(value));
+  }
+
+  void finalizeScores(const float* scores, float* probabilities) const;
+};
+
+} // namespace ml
+
+} // namespace o2
+
+#endif // TOOLS_ML_TREEENSEMBLE_H_